@@ -1,5 +1,8 @@
 #include "actions.h"
 
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,40 +11,32 @@
 
 #include "appmap.h"
 #include "hyprctl.h"
+#include "match.h"
 #include "rules.h"
 #include "util.h"
 
 int rule_matches_client(const struct rule *r, const struct client *c) {
-    if (r->match.class_re) {
-        if (!c->class_name || !regex_match(r->match.class_re, c->class_name)) {
-            return 0;
-        }
-    }
-    if (r->match.title_re) {
-        if (!c->title || !regex_match(r->match.title_re, c->title)) {
-            return 0;
-        }
-    }
-    if (r->match.initial_class_re) {
-        if (!c->initial_class || !regex_match(r->match.initial_class_re, c->initial_class)) {
-            return 0;
-        }
-    }
-    if (r->match.initial_title_re) {
-        if (!c->initial_title || !regex_match(r->match.initial_title_re, c->initial_title)) {
-            return 0;
-        }
-    }
-    /* tag matching skipped — hyprctl doesn't expose window tags,
-       so we can't check match:tag; treat it as always matching
-       to avoid falsely marking rules as unused */
-    return 1;
+    /* one-off check; loops over many windows should keep the program */
+    struct match_prog p;
+    if (match_compile(&p, r) != 0) return 0;
+    int hit = match_eval(&p, c);
+    match_free(&p);
+    return hit;
+}
+
+int rule_matches_any_client(const struct rule *r, const struct clients *cl) {
+    struct match_prog p;
+    if (match_compile(&p, r) != 0) return 0;
+    int hit = 0;
+    for (size_t i = 0; i < cl->count && !hit; i++) hit = match_eval(&p, &cl->items[i]);
+    match_free(&p);
+    return hit;
 }
 
 /* check if any rule matches a class pattern (simple substring check) */
 static int rules_cover_class(const struct ruleset *rules, const char *class_name) {
     for (size_t i = 0; i < rules->count; i++) {
-        const char *re = rules->rules[i].match.class_re;
+        const char *re = rule_get(&rules->rules[i], RF_CLASS);
         if (!re) continue;
         if (strcasestr(re, class_name)) return 1;
     }
@@ -157,3 +152,157 @@ int find_missing_rules(const char *rules_path, const char *appmap_path,
     ruleset_free(&rules);
     return 0;
 }
+
+/* --- apply rules to live windows --- */
+
+struct req_buf {
+    char *data;
+    size_t len, cap;
+};
+
+static int req_appendf(struct req_buf *b, const char *fmt, ...) {
+    va_list args;
+    for (;;) {
+        size_t avail = b->cap - b->len;
+        va_start(args, fmt);
+        int n = vsnprintf(b->data ? b->data + b->len : NULL, b->data ? avail : 0, fmt, args);
+        va_end(args);
+        if (n < 0) return -1;
+        if (b->data && (size_t)n < avail) {
+            b->len += (size_t)n;
+            return 0;
+        }
+        size_t cap = b->cap ? b->cap : 1024;
+        while (cap - b->len <= (size_t)n) cap *= 2;
+        char *next = realloc(b->data, cap);
+        if (!next) return -1;
+        b->data = next;
+        b->cap = cap;
+    }
+}
+
+/* batch commands are ';'-separated, so values carrying one are not sent */
+static int safe_arg(const char *s) {
+    return s && s[0] && !strpbrk(s, ";\n");
+}
+
+static int emit_rule(struct req_buf *b, const struct rule *r, const struct client *c,
+                     int *floating, size_t *commands) {
+    const char *addr = c->address;
+    const char *v;
+
+    if (safe_arg(v = rule_get(r, RF_WORKSPACE))) {
+        /* "3 silent" -> "3": the dispatcher is already the silent variant */
+        char ws[64];
+        snprintf(ws, sizeof(ws), "%s", v);
+        char *sp = strstr(ws, " silent");
+        if (sp) *sp = '\0';
+        if (req_appendf(b, ";dispatch movetoworkspacesilent %s,address:%s", ws, addr)) return -1;
+        (*commands)++;
+    }
+    if (rule_has(r, RF_FLOAT) && rule_get_bool(r, RF_FLOAT) != *floating) {
+        *floating = rule_get_bool(r, RF_FLOAT);
+        if (req_appendf(b, ";dispatch %s address:%s", *floating ? "setfloating" : "settiled", addr)) return -1;
+        (*commands)++;
+    }
+    if (safe_arg(v = rule_get(r, RF_SIZE))) {
+        if (req_appendf(b, ";dispatch resizewindowpixel exact %s,address:%s", v, addr)) return -1;
+        (*commands)++;
+    }
+    if (safe_arg(v = rule_get(r, RF_MOVE))) {
+        if (req_appendf(b, ";dispatch movewindowpixel exact %s,address:%s", v, addr)) return -1;
+        (*commands)++;
+    }
+    if (safe_arg(v = rule_get(r, RF_OPACITY))) {
+        /* "active [inactive]" */
+        char active[32] = "", inactive[32] = "";
+        sscanf(v, "%31s %31s", active, inactive);
+        if (req_appendf(b, ";dispatch setprop address:%s alpha %s", addr, active)) return -1;
+        (*commands)++;
+        if (inactive[0] && (isdigit((unsigned char)inactive[0]) || inactive[0] == '.')) {
+            if (req_appendf(b, ";dispatch setprop address:%s alphainactive %s", addr, inactive)) return -1;
+            (*commands)++;
+        }
+    }
+    if (safe_arg(v = rule_get(r, RF_TAG))) {
+        if (req_appendf(b, ";dispatch tagwindow %s address:%s", v, addr)) return -1;
+        (*commands)++;
+    }
+    return 0;
+}
+
+static void free_progs(struct match_prog *progs, size_t n) {
+    for (size_t k = 0; k < n; k++) match_free(&progs[k]);
+    free(progs);
+}
+
+int live_apply_build(const struct ruleset *rs, const int *idx, size_t n,
+                     const struct clients *cl, struct live_apply *out) {
+    memset(out, 0, sizeof(*out));
+    struct req_buf b = {0};
+    if (req_appendf(&b, "[[BATCH]]")) return -1;
+
+    const uint32_t window_match = RF_BIT(RF_CLASS) | RF_BIT(RF_TITLE) |
+                                  RF_BIT(RF_INITIAL_CLASS) | RF_BIT(RF_INITIAL_TITLE);
+
+    /* compile each selected rule once, not once per window */
+    struct match_prog *progs = calloc(n ? n : 1, sizeof(struct match_prog));
+    if (!progs) {
+        free(b.data);
+        return -1;
+    }
+    for (size_t k = 0; k < n; k++) {
+        if (match_compile(&progs[k], &rs->rules[idx[k]]) != 0) {
+            free_progs(progs, k);
+            free(b.data);
+            return -1;
+        }
+    }
+
+    for (size_t ci = 0; ci < cl->count; ci++) {
+        const struct client *c = &cl->items[ci];
+        if (!safe_arg(c->address)) continue;
+
+        int floating = c->floating;
+        size_t before = out->commands;
+        for (size_t k = 0; k < n; k++) {
+            const struct rule *r = &rs->rules[idx[k]];
+            /* a rule without window matchers would hit every open window */
+            if (!(r->present & window_match)) continue;
+            if (!match_eval(&progs[k], c)) continue;
+            if (emit_rule(&b, r, c, &floating, &out->commands) != 0) {
+                free_progs(progs, n);
+                free(b.data);
+                memset(out, 0, sizeof(*out));
+                return -1;
+            }
+        }
+        if (out->commands > before) out->windows++;
+    }
+    free_progs(progs, n);
+
+    /* drop the separator in front of the first command */
+    if (b.len > 9 && b.data[9] == ';') memmove(b.data + 9, b.data + 10, b.len - 9);
+    out->request = b.data;
+    return 0;
+}
+
+size_t live_apply_failures(const char *reply, size_t commands) {
+    /* replies are concatenated, separated by blank lines */
+    size_t ok = 0;
+    const char *p = reply;
+    while (p && *p) {
+        const char *end = strstr(p, "\n\n");
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        while (len > 0 && isspace((unsigned char)*p)) { p++; len--; }
+        while (len > 0 && isspace((unsigned char)p[len - 1])) len--;
+        if (len == 2 && strncmp(p, "ok", 2) == 0) ok++;
+        p = end ? end + 2 : NULL;
+    }
+    return ok >= commands ? 0 : commands - ok;
+}
+
+void live_apply_free(struct live_apply *la) {
+    free(la->request);
+    memset(la, 0, sizeof(*la));
+}
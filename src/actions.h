@@ -20,9 +20,26 @@ struct missing_rules {
 };
 
 int rule_matches_client(const struct rule *r, const struct client *c);
+/* compiles the rule once for the whole list */
+int rule_matches_any_client(const struct rule *r, const struct clients *cl);
 
 int find_missing_rules(const char *rules_path, const char *appmap_path,
                        const char *dotfiles_path, struct missing_rules *out);
 void missing_rules_free(struct missing_rules *mr);
 
+/* one [[BATCH]] command-socket request that applies rules to open windows */
+struct live_apply {
+    char *request;
+    size_t commands;
+    size_t windows;
+};
+
+/* collect the dispatchers for rs->rules[idx[0..n)] (applied in that order) on
+ * every client they match; rules without a class/title match are skipped */
+int live_apply_build(const struct ruleset *rs, const int *idx, size_t n,
+                     const struct clients *cl, struct live_apply *out);
+/* number of commands in a batch reply that did not answer "ok" */
+size_t live_apply_failures(const char *reply, size_t commands);
+void live_apply_free(struct live_apply *la);
+
 #endif
@@ -0,0 +1,273 @@
+#include "diff.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "merge.h"
+
+/* --- Myers O(ND), linear space --- */
+
+struct myers {
+    const int *a, *b;
+    unsigned char *match;  /* per a position: part of the common subsequence */
+    int *vf, *vb;          /* furthest x per diagonal, forward and backward */
+};
+
+/* find a point on an optimal path through a[0..n) x b[0..m); returns 0
+ * when the two ranges share nothing */
+static int myers_bisect(struct myers *my, const int *a, int n, const int *b, int m,
+                        int *sx, int *sy) {
+    int max_d = (n + m + 1) / 2;
+    int off = max_d, len = 2 * max_d + 2;
+    int *vf = my->vf, *vb = my->vb;
+    for (int i = 0; i < len; i++) vf[i] = vb[i] = -1;
+    vf[off + 1] = 0;
+    vb[off + 1] = 0;
+
+    int delta = n - m;
+    int front = delta & 1; /* odd delta: paths meet on a forward step */
+    int kf_lo = 0, kf_hi = 0, kb_lo = 0, kb_hi = 0;
+
+    for (int d = 0; d < max_d; d++) {
+        for (int k = -d + kf_lo; k <= d - kf_hi; k += 2) {
+            int ko = off + k;
+            int x = (k == -d || (k != d && vf[ko - 1] < vf[ko + 1])) ? vf[ko + 1] : vf[ko - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) { x++; y++; }
+            vf[ko] = x;
+            if (x > n) {
+                kf_hi += 2;
+            } else if (y > m) {
+                kf_lo += 2;
+            } else if (front) {
+                int kbo = off + delta - k;
+                if (kbo >= 0 && kbo < len && vb[kbo] != -1 && x >= n - vb[kbo]) {
+                    *sx = x;
+                    *sy = y;
+                    return 1;
+                }
+            }
+        }
+        for (int k = -d + kb_lo; k <= d - kb_hi; k += 2) {
+            int ko = off + k;
+            int x = (k == -d || (k != d && vb[ko - 1] < vb[ko + 1])) ? vb[ko + 1] : vb[ko - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[n - 1 - x] == b[m - 1 - y]) { x++; y++; }
+            vb[ko] = x;
+            if (x > n) {
+                kb_hi += 2;
+            } else if (y > m) {
+                kb_lo += 2;
+            } else if (!front) {
+                int kfo = off + delta - k;
+                if (kfo >= 0 && kfo < len && vf[kfo] != -1 && vf[kfo] >= n - x) {
+                    *sx = vf[kfo];
+                    *sy = vf[kfo] - (kfo - off);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static void myers_rec(struct myers *my, int a0, int a1, int b0, int b1) {
+    while (a0 < a1 && b0 < b1 && my->a[a0] == my->b[b0]) {
+        my->match[a0++] = 1;
+        b0++;
+    }
+    while (a0 < a1 && b0 < b1 && my->a[a1 - 1] == my->b[b1 - 1]) {
+        my->match[--a1] = 1;
+        b1--;
+    }
+    if (a0 == a1 || b0 == b1) return;
+
+    int x, y;
+    if (!myers_bisect(my, my->a + a0, a1 - a0, my->b + b0, b1 - b0, &x, &y)) return;
+    myers_rec(my, a0, a0 + x, b0, b0 + y);
+    myers_rec(my, a0 + x, a1, b0 + y, b1);
+}
+
+/* --- identity alignment --- */
+
+struct id_slot {
+    uint64_t key;
+    int idx;  /* -1 = empty */
+};
+
+static size_t id_hash(uint64_t k, size_t mask) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    return (size_t)k & mask;
+}
+
+uint32_t rule_changed_fields(const struct rule *a, const struct rule *b) {
+    uint32_t changed = 0;
+    for (int f = 0; f < RF_COUNT; f++) {
+        if (f == RF_DISPLAY_NAME) continue;
+        int ha = rule_has(a, f), hb = rule_has(b, f);
+        if (ha != hb) {
+            changed |= RF_BIT(f);
+        } else if (ha) {
+            int same = f >= RF_FLOAT ? rule_get_bool(a, f) == rule_get_bool(b, f)
+                                     : strcmp(rule_get(a, f), rule_get(b, f)) == 0;
+            if (!same) changed |= RF_BIT(f);
+        }
+    }
+    int extras_same = a->extras_count == b->extras_count;
+    for (size_t j = 0; extras_same && j < a->extras_count; j++)
+        extras_same = strcmp(a->extras[j].key, b->extras[j].key) == 0 &&
+                      strcmp(a->extras[j].value, b->extras[j].value) == 0;
+    if (!extras_same) changed |= DIFF_EXTRAS;
+    return changed;
+}
+
+int rule_diff(const struct ruleset *a, const struct ruleset *b, struct rule_diff *out) {
+    memset(out, 0, sizeof(*out));
+    size_t na = a->count, nb = b->count;
+    size_t cap = 16;
+    while (cap < nb * 2) cap <<= 1;
+
+    uint64_t *ka = malloc((na ? na : 1) * sizeof(uint64_t));
+    uint64_t *kb = malloc((nb ? nb : 1) * sizeof(uint64_t));
+    struct id_slot *tab = malloc(cap * sizeof(*tab));
+    int *a_in_b = malloc((na ? na : 1) * sizeof(int));  /* b index of the same identity */
+    int *b_in_a = malloc((nb ? nb : 1) * sizeof(int));
+    int *seq_a = malloc((na ? na : 1) * sizeof(int));   /* shared rules as b indices */
+    int *seq_b = malloc((nb ? nb : 1) * sizeof(int));
+    unsigned char *match = calloc(na ? na : 1, 1);
+    unsigned char *kept_b = calloc(nb ? nb : 1, 1);
+    size_t vlen = na + nb + 4;
+    int *vf = malloc(vlen * sizeof(int));
+    int *vb = malloc(vlen * sizeof(int));
+    out->entries = malloc((na + nb ? na + nb : 1) * sizeof(struct diff_entry));
+    int rc = -1;
+    if (!ka || !kb || !tab || !a_in_b || !b_in_a || !seq_a || !seq_b || !match ||
+        !kept_b || !vf || !vb || !out->entries)
+        goto done;
+    if (merge_identities(a, ka) != 0 || merge_identities(b, kb) != 0) goto done;
+
+    /* pair identities; identities are unique per side after numbering */
+    for (size_t i = 0; i < cap; i++) tab[i].idx = -1;
+    for (size_t j = 0; j < nb; j++) {
+        size_t s = id_hash(kb[j], cap - 1);
+        while (tab[s].idx >= 0) s = (s + 1) & (cap - 1);
+        tab[s].key = kb[j];
+        tab[s].idx = (int)j;
+        b_in_a[j] = -1;
+    }
+    int ns_a = 0, ns_b = 0;
+    for (size_t i = 0; i < na; i++) {
+        size_t s = id_hash(ka[i], cap - 1);
+        while (tab[s].idx >= 0 && tab[s].key != ka[i]) s = (s + 1) & (cap - 1);
+        a_in_b[i] = tab[s].idx;
+        if (tab[s].idx >= 0) b_in_a[tab[s].idx] = (int)i;
+    }
+    for (size_t i = 0; i < na; i++)
+        if (a_in_b[i] >= 0) seq_a[ns_a++] = a_in_b[i];
+    for (size_t j = 0; j < nb; j++)
+        if (b_in_a[j] >= 0) seq_b[ns_b++] = (int)j;
+
+    /* longest common subsequence of the shared rules */
+    struct myers my = {seq_a, seq_b, match, vf, vb};
+    myers_rec(&my, 0, ns_a, 0, ns_b);
+    for (int i = 0; i < ns_a; i++)
+        if (match[i]) kept_b[seq_a[i]] = 1;
+
+    /* walk both sides in step: removals surface at their a position,
+     * everything else at its b position */
+    size_t i = 0, j = 0, n = 0;
+    while (i < na || j < nb) {
+        struct diff_entry *e = &out->entries[n];
+        if (i < na && (a_in_b[i] < 0 || !kept_b[a_in_b[i]])) {
+            /* shared rules that moved are reported where b has them */
+            if (a_in_b[i] < 0) {
+                *e = (struct diff_entry){DIFF_REMOVED, (int)i, -1, 0};
+                out->removed++;
+                n++;
+            }
+            i++;
+            continue;
+        }
+        if (j < nb && !kept_b[j]) {
+            if (b_in_a[j] < 0) {
+                *e = (struct diff_entry){DIFF_ADDED, -1, (int)j, 0};
+                out->added++;
+            } else {
+                *e = (struct diff_entry){DIFF_MOVED, b_in_a[j], (int)j, 0};
+                out->moved++;
+            }
+        } else {
+            *e = (struct diff_entry){DIFF_KEPT, (int)i++, (int)j, 0};
+        }
+        n++;
+        j++;
+        if (e->op != DIFF_ADDED) {
+            const struct rule *ra = &a->rules[e->a], *rb = &b->rules[e->b];
+            if (rule_fingerprint(ra) != rule_fingerprint(rb))
+                e->changed = rule_changed_fields(ra, rb);
+            if (e->changed) out->changed++;
+            else if (e->op == DIFF_KEPT) out->unchanged++;
+        }
+    }
+    out->count = n;
+    rc = 0;
+
+done:
+    free(ka);
+    free(kb);
+    free(tab);
+    free(a_in_b);
+    free(b_in_a);
+    free(seq_a);
+    free(seq_b);
+    free(match);
+    free(kept_b);
+    free(vf);
+    free(vb);
+    if (rc != 0) rule_diff_free(out);
+    return rc;
+}
+
+void rule_diff_free(struct rule_diff *d) {
+    if (!d) return;
+    free(d->entries);
+    memset(d, 0, sizeof(*d));
+}
+
+/* --- output --- */
+
+char diff_format_entry(const struct ruleset *a, const struct ruleset *b,
+                       const struct diff_entry *e, char *buf, size_t sz) {
+    const struct rule *r = e->b >= 0 ? &b->rules[e->b] : &a->rules[e->a];
+    char mark = e->op == DIFF_ADDED ? '+' : e->op == DIFF_REMOVED ? '-' :
+                e->op == DIFF_MOVED ? '>' : e->changed ? '~' : ' ';
+    int len = snprintf(buf, sz, "%c %s", mark, rule_label_or(r, "(unnamed)"));
+
+    if (e->op == DIFF_MOVED && len >= 0 && (size_t)len < sz)
+        len += snprintf(buf + len, sz - (size_t)len, "  (moved %d -> %d)", e->a + 1, e->b + 1);
+
+    const char *sep = ": ";
+    for (int f = 0; f <= RF_COUNT && e->changed; f++) {
+        if (!(e->changed & RF_BIT(f)) || len < 0 || (size_t)len >= sz) continue;
+        const char *key = f == RF_COUNT ? "other fields" : rule_field_key(f);
+        if (!key) continue;
+        len += snprintf(buf + len, sz - (size_t)len, "%s%s", sep, key);
+        sep = ", ";
+    }
+    return mark;
+}
+
+void rule_diff_print(FILE *f, const struct ruleset *a, const struct ruleset *b,
+                     const struct rule_diff *d) {
+    char line[512];
+    for (size_t i = 0; i < d->count; i++) {
+        const struct diff_entry *e = &d->entries[i];
+        if (e->op == DIFF_KEPT && !e->changed) continue;
+        diff_format_entry(a, b, e, line, sizeof(line));
+        fprintf(f, "%s\n", line);
+    }
+    fprintf(f, "%zu added, %zu removed, %zu moved, %zu changed, %zu unchanged\n",
+            d->added, d->removed, d->moved, d->changed, d->unchanged);
+}
@@ -0,0 +1,53 @@
+#ifndef HYPRWINDOWS_DIFF_H
+#define HYPRWINDOWS_DIFF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "rules.h"
+
+/*
+ * Rule-level diff of two rulesets.
+ *
+ * Rules are aligned by identity (see merge_identities). Identities only
+ * one side has are plain additions or removals; the rest go through a
+ * linear-space O(ND) diff (Myers), which leaves D small unless rules
+ * were reordered. Shared rules that fall outside the longest common
+ * subsequence are reported as moved. Kept and moved rules whose contents
+ * differ carry a mask of the changed fields.
+ */
+
+enum diff_op { DIFF_KEPT, DIFF_ADDED, DIFF_REMOVED, DIFF_MOVED };
+
+/* diff_entry.changed bit for the unknown key/value fields */
+#define DIFF_EXTRAS RF_BIT(RF_COUNT)
+
+struct diff_entry {
+    enum diff_op op;
+    int a, b;          /* index in each ruleset, -1 when absent */
+    uint32_t changed;  /* RF_BIT(field) | DIFF_EXTRAS for differing content */
+};
+
+struct rule_diff {
+    struct diff_entry *entries;  /* in b order, removals at their a position */
+    size_t count;
+    size_t added, removed, moved, changed, unchanged;
+};
+
+int rule_diff(const struct ruleset *a, const struct ruleset *b, struct rule_diff *out);
+void rule_diff_free(struct rule_diff *d);
+
+/* fields whose value differs between two rules */
+uint32_t rule_changed_fields(const struct rule *a, const struct rule *b);
+
+/* one-line description of an entry ("~ firefox: workspace, float");
+ * returns the leading marker character */
+char diff_format_entry(const struct ruleset *a, const struct ruleset *b,
+                       const struct diff_entry *e, char *buf, size_t sz);
+
+/* print every non-kept entry and a summary line */
+void rule_diff_print(FILE *f, const struct ruleset *a, const struct ruleset *b,
+                     const struct rule_diff *d);
+
+#endif
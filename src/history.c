@@ -3,6 +3,28 @@
 #include <string.h>
 #include <stdio.h>
 
+static void record_free(struct change_record *rec) {
+    rule_free(&rec->old_state);
+    rule_free(&rec->new_state);
+    for (size_t i = 0; i < rec->item_count; i++)
+        record_free(&rec->items[i]);
+    free(rec->items);
+    rec->items = NULL;
+    rec->item_count = 0;
+}
+
+static void fill_record(struct change_record *rec, enum change_type type, int rule_index,
+                        const struct rule *old_state, const struct rule *new_state,
+                        const char *description) {
+    memset(rec, 0, sizeof(*rec));
+    rec->type = type;
+    rec->rule_index = rule_index;
+    rec->old_state = rule_copy(old_state);
+    rec->new_state = rule_copy(new_state);
+    rec->timestamp = time(NULL);
+    snprintf(rec->description, sizeof(rec->description), "%s", description);
+}
+
 void history_init(struct history_stack *h) {
     if (!h) return;
     memset(h, 0, sizeof(struct history_stack));
@@ -10,38 +32,84 @@ void history_init(struct history_stack *h) {
     h->records = calloc(h->capacity, sizeof(struct change_record));
 }
 
-void history_record(struct history_stack *h, enum change_type type, int rule_index,
-                    const struct rule *old_state, const struct rule *new_state,
-                    const char *description) {
-    if (!h || !h->records) return;
-
+/* drop the redo stack and make room for one more record; returns the free slot */
+static struct change_record *push_slot(struct history_stack *h) {
     /* clear redo stack */
-    for (size_t i = h->current; i < h->count; i++) {
-        rule_free(&h->records[i].old_state);
-        rule_free(&h->records[i].new_state);
-    }
+    for (size_t i = h->current; i < h->count; i++)
+        record_free(&h->records[i]);
     h->count = h->current;
 
     /* shift if at capacity */
     if (h->count >= h->capacity) {
-        rule_free(&h->records[0].old_state);
-        rule_free(&h->records[0].new_state);
+        record_free(&h->records[0]);
         memmove(&h->records[0], &h->records[1],
                 (h->capacity - 1) * sizeof(struct change_record));
         h->count = h->capacity - 1;
         h->current = h->capacity - 1;
     }
 
-    struct change_record *rec = &h->records[h->count];
-    rec->type = type;
-    rec->rule_index = rule_index;
-    rec->old_state = rule_copy(old_state);
-    rec->new_state = rule_copy(new_state);
-    rec->timestamp = time(NULL);
-    snprintf(rec->description, sizeof(rec->description), "%s", description);
+    return &h->records[h->count];
+}
+
+void history_record(struct history_stack *h, enum change_type type, int rule_index,
+                    const struct rule *old_state, const struct rule *new_state,
+                    const char *description) {
+    if (!h || !h->records) return;
+
+    if (h->batch_open) {
+        struct change_record *batch = &h->records[h->count - 1];
+        if (batch->item_count >= h->batch_cap) {
+            size_t cap = h->batch_cap ? h->batch_cap * 2 : 16;
+            struct change_record *ni = realloc(batch->items, cap * sizeof(struct change_record));
+            if (!ni) return;
+            batch->items = ni;
+            h->batch_cap = cap;
+        }
+        fill_record(&batch->items[batch->item_count++], type, rule_index,
+                    old_state, new_state, description);
+        return;
+    }
+
+    struct change_record *rec = push_slot(h);
+    fill_record(rec, type, rule_index, old_state, new_state, description);
+
+    h->count++;
+    h->current = h->count;
+}
+
+void history_begin_batch(struct history_stack *h, const char *description) {
+    if (!h || !h->records || h->batch_open) return;
+
+    struct change_record *rec = push_slot(h);
+    fill_record(rec, CHANGE_BATCH, -1, NULL, NULL, description);
 
     h->count++;
     h->current = h->count;
+    h->batch_open = 1;
+    h->batch_cap = 0;
+}
+
+void history_end_batch(struct history_stack *h) {
+    if (!h || !h->batch_open) return;
+    h->batch_open = 0;
+
+    /* an empty batch is not worth an undo step */
+    struct change_record *rec = &h->records[h->count - 1];
+    if (rec->item_count == 0) {
+        record_free(rec);
+        h->count--;
+        h->current = h->count;
+    }
+}
+
+const struct change_record *history_peek_undo(const struct history_stack *h) {
+    if (!h || h->current == 0) return NULL;
+    return &h->records[h->current - 1];
+}
+
+const struct change_record *history_peek_redo(const struct history_stack *h) {
+    if (!h || h->current >= h->count) return NULL;
+    return &h->records[h->current];
 }
 
 struct rule *history_undo(struct history_stack *h, int *out_index, enum change_type *out_type) {
@@ -52,6 +120,7 @@ struct rule *history_undo(struct history_stack *h, int *out_index, enum change_t
 
     if (out_index) *out_index = rec->rule_index;
     if (out_type) *out_type = rec->type;
+    if (rec->type == CHANGE_BATCH) return NULL; /* caller walks the items */
 
     struct rule *restored = malloc(sizeof(struct rule));
     if (restored) {
@@ -68,6 +137,7 @@ struct rule *history_redo(struct history_stack *h, int *out_index, enum change_t
 
     if (out_index) *out_index = rec->rule_index;
     if (out_type) *out_type = rec->type;
+    if (rec->type == CHANGE_BATCH) return NULL; /* caller walks the items */
 
     /* for delete records, return old_state (the deleted rule) so caller knows what was deleted;
        for edit records, return new_state as before */
@@ -90,10 +160,8 @@ int history_can_redo(const struct history_stack *h) {
 
 void history_free(struct history_stack *h) {
     if (!h) return;
-    for (size_t i = 0; i < h->count; i++) {
-        rule_free(&h->records[i].old_state);
-        rule_free(&h->records[i].new_state);
-    }
+    for (size_t i = 0; i < h->count; i++)
+        record_free(&h->records[i]);
     free(h->records);
     memset(h, 0, sizeof(struct history_stack));
 }
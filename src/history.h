@@ -6,7 +6,8 @@
 
 /* undo/redo history for rule edits */
 
-enum change_type { CHANGE_EDIT, CHANGE_DELETE };
+/* CHANGE_INSERT only appears in batches, which then hold nothing else */
+enum change_type { CHANGE_EDIT, CHANGE_DELETE, CHANGE_BATCH, CHANGE_INSERT };
 
 struct change_record {
     enum change_type type;
@@ -15,6 +16,9 @@ struct change_record {
     struct rule new_state;
     char description[128];
     time_t timestamp;
+    /* CHANGE_BATCH: sub-changes in the order they were applied */
+    struct change_record *items;
+    size_t item_count;
 };
 
 struct history_stack {
@@ -22,6 +26,8 @@ struct history_stack {
     size_t capacity;
     size_t current;
     size_t count;
+    int batch_open;
+    size_t batch_cap;
 };
 
 void history_init(struct history_stack *h);
@@ -30,6 +36,12 @@ void history_record(struct history_stack *h, enum change_type type, int rule_ind
                     const char *description);
 struct rule *history_undo(struct history_stack *h, int *out_index, enum change_type *out_type);
 struct rule *history_redo(struct history_stack *h, int *out_index, enum change_type *out_type);
+/* group every history_record() until history_end_batch() into one undo step */
+void history_begin_batch(struct history_stack *h, const char *description);
+void history_end_batch(struct history_stack *h);
+/* record the next undo/redo would apply, or NULL */
+const struct change_record *history_peek_undo(const struct history_stack *h);
+const struct change_record *history_peek_redo(const struct history_stack *h);
 int history_can_undo(const struct history_stack *h);
 int history_can_redo(const struct history_stack *h);
 void history_free(struct history_stack *h);
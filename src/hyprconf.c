@@ -1,10 +1,13 @@
 #include "hyprconf.h"
 
 #include <ctype.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "scan.h"
 #include "util.h"
 
 static char *strip_comments(const char *src, size_t len, size_t *out_len) {
@@ -13,30 +16,23 @@ static char *strip_comments(const char *src, size_t len, size_t *out_len) {
         return NULL;
     }
 
+    /* copy runs between comments; a comment's newline is kept and "##"
+     * is a literal '#', as in Hyprland's own parser */
     size_t i = 0;
     size_t o = 0;
-    int in_comment = 0;
-
     while (i < len) {
-        char c = src[i];
-
-        if (in_comment) {
-            if (c == '\n') {
-                in_comment = 0;
-                out[o++] = c;
-            }
-            i++;
-            continue;
+        size_t hash = scan_comment(src, len, i);
+        memcpy(out + o, src + i, hash - i);
+        o += hash - i;
+        if (hash == len) {
+            break;
         }
-
-        if (c == '#') {
-            in_comment = 1;
-            i++;
+        if (hash + 1 < len && src[hash + 1] == '#') {
+            out[o++] = '#';
+            i = hash + 2;
             continue;
         }
-
-        out[o++] = c;
-        i++;
+        i = scan_line_end(src, len, hash + 1);
     }
 
     out[o] = '\0';
@@ -47,17 +43,13 @@ static char *strip_comments(const char *src, size_t len, size_t *out_len) {
 }
 
 static void skip_ws(const char *buf, size_t len, size_t *pos) {
-    while (*pos < len && isspace((unsigned char)buf[*pos])) {
-        (*pos)++;
-    }
+    *pos = scan_skip_ws(buf, len, *pos);
 }
 
 static char *read_word(const char *buf, size_t len, size_t *pos) {
     skip_ws(buf, len, pos);
     size_t start = *pos;
-    while (*pos < len && !isspace((unsigned char)buf[*pos]) && buf[*pos] != '{' && buf[*pos] != '}' && buf[*pos] != '=') {
-        (*pos)++;
-    }
+    *pos = scan_word_end(buf, len, *pos);
     if (*pos == start) {
         return NULL;
     }
@@ -74,9 +66,7 @@ static char *read_word(const char *buf, size_t len, size_t *pos) {
 static char *read_value(const char *buf, size_t len, size_t *pos) {
     skip_ws(buf, len, pos);
     size_t start = *pos;
-    while (*pos < len && buf[*pos] != '\n' && buf[*pos] != '}') {
-        (*pos)++;
-    }
+    *pos = scan_value_end(buf, len, *pos);
     /* trim trailing whitespace */
     size_t end = *pos;
     while (end > start && isspace((unsigned char)buf[end - 1])) {
@@ -95,30 +85,51 @@ static char *read_value(const char *buf, size_t len, size_t *pos) {
     return val;
 }
 
+/* advance a (pos, line) cursor to target, counting newlines; comments are
+ * stripped up to their newline, so line numbers match the original file */
+static uint32_t line_at(const char *buf, size_t target, size_t *cur, uint32_t *line) {
+    while (*cur < target) {
+        size_t nl = scan_line_end(buf, target, *cur);
+        if (nl >= target) {
+            *cur = target;
+            break;
+        }
+        (*line)++;
+        *cur = nl + 1;
+    }
+    return *line;
+}
+
 static int str_eq(const char *a, const char *b) {
     return strcmp(a, b) == 0;
 }
 
-static void assign_str(char **dst, char *src) {
-    if (*dst) {
-        free(src);
+/* first value wins; takes ownership of val */
+static void assign_field(struct rule *r, enum rule_field f, char *val) {
+    if (rule_has(r, f)) {
+        free(val);
+        return;
+    }
+    if (f < RF_FIRST_SSO) {
+        r->str[f] = val;
+        r->present |= (uint32_t)RF_BIT(f);
+        r->version++;
         return;
     }
-    *dst = src;
+    rule_set(r, f, val);
+    free(val);
 }
 
-static int parse_bool_str(const char *s, int *out_set, int *out_val) {
+static int parse_bool_str(const char *s, struct rule *r, enum rule_field f) {
     if (!s) {
         return -1;
     }
     if (str_eq(s, "true") || str_eq(s, "yes") || str_eq(s, "1")) {
-        *out_set = 1;
-        *out_val = 1;
+        rule_set_bool(r, f, 1);
         return 0;
     }
     if (str_eq(s, "false") || str_eq(s, "no") || str_eq(s, "0")) {
-        *out_set = 1;
-        *out_val = 0;
+        rule_set_bool(r, f, 0);
         return 0;
     }
     return -1;
@@ -126,61 +137,75 @@ static int parse_bool_str(const char *s, int *out_set, int *out_val) {
 
 static void parse_rule_kv(struct rule *r, const char *key, char *val) {
     if (str_eq(key, "name")) {
-        assign_str(&r->name, val);
+        assign_field(r, RF_NAME, val);
         return;
     }
     if (str_eq(key, "match:class")) {
-        assign_str(&r->match.class_re, val);
+        assign_field(r, RF_CLASS, val);
         return;
     }
     if (str_eq(key, "match:title")) {
-        assign_str(&r->match.title_re, val);
+        assign_field(r, RF_TITLE, val);
         return;
     }
     if (str_eq(key, "match:initialClass") || str_eq(key, "match:initial_class")) {
-        assign_str(&r->match.initial_class_re, val);
+        assign_field(r, RF_INITIAL_CLASS, val);
         return;
     }
     if (str_eq(key, "match:initialTitle") || str_eq(key, "match:initial_title")) {
-        assign_str(&r->match.initial_title_re, val);
+        assign_field(r, RF_INITIAL_TITLE, val);
         return;
     }
     if (str_eq(key, "match:tag")) {
-        assign_str(&r->match.tag_re, val);
+        assign_field(r, RF_TAG_MATCH, val);
         return;
     }
-    /* skip other match: fields we don't use yet */
-    if (strncmp(key, "match:", 6) == 0) {
-        free(val);
+    if (str_eq(key, "match:workspace")) {
+        assign_field(r, RF_MATCH_WORKSPACE, val);
         return;
     }
+    static const struct { const char *key; enum rule_field field; } state_keys[] = {
+        {"match:xwayland", RF_MATCH_XWAYLAND},
+        {"match:float", RF_MATCH_FLOAT},
+        {"match:fullscreen", RF_MATCH_FULLSCREEN},
+        {"match:pin", RF_MATCH_PIN},
+    };
+    for (size_t k = 0; k < sizeof(state_keys) / sizeof(state_keys[0]); k++) {
+        if (!str_eq(key, state_keys[k].key)) continue;
+        /* first value wins; one we can't read is kept verbatim as an extra */
+        if (rule_has(r, state_keys[k].field) || parse_bool_str(val, r, state_keys[k].field) == 0) {
+            free(val);
+            return;
+        }
+        break;
+    }
     if (str_eq(key, "tag")) {
-        assign_str(&r->actions.tag, val);
+        assign_field(r, RF_TAG, val);
         return;
     }
     if (str_eq(key, "workspace")) {
-        assign_str(&r->actions.workspace, val);
+        assign_field(r, RF_WORKSPACE, val);
         return;
     }
     if (str_eq(key, "opacity")) {
-        assign_str(&r->actions.opacity, val);
+        assign_field(r, RF_OPACITY, val);
         return;
     }
     if (str_eq(key, "size")) {
-        assign_str(&r->actions.size, val);
+        assign_field(r, RF_SIZE, val);
         return;
     }
     if (str_eq(key, "move")) {
-        assign_str(&r->actions.move, val);
+        assign_field(r, RF_MOVE, val);
         return;
     }
     if (str_eq(key, "float")) {
-        parse_bool_str(val, &r->actions.float_set, &r->actions.float_val);
+        parse_bool_str(val, r, RF_FLOAT);
         free(val);
         return;
     }
     if (str_eq(key, "center")) {
-        parse_bool_str(val, &r->actions.center_set, &r->actions.center_val);
+        parse_bool_str(val, r, RF_CENTER);
         free(val);
         return;
     }
@@ -246,28 +271,40 @@ static int parse_windowrule_block(const char *buf, size_t len, size_t *pos, stru
     return -1;
 }
 
-int hyprconf_parse_file(const char *path, struct ruleset *out) {
-    memset(out, 0, sizeof(*out));
+/* --- chunked parsing --- */
 
-    size_t raw_len = 0;
-    char *raw = read_file(path, &raw_len);
-    if (!raw) {
-        return -1;
-    }
+/* a file is split only when every chunk gets at least this much text */
+#define PARSE_MIN_CHUNK (256 * 1024)
+#define PARSE_MAX_THREADS 16
+
+/* a run of whole windowrule blocks; chunks start at a line boundary, so
+ * comment stripping and line numbering need no state from earlier text */
+struct parse_chunk {
+    const char *src;
+    size_t len;
+    uint32_t first_line;
+    struct rule *rules;
+    size_t count;
+    int stopped;  /* parsing ended on something that is not a windowrule */
+    int failed;
+};
 
+static void parse_chunk(struct parse_chunk *c) {
     size_t clean_len = 0;
-    char *clean = strip_comments(raw, raw_len, &clean_len);
-    free(raw);
+    char *clean = strip_comments(c->src, c->len, &clean_len);
     if (!clean) {
-        return -1;
+        c->failed = 1;
+        return;
     }
 
-    /* first pass: count windowrule blocks */
+    /* first pass: count windowrule blocks; trailing text that is not a
+     * word (read_word fails before the end) stops the file here */
     size_t count = 0;
     size_t pos = 0;
     while (pos < clean_len) {
         char *word = read_word(clean, clean_len, &pos);
         if (!word) {
+            c->stopped = pos < clean_len;
             break;
         }
         if (str_eq(word, "windowrule")) {
@@ -289,25 +326,32 @@ int hyprconf_parse_file(const char *path, struct ruleset *out) {
 
     if (count == 0) {
         free(clean);
-        return 0;
+        return;
     }
 
     struct rule *rules = (struct rule *)calloc(count, sizeof(struct rule));
     if (!rules) {
         free(clean);
-        return -1;
+        c->failed = 1;
+        return;
     }
 
     /* second pass: parse windowrule blocks */
     pos = 0;
     size_t idx = 0;
+    size_t line_pos = 0;
+    uint32_t line = c->first_line;
     while (pos < clean_len && idx < count) {
         char *word = read_word(clean, clean_len, &pos);
         if (!word) {
+            c->stopped |= pos < clean_len;
             break;
         }
         if (str_eq(word, "windowrule")) {
+            uint32_t start = line_at(clean, pos - strlen(word), &line_pos, &line);
             if (parse_windowrule_block(clean, clean_len, &pos, &rules[idx]) == 0) {
+                rules[idx].src_line = start;
+                rules[idx].src_end = line_at(clean, pos - 1, &line_pos, &line);
                 idx++;
             }
         }
@@ -315,7 +359,137 @@ int hyprconf_parse_file(const char *path, struct ruleset *out) {
     }
 
     free(clean);
+    c->rules = rules;
+    c->count = idx;
+}
+
+static void *parse_chunk_fn(void *arg) {
+    parse_chunk((struct parse_chunk *)arg);
+    return NULL;
+}
+
+static int is_word_end(char c) {
+    return c == '{' || isspace((unsigned char)c);
+}
+
+/*
+ * Split src into at most max chunks of roughly equal size. A boundary is
+ * a line whose first word is "windowrule" at brace depth zero, outside
+ * comments, so no block is ever cut in two. Returns the chunk count.
+ */
+static int split_chunks(const char *src, size_t len, struct parse_chunk *chunks, int max) {
+    size_t step = len / (size_t)max;
+    size_t target = step;
+    int n = 0;
+    int depth = 0;
+    uint32_t line = 1;
+
+    chunks[0] = (struct parse_chunk){.src = src, .len = len, .first_line = 1};
+    if (max <= 1) return 1;
+    for (size_t i = scan_syntax(src, len, 0); i < len; i = scan_syntax(src, len, i + 1)) {
+        char c = src[i];
+        if (c == '#') {
+            if (i + 1 < len && src[i + 1] == '#') {
+                i++; /* escaped '#' */
+                continue;
+            }
+            i = scan_line_end(src, len, i + 1) - 1; /* newline handled next */
+            continue;
+        }
+        if (c == '{') {
+            depth++;
+        } else if (c == '}') {
+            if (depth > 0) depth--;
+        } else if (c == '\n') {
+            line++;
+            if (depth != 0 || i + 1 < target || n + 1 >= max) continue;
+
+            size_t w = i + 1;
+            while (w < len && (src[w] == ' ' || src[w] == '\t')) w++;
+            if (len - w > 10 && memcmp(src + w, "windowrule", 10) == 0 && is_word_end(src[w + 10])) {
+                chunks[n].len = (size_t)(src + i + 1 - chunks[n].src);
+                n++;
+                chunks[n] = (struct parse_chunk){.src = src + i + 1, .first_line = line};
+                target = i + 1 + step;
+            }
+        }
+    }
+    chunks[n].len = (size_t)(src + len - chunks[n].src);
+    return n + 1;
+}
+
+static int parse_threads(size_t len) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t by_size = len / PARSE_MIN_CHUNK;
+    int n = cpus > 0 ? (int)cpus : 1;
+    if (n > PARSE_MAX_THREADS) n = PARSE_MAX_THREADS;
+    if ((size_t)n > by_size) n = by_size > 0 ? (int)by_size : 1;
+    return n;
+}
+
+int hyprconf_parse_file(const char *path, struct ruleset *out) {
+    memset(out, 0, sizeof(*out));
+
+    size_t raw_len = 0;
+    char *raw = read_file(path, &raw_len);
+    if (!raw) {
+        return -1;
+    }
+
+    struct parse_chunk chunks[PARSE_MAX_THREADS];
+    int nchunks = split_chunks(raw, raw_len, chunks, parse_threads(raw_len));
+
+    /* chunk 0 runs on this thread; fall back to inline parsing if a
+     * thread cannot be started */
+    pthread_t tids[PARSE_MAX_THREADS];
+    int started[PARSE_MAX_THREADS] = {0};
+    for (int i = 1; i < nchunks; i++)
+        started[i] = pthread_create(&tids[i], NULL, parse_chunk_fn, &chunks[i]) == 0;
+    parse_chunk(&chunks[0]);
+    for (int i = 1; i < nchunks; i++) {
+        if (started[i]) pthread_join(tids[i], NULL);
+        else parse_chunk(&chunks[i]);
+    }
+    free(raw);
+
+    /* concatenate in file order; a chunk that stopped early ends the
+     * file, exactly as a single pass would */
+    size_t total = 0;
+    int used = 0;
+    int failed = 0;
+    while (used < nchunks) {
+        failed |= chunks[used].failed;
+        total += chunks[used].count;
+        if (chunks[used++].stopped) break;
+    }
+    struct rule *rules = NULL;
+    if (!failed && total > 0) {
+        rules = nchunks == 1 ? chunks[0].rules : malloc(total * sizeof(struct rule));
+        failed = rules == NULL;
+    }
+    if (!failed && nchunks > 1) {
+        size_t at = 0;
+        for (int i = 0; i < used; i++) {
+            if (chunks[i].count)
+                memcpy(rules + at, chunks[i].rules, chunks[i].count * sizeof(struct rule));
+            at += chunks[i].count;
+            free(chunks[i].rules);
+            chunks[i].rules = NULL;
+            chunks[i].count = 0;
+        }
+    }
+
+    /* whatever was not moved into the result */
+    for (int i = 0; i < nchunks; i++) {
+        if (chunks[i].rules == rules && !failed) continue;
+        for (size_t j = 0; j < chunks[i].count; j++) rule_free(&chunks[i].rules[j]);
+        free(chunks[i].rules);
+    }
+    if (failed) {
+        return -1;
+    }
+
     out->rules = rules;
-    out->count = idx;
+    out->count = total;
     return 0;
 }
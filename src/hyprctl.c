@@ -4,6 +4,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 /*
  * Simple JSON string extraction for hyprctl -j clients output.
@@ -92,6 +95,21 @@ static int json_get_int(const char *buf, size_t len, size_t start, const char *k
     return (int)val;
 }
 
+/* find "key": true|false in buf starting at pos */
+static int json_get_bool(const char *buf, size_t len, size_t start, const char *key, int def) {
+    char pat[128];
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+
+    const char *p = strstr(buf + start, pat);
+    if (!p || p >= buf + len) return def;
+    p += strlen(pat);
+
+    while (p < buf + len && isspace((unsigned char)*p)) p++;
+    if (p + 4 <= buf + len && strncmp(p, "true", 4) == 0) return 1;
+    if (p + 5 <= buf + len && strncmp(p, "false", 5) == 0) return 0;
+    return def;
+}
+
 /* find the end of a JSON object starting at '{' */
 static size_t json_skip_object(const char *buf, size_t len, size_t pos) {
     if (pos >= len || buf[pos] != '{') return pos;
@@ -115,6 +133,7 @@ static size_t json_skip_object(const char *buf, size_t len, size_t pos) {
 
 static void free_client(struct client *c) {
     if (!c) return;
+    free(c->address);
     free(c->class_name);
     free(c->title);
     free(c->initial_class);
@@ -163,6 +182,14 @@ int hyprctl_clients(struct clients *out) {
         size_t obj_end = json_skip_object(buf, len, pos);
 
         struct client *c = &items[idx];
+        c->address = json_get_str(buf, obj_end, obj_start, "address");
+        c->floating = json_get_bool(buf, obj_end, obj_start, "floating", 0);
+        c->xwayland = json_get_bool(buf, obj_end, obj_start, "xwayland", 0);
+        c->pinned = json_get_bool(buf, obj_end, obj_start, "pinned", 0);
+        /* a mode number on current Hyprland, a boolean on older releases */
+        c->fullscreen = json_get_int(buf, obj_end, obj_start, "fullscreen", -1);
+        if (c->fullscreen < 0) c->fullscreen = json_get_bool(buf, obj_end, obj_start, "fullscreen", 0);
+        c->fullscreen = c->fullscreen != 0;
         c->class_name = json_get_str(buf, obj_end, obj_start, "class");
         c->title = json_get_str(buf, obj_end, obj_start, "title");
         c->initial_class = json_get_str(buf, obj_end, obj_start, "initialClass");
@@ -201,3 +228,249 @@ void clients_free(struct clients *list) {
     list->items = NULL;
     list->count = 0;
 }
+
+/* --- snapshot diff --- */
+
+static int str_same(const char *a, const char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/* equal in every field a window rule can match on */
+static int client_same(const struct client *a, const struct client *b) {
+    return a->workspace_id == b->workspace_id && a->floating == b->floating &&
+           a->xwayland == b->xwayland && a->fullscreen == b->fullscreen &&
+           a->pinned == b->pinned && str_same(a->class_name, b->class_name) &&
+           str_same(a->title, b->title) && str_same(a->initial_class, b->initial_class) &&
+           str_same(a->initial_title, b->initial_title) &&
+           str_same(a->workspace_name, b->workspace_name);
+}
+
+static size_t address_hash(const char *s) {
+    size_t h = 2166136261u;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int clients_diff(const struct clients *prev, const struct clients *cur,
+                 int *same, unsigned char *kept) {
+    size_t cap = 16;
+    while (cap < prev->count * 2) cap <<= 1;
+    int *tab = malloc(cap * sizeof(int));
+    if (!tab) return -1;
+    for (size_t k = 0; k < cap; k++) tab[k] = -1;
+    for (size_t i = 0; i < prev->count; i++) {
+        if (!prev->items[i].address) continue;
+        size_t k = address_hash(prev->items[i].address) & (cap - 1);
+        while (tab[k] >= 0) k = (k + 1) & (cap - 1);
+        tab[k] = (int)i;
+    }
+
+    if (kept) memset(kept, 0, prev->count);
+    for (size_t i = 0; i < cur->count; i++) {
+        const struct client *c = &cur->items[i];
+        same[i] = -1;
+        if (!c->address) continue;
+        for (size_t k = address_hash(c->address) & (cap - 1); tab[k] >= 0; k = (k + 1) & (cap - 1)) {
+            const struct client *p = &prev->items[tab[k]];
+            if (strcmp(p->address, c->address) != 0) continue;
+            if (client_same(p, c)) {
+                same[i] = tab[k];
+                if (kept) kept[tab[k]] = 1;
+            }
+            break;
+        }
+    }
+    free(tab);
+    return 0;
+}
+
+/* --- command socket --- */
+
+int hyprctl_socket_path(char *out, size_t out_sz) {
+    const char *sig = getenv("HYPRLAND_INSTANCE_SIGNATURE");
+    if (!sig || !sig[0]) return -1;
+
+    /* Hyprland >= 0.40 lives under XDG_RUNTIME_DIR, older releases under /tmp */
+    const char *rt = getenv("XDG_RUNTIME_DIR");
+    if (rt && rt[0]) {
+        snprintf(out, out_sz, "%s/hypr/%s/.socket.sock", rt, sig);
+        if (access(out, F_OK) == 0) return 0;
+    }
+    snprintf(out, out_sz, "/tmp/hypr/%s/.socket.sock", sig);
+    return access(out, F_OK) == 0 ? 0 : -1;
+}
+
+int hyprctl_request(const char *socket_path, const char *request, char **reply) {
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    if (reply) *reply = NULL;
+
+    if (socket_path) {
+        if (strlen(socket_path) >= sizeof(path)) return -1;
+        snprintf(path, sizeof(path), "%s", socket_path);
+    } else if (hyprctl_socket_path(path, sizeof(path)) != 0) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    size_t len = strlen(request), off = 0;
+    while (off < len) {
+        ssize_t n = write(fd, request + off, len - off);
+        if (n <= 0) { close(fd); return -1; }
+        off += (size_t)n;
+    }
+
+    /* Hyprland answers once and closes the connection */
+    size_t cap = 4096, rlen = 0;
+    char *buf = malloc(cap);
+    if (!buf) { close(fd); return -1; }
+    ssize_t n;
+    while ((n = read(fd, buf + rlen, cap - rlen - 1)) > 0) {
+        rlen += (size_t)n;
+        if (cap - rlen - 1 < 1024) {
+            cap *= 2;
+            char *next = realloc(buf, cap);
+            if (!next) { free(buf); close(fd); return -1; }
+            buf = next;
+        }
+    }
+    close(fd);
+    if (n < 0) { free(buf); return -1; }
+
+    buf[rlen] = '\0';
+    if (reply) *reply = buf;
+    else free(buf);
+    return 0;
+}
+
+int hyprctl_reload(const char *socket_path) {
+    char *reply = NULL;
+    if (hyprctl_request(socket_path, "reload", &reply) != 0) return -1;
+    int ok = strncmp(reply, "ok", 2) == 0;
+    free(reply);
+    return ok ? 0 : -1;
+}
+
+/* decode the JSON string starting after the opening quote at *p; advances
+ * past the closing quote */
+static char *json_decode_str(const char **p) {
+    const char *s = *p;
+    size_t len = 0;
+    while (s[len] && s[len] != '"') {
+        if (s[len] == '\\' && s[len + 1]) len++;
+        len++;
+    }
+
+    char *out = malloc(len + 1);
+    if (!out) return NULL;
+    size_t o = 0;
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        if (c == '\\' && i + 1 < len) {
+            c = s[++i];
+            if (c == 'n') c = '\n';
+            else if (c == 't') c = '\t';
+            else if (c == 'u') {
+                /* non-ASCII escapes are not worth decoding for messages */
+                i += 4 < len - i ? 4 : len - i - 1;
+                c = '?';
+            }
+        }
+        out[o++] = c;
+    }
+    out[o] = '\0';
+    *p = s[len] ? s + len + 1 : s + len;
+    return out;
+}
+
+/* "Config error in file /path/rules.conf at line 42: message" */
+static void split_config_error(char *text, struct config_error *e) {
+    e->line = 0;
+    e->file = NULL;
+    e->message = text;
+
+    const char *in = strstr(text, " in file ");
+    const char *at = in ? strstr(in, " at line ") : NULL;
+    if (!in || !at) return;
+
+    const char *path = in + 9;
+    e->file = malloc((size_t)(at - path) + 1);
+    if (!e->file) return;
+    memcpy(e->file, path, (size_t)(at - path));
+    e->file[at - path] = '\0';
+
+    char *end = NULL;
+    e->line = (int)strtol(at + 9, &end, 10);
+    if (end && *end == ':') end++;
+    while (end && *end == ' ') end++;
+    if (end && *end) {
+        char *msg = strdup(end);
+        if (msg) {
+            free(text);
+            e->message = msg;
+        }
+    }
+}
+
+int hyprctl_config_errors(const char *socket_path, struct config_errors *out) {
+    memset(out, 0, sizeof(*out));
+
+    char *reply = NULL;
+    if (hyprctl_request(socket_path, "j/configerrors", &reply) != 0) return -1;
+
+    /* a JSON array of strings; a clean config answers [""] */
+    size_t cap = 0;
+    const char *p = strchr(reply, '[');
+    while (p && *p) {
+        p = strchr(p, '"');
+        if (!p) break;
+        p++;
+        char *text = json_decode_str(&p);
+        if (!text) break;
+
+        /* one string may hold several newline-separated errors */
+        for (char *line = text; line && *line;) {
+            char *nl = strchr(line, '\n');
+            if (nl) *nl = '\0';
+            if (*line) {
+                if (out->count == cap) {
+                    cap = cap ? cap * 2 : 8;
+                    struct config_error *next = realloc(out->items, cap * sizeof(*next));
+                    if (!next) break;
+                    out->items = next;
+                }
+                char *copy = strdup(line);
+                if (copy) split_config_error(copy, &out->items[out->count++]);
+            }
+            line = nl ? nl + 1 : NULL;
+        }
+        free(text);
+    }
+
+    free(reply);
+    return 0;
+}
+
+void config_errors_free(struct config_errors *list) {
+    if (!list) return;
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->items[i].file);
+        free(list->items[i].message);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+}
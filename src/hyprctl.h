@@ -4,12 +4,17 @@
 #include <stddef.h>
 
 struct client {
+    char *address; /* "0x..." window address, used to target dispatchers */
     char *class_name;
     char *title;
     char *initial_class;
     char *initial_title;
     char *workspace_name;
     int workspace_id;
+    int floating;
+    int xwayland;
+    int fullscreen; /* any fullscreen mode */
+    int pinned;
 };
 
 struct clients {
@@ -20,4 +25,35 @@ struct clients {
 int hyprctl_clients(struct clients *out);
 void clients_free(struct clients *list);
 
+/* match a fresh client list against the previous one by window address.
+ * same[i] is the index in prev of cur's i-th window when none of its
+ * matchable fields changed, -1 when it is new or changed; kept (may be
+ * NULL) marks those prev windows. Returns 0 or -1 (out of memory). */
+int clients_diff(const struct clients *prev, const struct clients *cur,
+                 int *same, unsigned char *kept);
+
+/* one entry of `hyprctl configerrors`, split into its location and text */
+struct config_error {
+    char *file;    /* NULL when the message carries no location */
+    int line;
+    char *message;
+};
+
+struct config_errors {
+    struct config_error *items;
+    size_t count;
+};
+
+/* path of the Hyprland command socket for this session; returns 0 or -1 */
+int hyprctl_socket_path(char *out, size_t out_sz);
+/* send one request over the command socket (NULL = session socket) and read
+ * the whole reply into *reply (caller frees); returns 0 or -1 */
+int hyprctl_request(const char *socket_path, const char *request, char **reply);
+
+/* reload the config over the socket; returns 0 when Hyprland answered "ok" */
+int hyprctl_reload(const char *socket_path);
+/* fetch the errors from the last config parse; returns 0 or -1 */
+int hyprctl_config_errors(const char *socket_path, struct config_errors *out);
+void config_errors_free(struct config_errors *list);
+
 #endif
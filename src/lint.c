@@ -0,0 +1,866 @@
+#include "lint.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <regex.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "match.h"
+#include "rules.h"
+#include "util.h"
+
+#define LINT_MAX_JOBS 64
+#define PATTERN_SHARDS 64
+
+static uint64_t lint_hash(uint64_t h, const char *s) {
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ull;
+    }
+    h ^= 0xff;
+    return h * 1099511628211ull;
+}
+
+#define LINT_HASH_SEED 14695981039346656037ull
+
+/* --- pattern cache --- */
+
+/* what one distinct pattern compiles to; never changes once published */
+struct lint_pattern {
+    char *text;
+    char *error;             /* regerror() message, NULL when it compiles */
+    struct match_lit *lits;  /* literal alternatives, NULL when it needs a regex */
+    size_t lit_count;
+    uint64_t hash;
+};
+
+/* sharded so that workers rarely wait on each other */
+struct pattern_shard {
+    pthread_mutex_t lock;
+    struct lint_pattern **slots;  /* open addressing, power-of-two size */
+    size_t cap, count;
+};
+
+struct pattern_cache {
+    struct pattern_shard shards[PATTERN_SHARDS];
+};
+
+static void pattern_cache_init(struct pattern_cache *pc) {
+    memset(pc, 0, sizeof(*pc));
+    for (int i = 0; i < PATTERN_SHARDS; i++) pthread_mutex_init(&pc->shards[i].lock, NULL);
+}
+
+static void pattern_free(struct lint_pattern *p) {
+    if (!p) return;
+    free(p->text);
+    free(p->error);
+    match_literals_free(p->lits, p->lit_count);
+    free(p);
+}
+
+static void pattern_cache_free(struct pattern_cache *pc) {
+    for (int i = 0; i < PATTERN_SHARDS; i++) {
+        struct pattern_shard *sh = &pc->shards[i];
+        for (size_t j = 0; j < sh->cap; j++) pattern_free(sh->slots[j]);
+        free(sh->slots);
+        pthread_mutex_destroy(&sh->lock);
+    }
+}
+
+static size_t pattern_cache_count(struct pattern_cache *pc) {
+    size_t n = 0;
+    for (int i = 0; i < PATTERN_SHARDS; i++) n += pc->shards[i].count;
+    return n;
+}
+
+/* where text lives or would go; the shard lock is held */
+static struct lint_pattern **shard_slot(struct pattern_shard *sh, uint64_t h, const char *text) {
+    size_t i = (size_t)(h >> 6) & (sh->cap - 1);
+    while (sh->slots[i] && (sh->slots[i]->hash != h || strcmp(sh->slots[i]->text, text) != 0))
+        i = (i + 1) & (sh->cap - 1);
+    return &sh->slots[i];
+}
+
+static int shard_grow(struct pattern_shard *sh) {
+    size_t old_cap = sh->cap, cap = old_cap ? old_cap * 2 : 64;
+    struct lint_pattern **old = sh->slots;
+    struct lint_pattern **slots = calloc(cap, sizeof(*slots));
+    if (!slots) return -1;
+    sh->slots = slots;
+    sh->cap = cap;
+    for (size_t i = 0; i < old_cap; i++)
+        if (old[i]) *shard_slot(sh, old[i]->hash, old[i]->text) = old[i];
+    free(old);
+    return 0;
+}
+
+static struct lint_pattern *pattern_compile(const char *text, uint64_t h) {
+    struct lint_pattern *p = calloc(1, sizeof(*p));
+    if (!p || !(p->text = strdup(text))) {
+        free(p);
+        return NULL;
+    }
+    p->hash = h;
+    /* plain literals are valid by construction; only the rest pays for regcomp */
+    if (match_literals(text, &p->lits, &p->lit_count) == 0) return p;
+
+    regex_t re;
+    int rc = regcomp(&re, text, MATCH_REGEX_FLAGS);
+    if (rc == 0) {
+        regfree(&re);
+        return p;
+    }
+    char msg[128];
+    regerror(rc, &re, msg, sizeof(msg));
+    if (!(p->error = strdup(msg))) {
+        pattern_free(p);
+        return NULL;
+    }
+    return p;
+}
+
+/* the entry for text, compiled on first use by any worker; NULL when out
+ * of memory */
+static const struct lint_pattern *pattern_get(struct pattern_cache *pc, const char *text) {
+    uint64_t h = lint_hash(LINT_HASH_SEED, text);
+    struct pattern_shard *sh = &pc->shards[h & (PATTERN_SHARDS - 1)];
+    pthread_mutex_lock(&sh->lock);
+    struct lint_pattern *p = sh->cap ? *shard_slot(sh, h, text) : NULL;
+    pthread_mutex_unlock(&sh->lock);
+    if (p) return p;
+
+    /* compile outside the lock; whoever publishes first wins */
+    struct lint_pattern *mine = pattern_compile(text, h);
+    if (!mine) return NULL;
+    pthread_mutex_lock(&sh->lock);
+    struct lint_pattern **slot = NULL;
+    if ((sh->count + 1) * 2 <= sh->cap || shard_grow(sh) == 0) slot = shard_slot(sh, h, text);
+    if (slot && !*slot) {
+        *slot = mine;
+        sh->count++;
+        mine = NULL;
+    }
+    p = slot ? *slot : NULL;
+    pthread_mutex_unlock(&sh->lock);
+    pattern_free(mine);
+    return p;
+}
+
+/* every window the literals of b accept, a accepts too */
+static int lits_cover(const struct lint_pattern *a, const struct lint_pattern *b) {
+    for (size_t j = 0; j < b->lit_count; j++) {
+        const struct match_lit *y = &b->lits[j];
+        size_t i = 0;
+        for (; i < a->lit_count; i++) {
+            const struct match_lit *x = &a->lits[i];
+            if (x->mode == MATCH_LIT_EXACT && y->mode == MATCH_LIT_EXACT &&
+                strcmp(x->text, y->text) == 0)
+                break;
+            if (x->mode == MATCH_LIT_PREFIX && y->mode != MATCH_LIT_CONTAINS &&
+                strncmp(x->text, y->text, x->len) == 0)
+                break;
+            if (x->mode == MATCH_LIT_CONTAINS && strstr(y->text, x->text))
+                break;
+        }
+        if (i == a->lit_count) return 0;
+    }
+    return 1;
+}
+
+/* --- diagnostics --- */
+
+enum lint_severity { LINT_WARNING, LINT_ERROR };
+
+struct lint_diag {
+    uint32_t line;
+    enum lint_severity severity;
+    const char *check;
+    char *message;
+    size_t seq;  /* keeps checks in order on the same line */
+};
+
+struct diag_list {
+    struct lint_diag *items;
+    size_t count, cap;
+};
+
+static void diag_add(struct diag_list *d, uint32_t line, enum lint_severity sev,
+                     const char *check, const char *fmt, ...) {
+    char msg[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    if (d->count == d->cap) {
+        size_t cap = d->cap ? d->cap * 2 : 16;
+        struct lint_diag *grown = realloc(d->items, cap * sizeof(*grown));
+        if (!grown) return;
+        d->items = grown;
+        d->cap = cap;
+    }
+    char *copy = strdup(msg);
+    if (!copy) return;
+    d->items[d->count] = (struct lint_diag){line, sev, check, copy, d->count};
+    d->count++;
+}
+
+static int compare_diag(const void *a, const void *b) {
+    const struct lint_diag *x = a, *y = b;
+    if (x->line != y->line) return x->line < y->line ? -1 : 1;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+static void diag_write(FILE *f, const char *path, const struct lint_diag *d, int json) {
+    const char *sev = d->severity == LINT_ERROR ? "error" : "warning";
+    if (json) {
+        fputs("{\"file\": ", f);
+        json_put_string(f, path);
+        fprintf(f, ", \"line\": %u, \"severity\": \"%s\", \"check\": \"%s\", \"message\": ",
+                d->line, sev, d->check);
+        json_put_string(f, d->message);
+        fputs("}\n", f);
+    } else if (d->line) {
+        fprintf(f, "%s:%u: %s: %s: %s\n", path, d->line, sev, d->check, d->message);
+    } else {
+        fprintf(f, "%s: %s: %s: %s\n", path, sev, d->check, d->message);
+    }
+}
+
+/* --- rule model --- */
+
+/* a key = value a rule sets, borrowed from the rule */
+struct lint_pair {
+    const char *key;
+    const char *value;
+};
+
+#define LINT_PATTERN_COUNT 4
+
+static const enum rule_field pattern_fields[LINT_PATTERN_COUNT] = {
+    RF_CLASS, RF_TITLE, RF_INITIAL_CLASS, RF_INITIAL_TITLE,
+};
+
+static int pattern_index(int f) {
+    for (int k = 0; k < LINT_PATTERN_COUNT; k++)
+        if ((int)pattern_fields[k] == f) return k;
+    return -1;
+}
+
+struct lint_rule {
+    const struct rule *r;
+    uint32_t line;
+    uint32_t match_mask;      /* r->present & RF_MATCH_MASK */
+    uint64_t match_key;       /* hash of every match constraint */
+    const struct lint_pattern *pat[LINT_PATTERN_COUNT];
+    struct lint_pair *acts;   /* actions, sorted */
+    size_t nacts;
+    struct lint_pair *conds;  /* "match:" keys kept as extras, sorted */
+    size_t nconds;
+};
+
+/*
+ * Window rule effects and match props Hyprland knows, compared with
+ * underscores removed so that both "border_size" and "bordersize" pass.
+ */
+static const char *const effect_keys[] = {
+    "float", "tile", "fullscreen", "maximize", "fullscreenstate", "move", "size",
+    "center", "pseudo", "monitor", "workspace", "noinitialfocus", "pin", "unset",
+    "group", "suppressevent", "content", "noclosefor", "persistentsize", "nomaxsize",
+    "stayfocused", "animation", "bordercolor", "idleinhibit", "opacity", "tag",
+    "maxsize", "minsize", "bordersize", "rounding", "roundingpower", "allowsinput",
+    "dimaround", "decorate", "focusonactivate", "keepaspectratio", "nearestneighbor",
+    "noanim", "noblur", "noborder", "nodim", "nofocus", "nofollowmouse", "noshadow",
+    "noshortcutsinhibit", "noscreenshare", "novrr", "opaque", "forcergbx",
+    "syncfullscreen", "immediate", "xray", "renderunfocused", "scrollmouse",
+    "scrolltouchpad", "enable",
+};
+
+static const char *const match_keys[] = {
+    "class", "title", "initialclass", "initialtitle", "tag", "xwayland", "float",
+    "fullscreen", "pin", "focus", "group", "modal", "fullscreenstateclient",
+    "fullscreenstateinternal", "workspace", "content", "xdgtag",
+};
+
+static int known_key(const char *key) {
+    const char *const *table = effect_keys;
+    size_t n = sizeof(effect_keys) / sizeof(effect_keys[0]);
+    if (strncmp(key, "match:", 6) == 0) {
+        key += 6;
+        table = match_keys;
+        n = sizeof(match_keys) / sizeof(match_keys[0]);
+    }
+    char norm[64];
+    size_t len = 0;
+    for (; *key && len + 1 < sizeof(norm); key++)
+        if (*key != '_') norm[len++] = (char)tolower((unsigned char)*key);
+    if (*key) return 0;
+    norm[len] = '\0';
+    for (size_t i = 0; i < n; i++)
+        if (strcmp(norm, table[i]) == 0) return 1;
+    return 0;
+}
+
+static int compare_pair(const void *a, const void *b) {
+    const struct lint_pair *x = a, *y = b;
+    int c = strcmp(x->key, y->key);
+    return c ? c : strcmp(x->value, y->value);
+}
+
+static uint64_t pair_hash(uint64_t h, const struct lint_pair *p) {
+    return lint_hash(lint_hash(h, p->key), p->value);
+}
+
+/* fill lr from r, taking pairs from the arena at pairs; returns the
+ * arena's new end. Pattern and key problems are reported here. */
+static struct lint_pair *lint_rule_init(struct pattern_cache *pc, struct lint_rule *lr,
+                                        const struct rule *r, const char *const *keys,
+                                        struct lint_pair *pairs, struct diag_list *d) {
+    lr->r = r;
+    lr->line = r->src_line;
+    lr->match_mask = r->present & RF_MATCH_MASK;
+    lr->acts = pairs;
+    uint64_t h = LINT_HASH_SEED;
+
+    for (int f = 0; f < RF_COUNT; f++) {
+        if (!rule_has(r, f) || !keys[f] || f == RF_NAME) continue;
+        const char *v = f >= RF_FLOAT ? (rule_get_bool(r, f) ? "true" : "false") : rule_get(r, f);
+        if (!(RF_BIT(f) & RF_MATCH_MASK)) {
+            *pairs++ = (struct lint_pair){keys[f], v};
+            continue;
+        }
+        h = pair_hash(h, &(struct lint_pair){keys[f], v});
+        int k = pattern_index(f);
+        if (k < 0) continue;
+        lr->pat[k] = pattern_get(pc, v);
+        if (lr->pat[k] && lr->pat[k]->error)
+            diag_add(d, lr->line, LINT_ERROR, "invalid-regex", "%s: %s in \"%s\"", keys[f],
+                     lr->pat[k]->error, v);
+    }
+    for (size_t j = 0; j < r->extras_count; j++) {
+        const struct rule_extra *e = &r->extras[j];
+        if (!known_key(e->key))
+            diag_add(d, lr->line, LINT_WARNING, "unknown-key", "\"%s\" is not a window rule key",
+                     e->key);
+        if (strncmp(e->key, "match:", 6) != 0) *pairs++ = (struct lint_pair){e->key, e->value};
+    }
+    lr->nacts = (size_t)(pairs - lr->acts);
+
+    lr->conds = pairs;
+    for (size_t j = 0; j < r->extras_count; j++)
+        if (strncmp(r->extras[j].key, "match:", 6) == 0)
+            *pairs++ = (struct lint_pair){r->extras[j].key, r->extras[j].value};
+    lr->nconds = (size_t)(pairs - lr->conds);
+
+    qsort(lr->acts, lr->nacts, sizeof(struct lint_pair), compare_pair);
+    qsort(lr->conds, lr->nconds, sizeof(struct lint_pair), compare_pair);
+    for (size_t j = 0; j < lr->nconds; j++) h = pair_hash(h, &lr->conds[j]);
+    lr->match_key = h;
+    return pairs;
+}
+
+static int pairs_equal(const struct lint_pair *a, size_t na, const struct lint_pair *b, size_t nb) {
+    if (na != nb) return 0;
+    for (size_t i = 0; i < na; i++)
+        if (compare_pair(&a[i], &b[i]) != 0) return 0;
+    return 1;
+}
+
+/* every pair of a is in b; both sorted */
+static int pairs_subset(const struct lint_pair *a, size_t na, const struct lint_pair *b, size_t nb) {
+    size_t j = 0;
+    for (size_t i = 0; i < na; i++) {
+        while (j < nb && compare_pair(&b[j], &a[i]) < 0) j++;
+        if (j == nb || compare_pair(&b[j], &a[i]) != 0) return 0;
+        j++;
+    }
+    return 1;
+}
+
+static int same_match(const struct lint_rule *a, const struct lint_rule *b) {
+    if (a->match_mask != b->match_mask) return 0;
+    for (int f = 0; f < RF_COUNT; f++) {
+        if (!(a->match_mask & RF_BIT(f))) continue;
+        if (f >= RF_FLOAT) {
+            if (rule_get_bool(a->r, f) != rule_get_bool(b->r, f)) return 0;
+        } else if (strcmp(rule_get(a->r, f), rule_get(b->r, f)) != 0) {
+            return 0;
+        }
+    }
+    return pairs_equal(a->conds, a->nconds, b->conds, b->nconds);
+}
+
+/* a matches at least every window b matches */
+static int match_covers(const struct lint_rule *a, const struct lint_rule *b) {
+    if (!a->match_mask && !a->nconds) return 0; /* matches everything: not a real rule */
+    if (a->match_mask & ~b->match_mask) return 0;
+    if (!pairs_subset(a->conds, a->nconds, b->conds, b->nconds)) return 0;
+    for (int f = 0; f < RF_COUNT; f++) {
+        if (!(a->match_mask & RF_BIT(f))) continue;
+        int k = pattern_index(f);
+        if (f >= RF_FLOAT) {
+            if (rule_get_bool(a->r, f) != rule_get_bool(b->r, f)) return 0;
+        } else if (k >= 0) {
+            const struct lint_pattern *pa = a->pat[k], *pb = b->pat[k];
+            if (!pa || !pb || pa->error || pb->error) return 0;
+            if (pa != pb && !(pa->lits && pb->lits && lits_cover(pa, pb))) return 0;
+        } else if (strcmp(rule_get(a->r, f), rule_get(b->r, f)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* b adds nothing to a; exact duplicates are left to check_groups */
+static int subsumes(const struct lint_rule *a, const struct lint_rule *b) {
+    if (!pairs_subset(b->acts, b->nacts, a->acts, a->nacts) || !match_covers(a, b)) return 0;
+    return !(same_match(a, b) && pairs_equal(a->acts, a->nacts, b->acts, b->nacts));
+}
+
+/* --- checks --- */
+
+struct name_ref {
+    const char *name;
+    size_t idx;
+};
+
+static int compare_name_ref(const void *a, const void *b) {
+    const struct name_ref *x = a, *y = b;
+    int c = strcasecmp(x->name, y->name);
+    return c ? c : (x->idx > y->idx) - (x->idx < y->idx);
+}
+
+/* names compare case-insensitively, as the rules view's duplicate flag does */
+static void check_names(const struct lint_rule *lr, size_t n, struct diag_list *d) {
+    struct name_ref *refs = malloc((n ? n : 1) * sizeof(*refs));
+    if (!refs) return;
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char *name = rule_get(lr[i].r, RF_NAME);
+        if (name && *name) refs[m++] = (struct name_ref){name, i};
+    }
+    qsort(refs, m, sizeof(*refs), compare_name_ref);
+    for (size_t i = 1, g = 0; i < m; i++) {
+        if (strcasecmp(refs[i].name, refs[g].name) != 0) {
+            g = i;
+            continue;
+        }
+        diag_add(d, lr[refs[i].idx].line, LINT_WARNING, "duplicate-name",
+                 "name \"%s\" is already used by the rule at line %u", refs[i].name,
+                 lr[refs[g].idx].line);
+    }
+    free(refs);
+}
+
+struct key_ref {
+    uint64_t key;
+    size_t idx;
+};
+
+static int compare_key_ref(const void *a, const void *b) {
+    const struct key_ref *x = a, *y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->idx > y->idx) - (x->idx < y->idx);
+}
+
+/* first entry with refs[i].key >= key */
+static size_t key_lower(const struct key_ref *refs, size_t n, uint64_t key) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (refs[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static size_t key_run_end(const struct key_ref *refs, size_t n, size_t at, uint64_t key) {
+    while (at < n && refs[at].key == key) at++;
+    return at;
+}
+
+static const struct lint_pair *find_action(const struct lint_rule *r, const char *key) {
+    for (size_t i = 0; i < r->nacts; i++)
+        if (strcmp(r->acts[i].key, key) == 0) return &r->acts[i];
+    return NULL;
+}
+
+/* rules with the same match fields: exact duplicates (flagged in dup),
+ * and actions a later rule sets differently. Tags add up rather than
+ * override, so they never conflict. */
+static void check_groups(const struct lint_rule *lr, size_t n, unsigned char *dup,
+                         struct diag_list *d) {
+    struct key_ref *refs = malloc((n ? n : 1) * sizeof(*refs));
+    if (!refs) return;
+    for (size_t i = 0; i < n; i++) refs[i] = (struct key_ref){lr[i].match_key, i};
+    qsort(refs, n, sizeof(*refs), compare_key_ref);
+
+    for (size_t g = 0, e; g < n; g = e) {
+        e = key_run_end(refs, n, g, refs[g].key);
+        for (size_t j = g + 1; j < e; j++) {
+            const struct lint_rule *b = &lr[refs[j].idx];
+            size_t k = g;
+            for (; k < j; k++) {
+                const struct lint_rule *a = &lr[refs[k].idx];
+                if (same_match(a, b) && pairs_equal(a->acts, a->nacts, b->acts, b->nacts)) break;
+            }
+            if (k < j) {
+                dup[refs[j].idx] = 1;
+                diag_add(d, b->line, LINT_WARNING, "duplicate",
+                         "same match and actions as the rule at line %u", lr[refs[k].idx].line);
+                continue;
+            }
+            for (size_t i = 0; i < b->nacts; i++) {
+                const struct lint_pair *p = &b->acts[i];
+                if (strcmp(p->key, "tag") == 0 || (i && strcmp(b->acts[i - 1].key, p->key) == 0))
+                    continue;
+                for (k = g; k < j; k++) {
+                    const struct lint_rule *a = &lr[refs[k].idx];
+                    const struct lint_pair *q;
+                    if (!same_match(a, b) || !(q = find_action(a, p->key)) ||
+                        strcmp(q->value, p->value) == 0)
+                        continue;
+                    diag_add(d, b->line, LINT_WARNING, "conflict",
+                             "%s = %s overrides %s = %s from the rule at line %u with the same match",
+                             p->key, p->value, q->key, q->value, a->line);
+                    break;
+                }
+            }
+        }
+    }
+    free(refs);
+}
+
+/* the class a rule matches when it is one exact name, for the index below */
+static const char *exact_class(const struct lint_rule *r) {
+    const struct lint_pattern *p = r->pat[0];
+    return p && p->lit_count == 1 && p->lits[0].mode == MATCH_LIT_EXACT ? p->lits[0].text : NULL;
+}
+
+/*
+ * A subsuming rule sets each of the other's actions, so candidates come
+ * from an index of (action, value) pairs; of a rule's pairs the rarest is
+ * used. Rules matching one exact class are filed under the pair and that
+ * class, since only a rule matching the same class or a broader pattern
+ * can cover them: with "float = true" on hundreds of rules, each one
+ * then meets only its own class and the few broad rules.
+ */
+static void check_subsumed(const struct lint_rule *lr, size_t n, const unsigned char *dup,
+                           struct diag_list *d) {
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) total += lr[i].nacts;
+    if (!total) return;
+    struct key_ref *refs = malloc(total * sizeof(*refs));
+    if (!refs) return;
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char *cls = exact_class(&lr[i]);
+        for (size_t j = 0; j < lr[i].nacts; j++) {
+            uint64_t h = pair_hash(LINT_HASH_SEED, &lr[i].acts[j]);
+            refs[m++] = (struct key_ref){cls ? lint_hash(h, cls) : h, i};
+        }
+    }
+    qsort(refs, m, sizeof(*refs), compare_key_ref);
+
+    for (size_t b = 0; b < n; b++) {
+        const struct lint_rule *rb = &lr[b];
+        if (dup[b]) continue; /* already reported as a duplicate */
+        const char *cls = exact_class(rb);
+        size_t best[4] = {0}, best_size = SIZE_MAX;
+        for (size_t j = 0; j < rb->nacts; j++) {
+            uint64_t h = pair_hash(LINT_HASH_SEED, &rb->acts[j]);
+            size_t run[4];
+            run[0] = key_lower(refs, m, h);
+            run[1] = key_run_end(refs, m, run[0], h);
+            run[2] = run[3] = 0;
+            if (cls) {
+                uint64_t hc = lint_hash(h, cls);
+                run[2] = key_lower(refs, m, hc);
+                run[3] = key_run_end(refs, m, run[2], hc);
+            }
+            size_t size = run[1] - run[0] + run[3] - run[2];
+            if (size < best_size) {
+                memcpy(best, run, sizeof(best));
+                best_size = size;
+            }
+        }
+        const struct lint_rule *by = NULL;
+        for (int r = 0; r < 4 && !by; r += 2) {
+            for (size_t k = best[r]; k < best[r + 1]; k++) {
+                size_t a = refs[k].idx;
+                if (a == b) continue;
+                /* of two rules that cover each other, the later one goes */
+                if (subsumes(&lr[a], rb) && (a < b || !subsumes(rb, &lr[a]))) {
+                    by = &lr[a];
+                    break;
+                }
+            }
+        }
+        if (by)
+            diag_add(d, rb->line, LINT_WARNING, "subsumed",
+                     "the rule at line %u matches every window this one does and sets the same actions",
+                     by->line);
+    }
+    free(refs);
+}
+
+static void lint_rules(struct pattern_cache *pc, const struct ruleset *rs, struct diag_list *d) {
+    size_t n = rs->count, npairs = 0;
+    uint32_t no_pair = RF_MATCH_MASK | RF_BIT(RF_NAME) | RF_BIT(RF_DISPLAY_NAME);
+    for (size_t i = 0; i < n; i++)
+        npairs += (size_t)__builtin_popcount(rs->rules[i].present & ~no_pair) +
+                  rs->rules[i].extras_count;
+
+    struct lint_rule *lr = calloc(n, sizeof(*lr));
+    struct lint_pair *pairs = malloc((npairs ? npairs : 1) * sizeof(*pairs));
+    unsigned char *dup = calloc(n, 1);
+    if (!lr || !pairs || !dup) {
+        diag_add(d, 0, LINT_ERROR, "internal", "out of memory");
+        goto out;
+    }
+    const char *keys[RF_COUNT];
+    for (int f = 0; f < RF_COUNT; f++) keys[f] = rule_field_key((enum rule_field)f);
+
+    struct lint_pair *next = pairs;
+    for (size_t i = 0; i < n; i++) next = lint_rule_init(pc, &lr[i], &rs->rules[i], keys, next, d);
+    check_names(lr, n, d);
+    check_groups(lr, n, dup, d);
+    check_subsumed(lr, n, dup, d);
+
+out:
+    free(dup);
+    free(pairs);
+    free(lr);
+}
+
+/* --- files --- */
+
+struct lint_file {
+    char *path;
+    char *out;         /* this file's diagnostics, formatted */
+    size_t out_len;
+    size_t rules, errors, warnings;
+    int unreadable;
+    int done;
+};
+
+struct lint_ctx {
+    const struct lint_options *opt;
+    struct pattern_cache patterns;
+    pthread_mutex_t lock;
+    pthread_cond_t work;  /* a file was queued, or the walk ended */
+    pthread_cond_t done;  /* a file was linted */
+    struct lint_file **files;
+    size_t count, cap, next;
+    int walk_done;
+};
+
+static void lint_file(struct lint_ctx *c, struct lint_file *lf) {
+    struct diag_list d = {0};
+    struct ruleset rs;
+    if (ruleset_load(lf->path, &rs) != 0) {
+        lf->unreadable = 1;
+        diag_add(&d, 0, LINT_ERROR, "read", "cannot read the file");
+    } else {
+        lf->rules = rs.count;
+        if (rs.count) lint_rules(&c->patterns, &rs, &d);
+        ruleset_free(&rs);
+    }
+    if (!d.count) return;
+
+    qsort(d.items, d.count, sizeof(*d.items), compare_diag);
+    FILE *f = open_memstream(&lf->out, &lf->out_len);
+    for (size_t i = 0; i < d.count; i++) {
+        if (d.items[i].severity == LINT_ERROR) lf->errors++;
+        else lf->warnings++;
+        if (f) diag_write(f, lf->path, &d.items[i], c->opt->json);
+        free(d.items[i].message);
+    }
+    if (f) fclose(f);
+    free(d.items);
+}
+
+static void *lint_worker(void *arg) {
+    struct lint_ctx *c = arg;
+    for (;;) {
+        pthread_mutex_lock(&c->lock);
+        while (c->next == c->count && !c->walk_done) pthread_cond_wait(&c->work, &c->lock);
+        if (c->next == c->count) {
+            pthread_mutex_unlock(&c->lock);
+            return NULL;
+        }
+        struct lint_file *lf = c->files[c->next++];
+        pthread_mutex_unlock(&c->lock);
+
+        lint_file(c, lf);
+
+        pthread_mutex_lock(&c->lock);
+        lf->done = 1;
+        pthread_cond_signal(&c->done);
+        pthread_mutex_unlock(&c->lock);
+    }
+}
+
+/* --- discovery --- */
+
+static int queue_file(struct lint_ctx *c, const char *path) {
+    struct lint_file *lf = calloc(1, sizeof(*lf));
+    if (!lf || !(lf->path = strdup(path))) {
+        free(lf);
+        return -1;
+    }
+    int rc = 0;
+    pthread_mutex_lock(&c->lock);
+    if (c->count == c->cap) {
+        size_t cap = c->cap ? c->cap * 2 : 64;
+        struct lint_file **grown = realloc(c->files, cap * sizeof(*grown));
+        if (grown) {
+            c->files = grown;
+            c->cap = cap;
+        } else {
+            rc = -1;
+        }
+    }
+    if (rc == 0) {
+        c->files[c->count++] = lf;
+        pthread_cond_signal(&c->work);
+    }
+    pthread_mutex_unlock(&c->lock);
+    if (rc != 0) {
+        free(lf->path);
+        free(lf);
+    }
+    return rc;
+}
+
+static int compare_name(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int is_conf(const char *path) {
+    size_t n = strlen(path);
+    return n > 5 && strcmp(path + n - 5, ".conf") == 0;
+}
+
+/* queue every config below path in name order. A path given by the user
+ * is taken whatever it is called; a missing one is reported as unreadable. */
+static void walk_path(struct lint_ctx *c, const char *path, int named) {
+    struct stat st;
+    int ok = lstat(path, &st) == 0;
+    if (ok && S_ISLNK(st.st_mode)) {
+        ok = stat(path, &st) == 0;
+        /* linked files count, linked directories could loop */
+        if (ok && !named && S_ISDIR(st.st_mode)) return;
+    }
+    if (!ok) {
+        if (named) queue_file(c, path);
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        if (named || (S_ISREG(st.st_mode) && is_conf(path))) queue_file(c, path);
+        return;
+    }
+
+    DIR *dir = opendir(path);
+    if (!dir) return;
+    char **names = NULL;
+    size_t n = 0, cap = 0;
+    struct dirent *de;
+    while ((de = readdir(dir))) {
+        if (de->d_name[0] == '.') continue; /* ".", ".." and hidden, like .git */
+        if (n == cap) {
+            size_t ncap = cap ? cap * 2 : 32;
+            char **grown = realloc(names, ncap * sizeof(*grown));
+            if (!grown) break;
+            names = grown;
+            cap = ncap;
+        }
+        if ((names[n] = strdup(de->d_name))) n++;
+    }
+    closedir(dir);
+    qsort(names, n, sizeof(*names), compare_name);
+
+    size_t plen = strlen(path);
+    while (plen > 1 && path[plen - 1] == '/') plen--;
+    for (size_t i = 0; i < n; i++) {
+        size_t nlen = strlen(names[i]);
+        char *child = malloc(plen + nlen + 2);
+        if (child) {
+            memcpy(child, path, plen);
+            child[plen] = '/';
+            memcpy(child + plen + 1, names[i], nlen + 1);
+            walk_path(c, child, 0);
+            free(child);
+        }
+        free(names[i]);
+    }
+    free(names);
+}
+
+/* --- run --- */
+
+int lint_run(const char *const *paths, size_t count, const struct lint_options *opt,
+             FILE *out, struct lint_summary *sum) {
+    memset(sum, 0, sizeof(*sum));
+    struct lint_ctx *c = calloc(1, sizeof(*c));
+    if (!c) return -1;
+    c->opt = opt;
+    pattern_cache_init(&c->patterns);
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->work, NULL);
+    pthread_cond_init(&c->done, NULL);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = opt->jobs > 0 ? opt->jobs : cpus > 0 ? (int)cpus : 1;
+    if (jobs > LINT_MAX_JOBS) jobs = LINT_MAX_JOBS;
+
+    /* workers start on the first files while the walk is still going */
+    pthread_t tids[LINT_MAX_JOBS];
+    int started = 0;
+    while (started < jobs && pthread_create(&tids[started], NULL, lint_worker, c) == 0) started++;
+    for (size_t i = 0; i < count; i++) walk_path(c, paths[i], 1);
+    pthread_mutex_lock(&c->lock);
+    c->walk_done = 1;
+    pthread_cond_broadcast(&c->work);
+    pthread_mutex_unlock(&c->lock);
+    if (started == 0) lint_worker(c); /* no threads: lint everything here */
+
+    /* in discovery order, each file as soon as it is done */
+    for (size_t i = 0; i < c->count; i++) {
+        struct lint_file *lf = c->files[i];
+        pthread_mutex_lock(&c->lock);
+        while (!lf->done) pthread_cond_wait(&c->done, &c->lock);
+        pthread_mutex_unlock(&c->lock);
+
+        if (lf->out_len) {
+            fwrite(lf->out, 1, lf->out_len, out);
+            fflush(out);
+        }
+        if (lf->unreadable) sum->unreadable++;
+        else if (lf->rules) sum->files++;
+        else sum->skipped++;
+        sum->rules += lf->rules;
+        sum->errors += lf->errors;
+        sum->warnings += lf->warnings;
+        free(lf->out);
+        free(lf->path);
+        free(lf);
+    }
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+    sum->patterns = pattern_cache_count(&c->patterns);
+    pattern_cache_free(&c->patterns);
+    pthread_cond_destroy(&c->work);
+    pthread_cond_destroy(&c->done);
+    pthread_mutex_destroy(&c->lock);
+    free(c->files);
+    free(c);
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef HYPRWINDOWS_LINT_H
+#define HYPRWINDOWS_LINT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Lint every rules config in a tree of configs (one per machine or user).
+ *
+ * Directories are walked for *.conf files, skipping hidden entries and
+ * symlinked directories; files named directly are always taken. A pool
+ * of worker threads lints files while the walk goes on. Files without
+ * window rules are counted and otherwise ignored. Checks, per file:
+ *
+ *   duplicate-name  a name an earlier rule already uses
+ *   duplicate       same match fields and actions as an earlier rule
+ *   conflict        same match fields as an earlier rule, another value
+ *                   for an action both set
+ *   subsumed        another rule matches every window this one does and
+ *                   sets the same actions, so this one changes nothing
+ *   invalid-regex   a match pattern regcomp() rejects (an error)
+ *   unknown-key     a key Hyprland window rules do not have
+ *
+ * Each distinct pattern is compiled once per run, in a cache all workers
+ * share: fleets repeat the same patterns across machines.
+ *
+ * Diagnostics come out in discovery order as soon as a file is done, one
+ * per line: "path:line: warning: check: message", or with json set one
+ * object per line with the keys file, line, severity, check and message.
+ */
+
+struct lint_options {
+    int json;
+    int jobs;  /* worker threads, 0 = one per CPU */
+};
+
+struct lint_summary {
+    size_t files;      /* configs with window rules */
+    size_t skipped;    /* .conf files without any */
+    size_t unreadable;
+    size_t rules;
+    size_t errors;
+    size_t warnings;
+    size_t patterns;   /* distinct match patterns compiled */
+};
+
+/* lint paths (files or directories) and write diagnostics to out;
+ * 0 when the run completed, -1 when it could not be set up */
+int lint_run(const char *const *paths, size_t count, const struct lint_options *opt,
+             FILE *out, struct lint_summary *sum);
+
+#endif
@@ -1,31 +1,378 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "actions.h"
+#include "diff.h"
+#include "hyprctl.h"
+#include "lint.h"
+#include "rules.h"
+#include "rulesjson.h"
+#include "stats.h"
 #include "ui.h"
+#include "util.h"
 
 static void usage(const char *prog) {
     fprintf(stderr,
             "Usage:\n"
-            "  %s          Launch TUI\n"
-            "  %s --help   Show this help\n",
-            prog, prog);
+            "  %s              Launch TUI\n"
+            "  %s --no-splash  Launch TUI without the splash screen\n"
+            "  %s diff A B     Compare the rules in two files\n"
+            "  %s summarize [--json] [FILE]\n"
+            "                  Rule counts by tag, workspace and action\n"
+            "  %s export --json [FILE]\n"
+            "                  Print the rules as JSON\n"
+            "  %s import --json [IN|-] [FILE]\n"
+            "                  Append rules from JSON (default: stdin) to FILE\n"
+            "  %s lint [--json] [-j N] DIR|FILE...\n"
+            "                  Check every *.conf below DIR for rule problems\n"
+            "  %s --help       Show this help\n"
+            "\n"
+            "The splash can also be turned off with 'splash = no' in\n"
+            "~/.config/hyprwindows/config\n",
+            prog, prog, prog, prog, prog, prog, prog, prog);
 }
 
-int main(int argc, char **argv) {
-    if (argc == 1) {
-        return run_tui();
+/* "diff A B": exit 0 when the rules match, 1 when they differ, 2 on error */
+static int cmd_diff(const char *path_a, const char *path_b) {
+    struct ruleset a = {0}, b = {0};
+    char *pa = expand_home(path_a);
+    char *pb = expand_home(path_b);
+    int rc = 2;
+
+    if (ruleset_load(pa ? pa : path_a, &a) != 0) {
+        fprintf(stderr, "Failed to load rules from %s\n", path_a);
+        goto out;
+    }
+    if (ruleset_load(pb ? pb : path_b, &b) != 0) {
+        fprintf(stderr, "Failed to load rules from %s\n", path_b);
+        goto out;
     }
 
-    if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
-        usage(argv[0]);
-        return 0;
+    struct rule_diff d;
+    if (rule_diff(&a, &b, &d) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        goto out;
+    }
+    printf("--- %s\n+++ %s\n", path_a, path_b);
+    rule_diff_print(stdout, &a, &b, &d);
+    rc = (d.added || d.removed || d.moved || d.changed) ? 1 : 0;
+    rule_diff_free(&d);
+
+out:
+    ruleset_free(&a);
+    ruleset_free(&b);
+    free(pa);
+    free(pb);
+    return rc;
+}
+
+/* per rule: matches no open window; NULL when Hyprland can't be asked */
+static unsigned char *unused_rules(const struct ruleset *rs) {
+    struct clients cl = {0};
+    if (hyprctl_clients(&cl) != 0 || cl.count == 0) {
+        clients_free(&cl);
+        return NULL;
+    }
+    unsigned char *unused = calloc(rs->count ? rs->count : 1, 1);
+    for (size_t i = 0; unused && i < rs->count; i++)
+        unused[i] = !rule_matches_any_client(&rs->rules[i], &cl);
+    clients_free(&cl);
+    return unused;
+}
+
+/* FILE with ~ expanded, or the detected config when path is NULL */
+static char *rules_path(const char *path) {
+    if (path) return expand_home(path);
+    char *detected = hypr_find_rules_config();
+    if (!detected) fprintf(stderr, "No window rules config found; pass FILE\n");
+    return detected;
+}
+
+/* "summarize [--json] [FILE]": exit 0, or 2 on error */
+static int cmd_summarize(int argc, char **argv) {
+    int json = 0;
+    const char *path = NULL;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = 1;
+        else if (!path && argv[i][0] != '-') path = argv[i];
+        else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    char *file = rules_path(path);
+    if (!file) return 2;
+
+    struct ruleset rs = {0};
+    int rc = 2;
+    if (ruleset_load(file, &rs) != 0) {
+        fprintf(stderr, "Failed to load rules from %s\n", file);
+        goto out;
+    }
+    unsigned char *unused = unused_rules(&rs);
+    struct rule_stats stats;
+    int ok = rule_stats_compute(&stats, &rs, unused) == 0;
+    free(unused);
+    if (!ok) {
+        fprintf(stderr, "Out of memory\n");
+        goto out;
+    }
+    if (json) {
+        rule_stats_print_json(stdout, &stats);
+    } else {
+        printf("%s\n", file);
+        rule_stats_print(stdout, &stats, 20);
+    }
+    rule_stats_free(&stats);
+    rc = 0;
+
+out:
+    ruleset_free(&rs);
+    free(file);
+    return rc;
+}
+
+/* "export --json [FILE]": exit 0, or 2 on error */
+static int cmd_export(int argc, char **argv) {
+    int json = 0;
+    const char *path = NULL;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = 1;
+        else if (!path && argv[i][0] != '-') path = argv[i];
+        else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (!json) {
+        fprintf(stderr, "export: pass --json (the only format)\n");
+        return 2;
+    }
+    char *file = rules_path(path);
+    if (!file) return 2;
+
+    struct ruleset rs = {0};
+    int rc = 2;
+    if (ruleset_load(file, &rs) != 0) {
+        fprintf(stderr, "Failed to load rules from %s\n", file);
+        goto out;
+    }
+    /* one large buffer; the writer emits many small pieces */
+    setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+    if (rules_json_write(stdout, &rs) != 0 || fflush(stdout) != 0) {
+        fprintf(stderr, "Write error\n");
+        goto out;
+    }
+    rc = 0;
+
+out:
+    ruleset_free(&rs);
+    free(file);
+    return rc;
+}
+
+/* "import --json [IN|-] [FILE]": append the rules in IN to the config
+ * file, leaving what is already there untouched. Exit 0, or 2 on error. */
+static int cmd_import(int argc, char **argv) {
+    int json = 0;
+    const char *in = NULL, *path = NULL;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = 1;
+        else if (!in && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)) in = argv[i];
+        else if (!path && argv[i][0] != '-') path = argv[i];
+        else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (!json) {
+        fprintf(stderr, "import: pass --json (the only format)\n");
+        return 2;
     }
 
-    if (strcmp(argv[1], "--tui") == 0 || strcmp(argv[1], "-t") == 0) {
-        return run_tui();
+    FILE *src = stdin;
+    if (in && strcmp(in, "-") != 0) {
+        char *p = expand_home(in);
+        src = fopen(p ? p : in, "r");
+        free(p);
+        if (!src) {
+            fprintf(stderr, "Cannot open %s\n", in);
+            return 2;
+        }
+    }
+    struct ruleset rs;
+    char err[256];
+    int ok = rules_json_read(src, &rs, err, sizeof(err)) == 0;
+    if (src != stdin) fclose(src);
+    if (!ok) {
+        fprintf(stderr, "%s: %s\n", in && strcmp(in, "-") != 0 ? in : "stdin", err);
+        return 2;
+    }
+
+    /* appended after the rules already there, through the same batch insert
+     * as the TUI; a config that does not exist yet starts empty */
+    char *file = rules_path(path);
+    struct ruleset cur = {0};
+    int *at = malloc((rs.count ? rs.count : 1) * sizeof(int));
+    const struct rule **add = malloc((rs.count ? rs.count : 1) * sizeof(*add));
+    FILE *f = NULL;
+    int rc = 2;
+    if (!file || !at || !add) goto out;
+    if (access(file, F_OK) == 0 && ruleset_load(file, &cur) != 0) {
+        fprintf(stderr, "Cannot parse %s\n", file);
+        goto out;
+    }
+    size_t old_n = cur.count;
+    for (size_t i = 0; i < rs.count; i++) {
+        at[i] = (int)(old_n + i);
+        add[i] = &rs.rules[i];
+    }
+    if (ruleset_insert(&cur, at, add, rs.count) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        goto out;
+    }
+
+    f = fopen(file, "a+");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", file);
+        goto out;
+    }
+    /* start on a line of our own; a read must be followed by a seek before
+     * writing to the same stream */
+    int newline = fseek(f, -1, SEEK_END) == 0 && fgetc(f) != '\n';
+    fseek(f, 0, SEEK_END);
+    if (newline) fputc('\n', f);
+    for (size_t i = old_n; i < cur.count; i++) rule_write(f, &cur.rules[i]);
+    int werr = ferror(f);
+    int cerr = fclose(f);
+    if (cerr != 0 || werr) {
+        fprintf(stderr, "Write error on %s\n", file);
+        goto out;
+    }
+    printf("Imported %zu rule%s into %s (%zu in total)\n", rs.count, rs.count == 1 ? "" : "s",
+           file, cur.count);
+    rc = 0;
+
+out:
+    ruleset_free(&cur);
+    ruleset_free(&rs);
+    free(add);
+    free(at);
+    free(file);
+    return rc;
+}
+
+/* "lint [--json] [-j N] DIR|FILE...": exit 0 when nothing was found, 1 when
+ * something was, 2 on error or when there were no configs to check */
+static int cmd_lint(int argc, char **argv) {
+    struct lint_options opt = {0};
+    const char **paths = malloc((argc ? (size_t)argc : 1) * sizeof(*paths));
+    size_t npaths = 0;
+    if (!paths) return 2;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            opt.json = 1;
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+            opt.jobs = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            free(paths);
+            return 2;
+        } else {
+            paths[npaths++] = argv[i];
+        }
+    }
+    if (npaths == 0) {
+        fprintf(stderr, "lint: pass at least one directory or file\n");
+        free(paths);
+        return 2;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    struct lint_summary sum;
+    int rc = lint_run(paths, npaths, &opt, stdout, &sum);
+    free(paths);
+    if (rc != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 2;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    fprintf(stderr, "%zu config%s, %zu rules: %zu error%s, %zu warning%s (%zu patterns, %.2fs)\n",
+            sum.files, sum.files == 1 ? "" : "s", sum.rules, sum.errors, sum.errors == 1 ? "" : "s",
+            sum.warnings, sum.warnings == 1 ? "" : "s", sum.patterns, secs);
+    if (sum.files == 0 && sum.unreadable == 0) {
+        fprintf(stderr, "lint: no window rules found\n");
+        return 2;
+    }
+    return sum.errors || sum.warnings ? 1 : 0;
+}
+
+/* read "splash = yes|no" from ~/.config/hyprwindows/config (default: yes) */
+static int config_splash_enabled(void) {
+    char *path = expand_home("~/.config/hyprwindows/config");
+    if (!path) return 1;
+    char *buf = read_file(path, NULL);
+    free(path);
+    if (!buf) return 1;
+
+    int splash = 1;
+    for (char *line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+        while (*line == ' ' || *line == '\t') line++;
+        if (strncmp(line, "splash", 6) != 0) continue;
+        char *eq = strchr(line + 6, '=');
+        if (!eq) continue;
+        char *val = eq + 1;
+        while (*val == ' ' || *val == '\t') val++;
+        splash = !(strncmp(val, "no", 2) == 0 || strncmp(val, "false", 5) == 0 ||
+                   strncmp(val, "off", 3) == 0 || val[0] == '0');
+    }
+    free(buf);
+    return splash;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "diff") == 0) {
+        if (argc != 4) {
+            usage(argv[0]);
+            return 2;
+        }
+        return cmd_diff(argv[2], argv[3]);
+    }
+    if (argc >= 2 && strcmp(argv[1], "summarize") == 0)
+        return cmd_summarize(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "export") == 0)
+        return cmd_export(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "import") == 0)
+        return cmd_import(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "lint") == 0)
+        return cmd_lint(argc - 2, argv + 2);
+
+    int splash = config_splash_enabled();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            usage(argv[0]);
+            return 0;
+        }
+        if (strcmp(argv[i], "--no-splash") == 0) {
+            splash = 0;
+            continue;
+        }
+        if (strcmp(argv[i], "--tui") == 0 || strcmp(argv[i], "-t") == 0) {
+            continue;
+        }
+
+        fprintf(stderr, "Unknown option: %s\n", argv[i]);
+        usage(argv[0]);
+        return 1;
     }
 
-    fprintf(stderr, "Unknown option: %s\n", argv[1]);
-    usage(argv[0]);
-    return 1;
+    return run_tui(splash);
 }
@@ -0,0 +1,350 @@
+#include "match.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* --- literal patterns --- */
+
+static int is_meta(char c) {
+    return c != '\0' && strchr(".[]()*+?{}|^$\\", c) != NULL;
+}
+
+/* parse one alternative ("lit", "lit.*", ".*lit.*") into out; -1 if not a plain literal */
+static int parse_literal(const char *p, size_t n, int anchored_start, int anchored_end,
+                         struct match_lit *out) {
+    int lead = n >= 2 && p[0] == '.' && p[1] == '*';
+    if (lead) { p += 2; n -= 2; }
+    int trail = n >= 2 && p[n - 2] == '.' && p[n - 1] == '*' && (n < 3 || p[n - 3] != '\\');
+    if (trail) n -= 2;
+    if (n == 0) return -1;
+
+    char *text = malloc(n + 1);
+    if (!text) return -1;
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        char c = p[i];
+        if (c == '\\') {
+            if (i + 1 >= n || !is_meta(p[i + 1])) { free(text); return -1; }
+            c = p[++i];
+        } else if (is_meta(c)) {
+            free(text);
+            return -1;
+        }
+        text[len++] = (char)tolower((unsigned char)c);
+    }
+    text[len] = '\0';
+
+    int start = anchored_start && !lead;
+    int end = anchored_end && !trail;
+    if (!start && end) { free(text); return -1; } /* suffix match: leave to regex */
+
+    out->text = text;
+    out->len = len;
+    out->mode = start ? (end ? MATCH_LIT_EXACT : MATCH_LIT_PREFIX) : MATCH_LIT_CONTAINS;
+    return 0;
+}
+
+void match_literals_free(struct match_lit *lits, size_t count) {
+    for (size_t i = 0; i < count; i++) free(lits[i].text);
+    free(lits);
+}
+
+int match_literals(const char *pattern, struct match_lit **lits, size_t *count) {
+    *lits = NULL;
+    *count = 0;
+    size_t n = strlen(pattern);
+    const char *p = pattern;
+    int as = 0, ae = 0;
+    if (n > 0 && p[0] == '^') { as = 1; p++; n--; }
+    if (n > 0 && p[n - 1] == '$' && (n < 2 || p[n - 2] != '\\')) { ae = 1; n--; }
+
+    /* optional single outer group holding the alternatives */
+    int grouped = n >= 2 && p[0] == '(' && p[n - 1] == ')';
+    if (grouped) { p++; n -= 2; }
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] == '\\') { i++; continue; }
+        if (p[i] == '(' || p[i] == ')') return -1;
+        if (p[i] == '|' && !grouped) return -1;
+    }
+
+    size_t cap = 1;
+    for (size_t i = 0; i < n; i++) if (p[i] == '|') cap++;
+    struct match_lit *out = calloc(cap, sizeof(*out));
+    if (!out) return -1;
+
+    size_t used = 0, start = 0;
+    for (size_t i = 0; i <= n; i++) {
+        if (i < n && p[i] == '\\') { i++; continue; }
+        if (i < n && p[i] != '|') continue;
+        if (parse_literal(p + start, i - start, as, ae, &out[used]) != 0) {
+            match_literals_free(out, used);
+            return -1;
+        }
+        used++;
+        start = i + 1;
+    }
+    *lits = out;
+    *count = used;
+    return 0;
+}
+
+static int lit_matches(const struct match_lit *l, const char *s) {
+    switch (l->mode) {
+    case MATCH_LIT_EXACT:
+        return strlen(s) == l->len && strncasecmp(s, l->text, l->len) == 0;
+    case MATCH_LIT_PREFIX:
+        return strncasecmp(s, l->text, l->len) == 0;
+    case MATCH_LIT_CONTAINS:
+        return strcasestr(s, l->text) != NULL;
+    }
+    return 0;
+}
+
+/* --- cost model --- */
+
+/*
+ * Rough per-op cost in arbitrary units and the share of windows expected
+ * to pass, in permille. Anchored literals touch a few bytes and rarely
+ * pass; contains scans the whole subject; a regex pays for the automaton
+ * walk and is often written loosely. Flags split windows about evenly.
+ */
+static void op_rank(struct match_op *o) {
+    unsigned cost = 1, pass = 500;
+    switch (o->op) {
+    case MOP_FAIL:
+        cost = 0;
+        pass = 0;
+        break;
+    case MOP_LITERALS:
+        cost = 0;
+        pass = 0;
+        for (size_t i = 0; i < o->lit_count; i++) {
+            const struct match_lit *l = &o->lits[i];
+            cost += l->mode == MATCH_LIT_CONTAINS ? 8 + (unsigned)l->len : 2;
+            pass += l->mode == MATCH_LIT_EXACT ? 30 : l->mode == MATCH_LIT_PREFIX ? 60 : 150;
+        }
+        break;
+    case MOP_REGEX:
+        cost = 200;
+        pass = 300;
+        break;
+    case MOP_FLAG:
+        cost = 1;
+        pass = 500;
+        break;
+    case MOP_INT:
+        cost = 1;
+        pass = 200;
+        break;
+    }
+    if (pass > 950) pass = 950;
+    o->rank = cost * 1000 / (1000 - pass);
+}
+
+static int compare_op_rank(const void *a, const void *b) {
+    const struct match_op *x = a, *y = b;
+    return (x->rank > y->rank) - (x->rank < y->rank);
+}
+
+/* --- compile / eval --- */
+
+static const enum rule_field subject_field[] = {
+    [MS_CLASS] = RF_CLASS,
+    [MS_TITLE] = RF_TITLE,
+    [MS_INITIAL_CLASS] = RF_INITIAL_CLASS,
+    [MS_INITIAL_TITLE] = RF_INITIAL_TITLE,
+};
+
+static int compile_pattern(struct match_op *o, enum match_subject subject, const char *pattern) {
+    memset(o, 0, sizeof(*o));
+    o->subject = subject;
+    if (match_literals(pattern, &o->lits, &o->lit_count) == 0) {
+        o->op = MOP_LITERALS;
+    } else {
+        o->re = malloc(sizeof(regex_t));
+        if (!o->re) return -1;
+        if (regcomp(o->re, pattern, MATCH_REGEX_FLAGS) == 0) {
+            o->op = MOP_REGEX;
+        } else {
+            free(o->re);
+            o->re = NULL;
+            o->op = MOP_FAIL;
+        }
+    }
+    op_rank(o);
+    return 0;
+}
+
+static void op_free(struct match_op *o) {
+    match_literals_free(o->lits, o->lit_count);
+    if (o->re) {
+        regfree(o->re);
+        free(o->re);
+    }
+}
+
+/* match:workspace takes an id or "name:..."; selectors like "w[t1]" need
+ * state hyprctl doesn't report and are left unchecked, as match:tag is */
+static int compile_workspace(struct match_op *o, const char *sel) {
+    memset(o, 0, sizeof(*o));
+    char *end = NULL;
+    long id = strtol(sel, &end, 10);
+    if (end != sel && *end == '\0') {
+        o->op = MOP_INT;
+        o->subject = MS_WORKSPACE;
+        o->value = (int)id;
+    } else if (strncmp(sel, "name:", 5) == 0) {
+        o->op = MOP_LITERALS;
+        o->subject = MS_WORKSPACE_NAME;
+        o->lits = calloc(1, sizeof(struct match_lit));
+        if (!o->lits || !(o->lits->text = strdup(sel + 5))) {
+            free(o->lits);
+            o->lits = NULL;
+            return -1;
+        }
+        for (char *t = o->lits->text; *t; t++) *t = (char)tolower((unsigned char)*t);
+        o->lits->len = strlen(o->lits->text);
+        o->lits->mode = MATCH_LIT_EXACT;
+        o->lit_count = 1;
+    } else {
+        return 1;
+    }
+    op_rank(o);
+    return 0;
+}
+
+static const struct { enum rule_field field; enum match_subject subject; } flag_fields[] = {
+    {RF_MATCH_XWAYLAND, MS_XWAYLAND},
+    {RF_MATCH_FLOAT, MS_FLOATING},
+    {RF_MATCH_FULLSCREEN, MS_FULLSCREEN},
+    {RF_MATCH_PIN, MS_PINNED},
+};
+
+#define MATCH_MAX_OPS (sizeof(subject_field) / sizeof(subject_field[0]) + \
+                       sizeof(flag_fields) / sizeof(flag_fields[0]) + 1)
+
+int match_compile(struct match_prog *p, const struct rule *r) {
+    memset(p, 0, sizeof(*p));
+    if (!(r->present & RF_MATCH_MASK)) return 0;
+
+    p->ops = calloc(MATCH_MAX_OPS, sizeof(struct match_op));
+    if (!p->ops) return -1;
+    for (size_t s = 0; s < sizeof(subject_field) / sizeof(subject_field[0]); s++) {
+        if (!rule_has(r, subject_field[s])) continue;
+        if (compile_pattern(&p->ops[p->count], (enum match_subject)s,
+                            rule_get(r, subject_field[s])) != 0) {
+            match_free(p);
+            return -1;
+        }
+        p->count++;
+    }
+    for (size_t k = 0; k < sizeof(flag_fields) / sizeof(flag_fields[0]); k++) {
+        if (!rule_has(r, flag_fields[k].field)) continue;
+        struct match_op *o = &p->ops[p->count++];
+        o->op = MOP_FLAG;
+        o->subject = flag_fields[k].subject;
+        o->value = rule_get_bool(r, flag_fields[k].field);
+        op_rank(o);
+    }
+    if (rule_has(r, RF_MATCH_WORKSPACE)) {
+        int rc = compile_workspace(&p->ops[p->count], rule_get(r, RF_MATCH_WORKSPACE));
+        if (rc < 0) {
+            match_free(p);
+            return -1;
+        }
+        if (rc == 0) p->count++;
+    }
+    /* tag matching is left out — hyprctl doesn't expose window tags,
+       so match:tag is treated as always matching */
+    qsort(p->ops, p->count, sizeof(struct match_op), compare_op_rank);
+    return 0;
+}
+
+static const char *subject_str(const struct client *c, enum match_subject s) {
+    switch (s) {
+    case MS_CLASS: return c->class_name;
+    case MS_TITLE: return c->title;
+    case MS_INITIAL_CLASS: return c->initial_class;
+    case MS_INITIAL_TITLE: return c->initial_title;
+    case MS_WORKSPACE_NAME: return c->workspace_name;
+    default: return NULL;
+    }
+}
+
+static int subject_int(const struct client *c, enum match_subject s) {
+    switch (s) {
+    case MS_FLOATING: return c->floating;
+    case MS_XWAYLAND: return c->xwayland;
+    case MS_FULLSCREEN: return c->fullscreen;
+    case MS_PINNED: return c->pinned;
+    case MS_WORKSPACE: return c->workspace_id;
+    default: return 0;
+    }
+}
+
+int match_eval(const struct match_prog *p, const struct client *c) {
+    for (size_t i = 0; i < p->count; i++) {
+        const struct match_op *o = &p->ops[i];
+        const char *s;
+        switch (o->op) {
+        case MOP_FAIL:
+            return 0;
+        case MOP_LITERALS: {
+            if (!(s = subject_str(c, o->subject))) return 0;
+            size_t k = 0;
+            while (k < o->lit_count && !lit_matches(&o->lits[k], s)) k++;
+            if (k == o->lit_count) return 0;
+            break;
+        }
+        case MOP_REGEX:
+            if (!(s = subject_str(c, o->subject))) return 0;
+            if (regexec(o->re, s, 0, NULL, 0) != 0) return 0;
+            break;
+        case MOP_FLAG:
+            if ((subject_int(c, o->subject) != 0) != (o->value != 0)) return 0;
+            break;
+        case MOP_INT:
+            if (subject_int(c, o->subject) != o->value) return 0;
+            break;
+        }
+    }
+    return 1;
+}
+
+unsigned match_subjects(const struct match_prog *p) {
+    unsigned bits = 0;
+    for (size_t i = 0; i < p->count; i++) bits |= 1u << p->ops[i].subject;
+    return bits;
+}
+
+void match_free(struct match_prog *p) {
+    if (!p) return;
+    for (size_t i = 0; i < p->count; i++) op_free(&p->ops[i]);
+    free(p->ops);
+    memset(p, 0, sizeof(*p));
+}
+
+/* --- per-ruleset programs --- */
+
+int match_set_build(struct match_set *s, const struct ruleset *rs) {
+    memset(s, 0, sizeof(*s));
+    s->progs = calloc(rs->count ? rs->count : 1, sizeof(struct match_prog));
+    if (!s->progs) return -1;
+    for (size_t i = 0; i < rs->count; i++) {
+        if (match_compile(&s->progs[i], &rs->rules[i]) != 0) {
+            match_set_free(s);
+            return -1;
+        }
+        s->count++;
+    }
+    return 0;
+}
+
+void match_set_free(struct match_set *s) {
+    if (!s) return;
+    for (size_t i = 0; i < s->count; i++) match_free(&s->progs[i]);
+    free(s->progs);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,90 @@
+#ifndef HYPRWINDOWS_MATCH_H
+#define HYPRWINDOWS_MATCH_H
+
+#include <regex.h>
+#include <stddef.h>
+
+#include "hyprctl.h"
+#include "rules.h"
+
+/*
+ * Compiled rule matching.
+ *
+ * Each rule's match fields become a short program of predicates that all
+ * have to pass. A pattern that is only literal alternatives (exact,
+ * prefix, contains) is compared directly; anything else keeps a compiled
+ * regex_t (MATCH_REGEX_FLAGS). match:xwayland, float,
+ * fullscreen, pin and workspace become flag and number predicates on the
+ * client fields, which cost next to nothing. Predicates are ordered by
+ * estimated cost over the chance of rejecting a window, so most rules
+ * fail on a cheap check before any regex runs.
+ */
+
+/* how every rule pattern is compiled: POSIX extended, case-insensitive */
+#define MATCH_REGEX_FLAGS (REG_EXTENDED | REG_NOSUB | REG_ICASE)
+
+enum match_lit_mode { MATCH_LIT_EXACT, MATCH_LIT_PREFIX, MATCH_LIT_CONTAINS };
+
+struct match_lit {
+    char *text;  /* lowercased */
+    size_t len;
+    enum match_lit_mode mode;
+};
+
+/* split a pattern into literal alternatives ("^(a|b.*|.*c.*)$"); returns
+ * -1 when it needs a regex (suffix matches included) */
+int match_literals(const char *pattern, struct match_lit **lits, size_t *count);
+void match_literals_free(struct match_lit *lits, size_t count);
+
+enum match_subject {
+    MS_CLASS,
+    MS_TITLE,
+    MS_INITIAL_CLASS,
+    MS_INITIAL_TITLE,
+    MS_WORKSPACE_NAME,
+    MS_FLOATING,
+    MS_XWAYLAND,
+    MS_FULLSCREEN,
+    MS_PINNED,
+    MS_WORKSPACE,
+};
+
+enum match_opcode {
+    MOP_FAIL,      /* pattern that never matches (bad regex) */
+    MOP_LITERALS,  /* any of lits */
+    MOP_REGEX,
+    MOP_FLAG,      /* subject != 0 equals value */
+    MOP_INT,       /* subject == value */
+};
+
+struct match_op {
+    enum match_opcode op;
+    enum match_subject subject;
+    unsigned rank;  /* cost / (1 - pass rate), lower runs first */
+    int value;
+    struct match_lit *lits;
+    size_t lit_count;
+    regex_t *re;
+};
+
+struct match_prog {
+    struct match_op *ops;  /* ANDed, cheapest first; none = every window */
+    size_t count;
+};
+
+int match_compile(struct match_prog *p, const struct rule *r);
+int match_eval(const struct match_prog *p, const struct client *c);
+/* subjects p reads, bit (1u << subject) each */
+unsigned match_subjects(const struct match_prog *p);
+void match_free(struct match_prog *p);
+
+/* one program per rule of a ruleset, same indices */
+struct match_set {
+    struct match_prog *progs;
+    size_t count;
+};
+
+int match_set_build(struct match_set *s, const struct ruleset *rs);
+void match_set_free(struct match_set *s);
+
+#endif
@@ -0,0 +1,281 @@
+#include "merge.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* --- identity keys --- */
+
+static uint64_t key_mix(uint64_t h, const char *s) {
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ull;
+    }
+    h ^= 0xff;
+    return h * 1099511628211ull;
+}
+
+/* splitmix64 finaliser: spreads keys over the table and derives the
+ * n-th occurrence of an identity */
+static uint64_t key_scramble(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t rule_identity(const struct rule *r) {
+    uint64_t h = 14695981039346656037ull;
+    const char *name = rule_get(r, RF_NAME);
+    if (name && *name) return key_mix(key_mix(h, "n"), name);
+
+    if (r->present & RF_MATCH_MASK) {
+        for (int f = 0; f < RF_HEAP_COUNT; f++) {
+            if (!(RF_MATCH_MASK & RF_BIT(f)) || !rule_has(r, f)) continue;
+            char tag[2] = {(char)('a' + f), '\0'};
+            h = key_mix(key_mix(h, tag), rule_get(r, f));
+        }
+        return h;
+    }
+    /* nothing to identify it by but its content */
+    return rule_fingerprint(r) ^ 0x9e3779b97f4a7c15ull;
+}
+
+struct key_count {
+    uint64_t raw;
+    size_t seen;
+    int used;
+};
+
+static size_t table_size(size_t n) {
+    size_t cap = 16;
+    while (cap < n * 2) cap <<= 1;
+    return cap;
+}
+
+int merge_identities(const struct ruleset *rs, uint64_t *keys) {
+    size_t cap = table_size(rs->count);
+    struct key_count *tab = calloc(cap, sizeof(*tab));
+    if (!tab) return -1;
+
+    for (size_t i = 0; i < rs->count; i++) {
+        uint64_t raw = rule_identity(&rs->rules[i]);
+        size_t slot = (size_t)key_scramble(raw) & (cap - 1);
+        while (tab[slot].used && tab[slot].raw != raw) slot = (slot + 1) & (cap - 1);
+        if (!tab[slot].used) {
+            tab[slot].used = 1;
+            tab[slot].raw = raw;
+        }
+        size_t n = tab[slot].seen++;
+        keys[i] = n == 0 ? raw : key_scramble(raw + n);
+    }
+    free(tab);
+    return 0;
+}
+
+/* --- base snapshot --- */
+
+int merge_base_init(struct merge_base *b, const struct ruleset *rs) {
+    memset(b, 0, sizeof(*b));
+    size_t n = rs->count;
+    b->keys = malloc((n ? n : 1) * sizeof(uint64_t));
+    b->prints = malloc((n ? n : 1) * sizeof(uint64_t));
+    if (!b->keys || !b->prints || merge_identities(rs, b->keys) != 0) {
+        merge_base_free(b);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) b->prints[i] = rule_fingerprint(&rs->rules[i]);
+    b->count = n;
+    return 0;
+}
+
+void merge_base_free(struct merge_base *b) {
+    if (!b) return;
+    free(b->keys);
+    free(b->prints);
+    memset(b, 0, sizeof(*b));
+}
+
+/* --- merge --- */
+
+struct merge_slot {
+    uint64_t key;
+    uint64_t base_print;
+    int base, disk, mine; /* index on each side, -1 when absent */
+    int used;
+};
+
+static struct merge_slot *slot_for(struct merge_slot *tab, size_t cap, uint64_t key) {
+    size_t i = (size_t)key_scramble(key) & (cap - 1);
+    while (tab[i].used && tab[i].key != key) i = (i + 1) & (cap - 1);
+    if (!tab[i].used) {
+        tab[i].used = 1;
+        tab[i].key = key;
+        tab[i].base = tab[i].disk = tab[i].mine = -1;
+    }
+    return &tab[i];
+}
+
+/* decide one identity; returns 0 when the rule is dropped */
+static int resolve_slot(const struct merge_slot *s, const struct ruleset *disk,
+                        const struct ruleset *mine, struct merge_entry *e,
+                        size_t *disk_changes) {
+    const struct rule *d = s->disk >= 0 ? &disk->rules[s->disk] : NULL;
+    const struct rule *m = s->mine >= 0 ? &mine->rules[s->mine] : NULL;
+    uint64_t dp = d ? rule_fingerprint(d) : 0;
+    uint64_t mp = m ? rule_fingerprint(m) : 0;
+    int has_base = s->base >= 0;
+
+    e->disk = d;
+    e->mine = m;
+    e->conflict = MERGE_CLEAN;
+    e->take_disk = 0;
+
+    if (d && m) {
+        if (dp == mp) return 1;
+        if (!has_base) {
+            e->conflict = MERGE_BOTH_ADDED;
+        } else if (dp == s->base_print) {
+            return 1;
+        } else if (mp == s->base_print) {
+            e->take_disk = 1;
+            (*disk_changes)++;
+        } else {
+            e->conflict = MERGE_BOTH_CHANGED;
+        }
+        return 1;
+    }
+    if (d) {
+        if (!has_base) {
+            e->take_disk = 1;
+            (*disk_changes)++;
+            return 1;
+        }
+        if (dp == s->base_print) return 0; /* deleted in memory */
+        e->conflict = MERGE_MINE_DELETED;
+        return 1;
+    }
+    if (m) {
+        if (!has_base) return 1;
+        if (mp == s->base_print) {
+            (*disk_changes)++; /* deleted on disk */
+            return 0;
+        }
+        e->conflict = MERGE_DISK_DELETED;
+        return 1;
+    }
+    return 0; /* deleted on both sides */
+}
+
+int merge_rules(const struct merge_base *base, const struct ruleset *disk,
+                const struct ruleset *mine, struct merge_result *out) {
+    memset(out, 0, sizeof(*out));
+    size_t nd = disk->count, nm = mine->count;
+    size_t cap = table_size(base->count + nd + nm);
+
+    struct merge_slot *tab = calloc(cap, sizeof(*tab));
+    uint64_t *dkeys = malloc((nd ? nd : 1) * sizeof(uint64_t));
+    uint64_t *mkeys = malloc((nm ? nm : 1) * sizeof(uint64_t));
+    struct merge_slot **dslot = malloc((nd ? nd : 1) * sizeof(*dslot));
+    struct merge_slot **mslot = malloc((nm ? nm : 1) * sizeof(*mslot));
+    size_t *bucket = calloc(nm + 2, sizeof(size_t));
+    size_t *anchor = malloc((nd ? nd : 1) * sizeof(size_t));
+    out->entries = malloc((nd + nm ? nd + nm : 1) * sizeof(struct merge_entry));
+    int rc = -1;
+    if (!tab || !dkeys || !mkeys || !dslot || !mslot || !bucket || !anchor || !out->entries)
+        goto done;
+    if (merge_identities(disk, dkeys) != 0 || merge_identities(mine, mkeys) != 0) goto done;
+
+    for (size_t i = 0; i < base->count; i++) {
+        struct merge_slot *s = slot_for(tab, cap, base->keys[i]);
+        s->base = (int)i;
+        s->base_print = base->prints[i];
+    }
+    for (size_t i = 0; i < nd; i++) {
+        dslot[i] = slot_for(tab, cap, dkeys[i]);
+        dslot[i]->disk = (int)i;
+    }
+    for (size_t i = 0; i < nm; i++) {
+        mslot[i] = slot_for(tab, cap, mkeys[i]);
+        mslot[i]->mine = (int)i;
+    }
+
+    /* rules missing from memory are placed after the nearest preceding
+     * disk rule that memory also has (bucket 0 = before everything) */
+    size_t last = 0;
+    for (size_t i = 0; i < nd; i++) {
+        if (dslot[i]->mine >= 0) {
+            last = (size_t)dslot[i]->mine + 1;
+            anchor[i] = SIZE_MAX;
+        } else {
+            anchor[i] = last;
+            bucket[last + 1]++;
+        }
+    }
+    for (size_t j = 1; j < nm + 2; j++) bucket[j] += bucket[j - 1];
+    size_t *fill = malloc((nm + 1) * sizeof(size_t));
+    size_t *placed = malloc((nd ? nd : 1) * sizeof(size_t));
+    if (!fill || !placed) {
+        free(fill);
+        free(placed);
+        goto done;
+    }
+    memcpy(fill, bucket, (nm + 1) * sizeof(size_t));
+    for (size_t i = 0; i < nd; i++)
+        if (anchor[i] != SIZE_MAX) placed[fill[anchor[i]]++] = i;
+    free(fill);
+
+    size_t n = 0;
+    for (size_t j = 0; j <= nm; j++) {
+        if (j > 0 && resolve_slot(mslot[j - 1], disk, mine, &out->entries[n], &out->disk_changes))
+            n++;
+        for (size_t k = bucket[j]; k < bucket[j + 1]; k++)
+            if (resolve_slot(dslot[placed[k]], disk, mine, &out->entries[n], &out->disk_changes))
+                n++;
+    }
+    free(placed);
+
+    for (size_t i = 0; i < n; i++)
+        if (out->entries[i].conflict != MERGE_CLEAN) out->conflicts++;
+    out->count = n;
+    rc = 0;
+
+done:
+    free(tab);
+    free(dkeys);
+    free(mkeys);
+    free(dslot);
+    free(mslot);
+    free(bucket);
+    free(anchor);
+    if (rc != 0) merge_result_free(out);
+    return rc;
+}
+
+int merge_build(const struct merge_result *res, struct ruleset *out) {
+    out->rules = malloc((res->count ? res->count : 1) * sizeof(struct rule));
+    out->count = 0;
+    if (!out->rules) return -1;
+    for (size_t i = 0; i < res->count; i++) {
+        const struct merge_entry *e = &res->entries[i];
+        const struct rule *src = e->take_disk ? e->disk : e->mine;
+        if (src) out->rules[out->count++] = rule_copy(src);
+    }
+    return 0;
+}
+
+void merge_result_free(struct merge_result *res) {
+    if (!res) return;
+    free(res->entries);
+    memset(res, 0, sizeof(*res));
+}
+
+const char *merge_conflict_str(enum merge_conflict c) {
+    switch (c) {
+    case MERGE_BOTH_CHANGED: return "edited on both sides";
+    case MERGE_BOTH_ADDED:   return "added on both sides";
+    case MERGE_MINE_DELETED: return "edited on disk, deleted here";
+    case MERGE_DISK_DELETED: return "edited here, deleted on disk";
+    default:                 return "clean";
+    }
+}
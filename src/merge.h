@@ -0,0 +1,68 @@
+#ifndef HYPRWINDOWS_MERGE_H
+#define HYPRWINDOWS_MERGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rules.h"
+
+/*
+ * Rule-level three-way merge of the rules file.
+ *
+ * A rule's identity is its name, or its match fields when it has no
+ * name; the n-th rule sharing an identity is paired with the n-th on the
+ * other sides. Content is compared by rule_fingerprint(), so the base
+ * only needs one (identity, fingerprint) pair per rule. Everything is
+ * hashed once into a single table: the merge is linear in the total
+ * number of rules.
+ *
+ * A side that left a rule as it was in the base yields to the other
+ * side. Only rules both sides changed differently are conflicts; they
+ * default to the in-memory version until resolved.
+ */
+
+struct merge_base {
+    uint64_t *keys;
+    uint64_t *prints;
+    size_t count;
+};
+
+enum merge_conflict {
+    MERGE_CLEAN,
+    MERGE_BOTH_CHANGED,  /* edited on both sides */
+    MERGE_BOTH_ADDED,    /* added on both sides with different content */
+    MERGE_MINE_DELETED,  /* edited on disk, deleted in memory */
+    MERGE_DISK_DELETED,  /* edited in memory, deleted on disk */
+};
+
+struct merge_entry {
+    const struct rule *disk;  /* borrowed; NULL when absent on disk */
+    const struct rule *mine;  /* borrowed; NULL when absent in memory */
+    enum merge_conflict conflict;
+    int take_disk;            /* which side goes into the result */
+};
+
+struct merge_result {
+    struct merge_entry *entries;  /* merged order, deleted rules omitted */
+    size_t count;
+    size_t conflicts;
+    size_t disk_changes;          /* rules added, edited or deleted on disk */
+};
+
+/* identity of every rule in rs, with repeats numbered so the n-th
+ * duplicate on one side pairs with the n-th on another */
+int merge_identities(const struct ruleset *rs, uint64_t *keys);
+
+int merge_base_init(struct merge_base *b, const struct ruleset *rs);
+void merge_base_free(struct merge_base *b);
+
+/* merge disk and mine against base; out borrows rules from both sets */
+int merge_rules(const struct merge_base *base, const struct ruleset *disk,
+                const struct ruleset *mine, struct merge_result *out);
+/* copy the chosen side of every entry into a new ruleset */
+int merge_build(const struct merge_result *res, struct ruleset *out);
+void merge_result_free(struct merge_result *res);
+
+const char *merge_conflict_str(enum merge_conflict c);
+
+#endif
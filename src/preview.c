@@ -0,0 +1,265 @@
+#include "preview.h"
+
+#include <errno.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "match.h"
+
+/* wait this long for more keystrokes before compiling */
+#define PREVIEW_DEBOUNCE_MS 8
+/* check for a newer post every this many candidates */
+#define PREVIEW_CANCEL_STRIDE 256
+
+void preview_init(struct match_preview *p) {
+    memset(p, 0, sizeof(*p));
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+}
+
+static int candidate_add_window(struct preview_candidate *c, size_t window) {
+    for (size_t i = 0; i < c->window_count; i++)
+        if (c->windows[i] == window) return 0;
+    size_t *tmp = realloc(c->windows, (c->window_count + 1) * sizeof(size_t));
+    if (!tmp) return -1;
+    c->windows = tmp;
+    c->windows[c->window_count++] = window;
+    return 0;
+}
+
+static size_t candidate_hash(const char *s, int kind) {
+    size_t h = 2166136261u ^ (size_t)kind;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* slot holding (text, kind), or the empty slot where it would go */
+static size_t *candidate_slot(struct match_preview *p, const char *text, int kind) {
+    size_t mask = p->slot_cap - 1;
+    size_t k = candidate_hash(text, kind) & mask;
+    while (p->slots[k]) {
+        const struct preview_candidate *c = &p->cands[p->slots[k] - 1];
+        if (c->kind == kind && strcmp(c->text, text) == 0) break;
+        k = (k + 1) & mask;
+    }
+    return &p->slots[k];
+}
+
+/* keep the table at most half full */
+static int candidate_slots_grow(struct match_preview *p) {
+    if (p->slot_cap >= (p->cand_count + 1) * 2) return 0;
+    size_t cap = p->slot_cap ? p->slot_cap * 2 : 64;
+    size_t *slots = calloc(cap, sizeof(size_t));
+    if (!slots) return -1;
+    free(p->slots);
+    p->slots = slots;
+    p->slot_cap = cap;
+    for (size_t i = 0; i < p->cand_count; i++)
+        *candidate_slot(p, p->cands[i].text, p->cands[i].kind) = i + 1;
+    return 0;
+}
+
+/* candidates are deduplicated per kind, each remembering the open windows
+ * (window >= 0) that show it; call before preview_start */
+int preview_add(struct match_preview *p, const char *text, int kind, long window) {
+    if (!text || !text[0] || p->started) return -1;
+    if (window >= 0 && (size_t)window >= p->window_total) p->window_total = (size_t)window + 1;
+    if (candidate_slots_grow(p) != 0) return -1;
+    size_t *slot = candidate_slot(p, text, kind);
+    if (*slot) {
+        struct preview_candidate *c = &p->cands[*slot - 1];
+        return window >= 0 ? candidate_add_window(c, (size_t)window) : 0;
+    }
+    if (p->cand_count >= p->cand_cap) {
+        size_t cap = p->cand_cap ? p->cand_cap * 2 : 32;
+        struct preview_candidate *tmp = realloc(p->cands, cap * sizeof(*tmp));
+        if (!tmp) return -1;
+        p->cands = tmp;
+        p->cand_cap = cap;
+    }
+    char *copy = strdup(text);
+    if (!copy) return -1;
+    struct preview_candidate *c = &p->cands[p->cand_count++];
+    *c = (struct preview_candidate){ .text = copy, .kind = kind };
+    *slot = p->cand_count;
+    return window >= 0 ? candidate_add_window(c, (size_t)window) : 0;
+}
+
+static void deadline_after_ms(struct timespec *ts, long ms) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_nsec += ms * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void *preview_thread_fn(void *arg) {
+    struct match_preview *p = arg;
+    unsigned done_gen = 0;
+    size_t *idx = p->idx;
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->quit) {
+        if (p->req_gen == done_gen) {
+            pthread_cond_wait(&p->cond, &p->lock);
+            continue;
+        }
+
+        /* debounce: keep waiting while posts keep arriving */
+        unsigned seen = p->req_gen;
+        for (;;) {
+            struct timespec ts;
+            deadline_after_ms(&ts, PREVIEW_DEBOUNCE_MS);
+            int rc = 0;
+            while (!p->quit && p->req_gen == seen && rc != ETIMEDOUT)
+                rc = pthread_cond_timedwait(&p->cond, &p->lock, &ts);
+            if (p->quit || p->req_gen == seen) break;
+            seen = p->req_gen;
+        }
+        if (p->quit) break;
+
+        char pattern[sizeof(p->pattern)];
+        memcpy(pattern, p->pattern, sizeof(pattern));
+        int mask = p->kind_mask;
+        pthread_mutex_unlock(&p->lock);
+
+        struct preview_result res = { .gen = seen };
+        regex_t re;
+        int stale = 0;
+        if (pattern[0] && regcomp(&re, pattern, MATCH_REGEX_FLAGS) == 0) {
+            res.valid = 1;
+            for (size_t i = 0; i < p->cand_count; i++) {
+                if (i % PREVIEW_CANCEL_STRIDE == PREVIEW_CANCEL_STRIDE - 1 &&
+                    __atomic_load_n(&p->req_gen, __ATOMIC_RELAXED) != seen) {
+                    stale = 1;
+                    break;
+                }
+                const struct preview_candidate *c = &p->cands[i];
+                if (!(c->kind & mask)) continue;
+                if (regexec(&re, c->text, 0, NULL, 0) != 0) continue;
+                idx[res.count++] = i;
+                if (c->kind == PREVIEW_KNOWN_CLASS) res.known++;
+                for (size_t k = 0; k < c->window_count; k++) {
+                    if (p->seen[c->windows[k]]) continue;
+                    p->seen[c->windows[k]] = 1;
+                    res.windows++;
+                }
+            }
+            regfree(&re);
+            for (size_t i = 0; i < res.count; i++) {
+                const struct preview_candidate *c = &p->cands[idx[i]];
+                for (size_t k = 0; k < c->window_count; k++) p->seen[c->windows[k]] = 0;
+            }
+        } else {
+            res.valid = pattern[0] == '\0';
+        }
+
+        pthread_mutex_lock(&p->lock);
+        done_gen = seen;
+        if (stale) continue;
+
+        /* out of memory still publishes the counts, so the post is answered */
+        size_t *keep = malloc((res.count ? res.count : 1) * sizeof(size_t));
+        if (keep) memcpy(keep, idx, res.count * sizeof(size_t));
+        else res.count = 0;
+        res.idx = keep;
+        preview_result_free(&p->result);
+        p->result = res;
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+int preview_start(struct match_preview *p) {
+    if (p->started) return 0;
+    free(p->slots);
+    p->slots = NULL;
+    p->slot_cap = 0;
+    p->idx = malloc((p->cand_count ? p->cand_count : 1) * sizeof(size_t));
+    p->seen = calloc(p->window_total ? p->window_total : 1, 1);
+    if (!p->idx || !p->seen || pthread_create(&p->thread, NULL, preview_thread_fn, p) != 0) {
+        free(p->idx);
+        free(p->seen);
+        p->idx = NULL;
+        p->seen = NULL;
+        return -1;
+    }
+    p->started = 1;
+    return 0;
+}
+
+/* queue a new pattern; returns immediately */
+void preview_post(struct match_preview *p, const char *pattern, int kind_mask) {
+    pthread_mutex_lock(&p->lock);
+    snprintf(p->pattern, sizeof(p->pattern), "%s", pattern ? pattern : "");
+    p->kind_mask = kind_mask;
+    __atomic_add_fetch(&p->req_gen, 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+/* 1 while the latest post has no published result yet */
+int preview_pending(struct match_preview *p) {
+    if (!p->started) return 0;
+    pthread_mutex_lock(&p->lock);
+    int pending = p->result.gen != p->req_gen;
+    pthread_mutex_unlock(&p->lock);
+    return pending;
+}
+
+/* copy the latest result, keeping at most max_idx indices; 0 if none yet */
+int preview_snapshot(struct match_preview *p, struct preview_result *out, size_t max_idx) {
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&p->lock);
+    if (p->result.gen == 0) {
+        pthread_mutex_unlock(&p->lock);
+        return 0;
+    }
+    *out = p->result;
+    out->idx = NULL;
+    size_t n = p->result.count < max_idx ? p->result.count : max_idx;
+    if (n > 0) {
+        out->idx = malloc(n * sizeof(size_t));
+        if (out->idx) memcpy(out->idx, p->result.idx, n * sizeof(size_t));
+        else n = 0;
+    }
+    out->count = n;
+    pthread_mutex_unlock(&p->lock);
+    return 1;
+}
+
+void preview_result_free(struct preview_result *r) {
+    if (!r) return;
+    free(r->idx);
+    r->idx = NULL;
+    r->count = 0;
+}
+
+void preview_free(struct match_preview *p) {
+    if (p->started) {
+        pthread_mutex_lock(&p->lock);
+        p->quit = 1;
+        pthread_cond_signal(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+        pthread_join(p->thread, NULL);
+    }
+    preview_result_free(&p->result);
+    for (size_t i = 0; i < p->cand_count; i++) {
+        free(p->cands[i].text);
+        free(p->cands[i].windows);
+    }
+    free(p->cands);
+    free(p->slots);
+    free(p->idx);
+    free(p->seen);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->cond);
+    memset(p, 0, sizeof(*p));
+}
@@ -0,0 +1,70 @@
+#ifndef HYPRWINDOWS_PREVIEW_H
+#define HYPRWINDOWS_PREVIEW_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/*
+ * Live regex preview: a worker thread matches the pattern under edit
+ * against a fixed candidate list (open window classes/titles, known
+ * app classes). Posts are debounced and stale runs are abandoned, so
+ * typing never waits on regcomp/regexec.
+ */
+
+enum preview_kind {
+    PREVIEW_WINDOW_CLASS = 1 << 0,
+    PREVIEW_WINDOW_TITLE = 1 << 1,
+    PREVIEW_KNOWN_CLASS  = 1 << 2,
+};
+
+struct preview_candidate {
+    char *text;
+    int kind;
+    size_t *windows;    /* open windows showing text, by index */
+    size_t window_count;
+};
+
+struct preview_result {
+    unsigned gen;       /* generation of the post this answers */
+    int valid;          /* 0 = pattern failed to compile */
+    size_t windows;     /* open windows with a matching class or title */
+    size_t known;       /* matches among known app classes */
+    size_t *idx;        /* matching candidate indices, in candidate order */
+    size_t count;
+};
+
+struct match_preview {
+    struct preview_candidate *cands;
+    size_t cand_count;
+    size_t cand_cap;
+    size_t window_total; /* highest window index added, plus one */
+    size_t *slots;       /* dedup table: candidate index + 1, 0 = empty */
+    size_t slot_cap;     /* power of two; dropped by preview_start */
+    size_t *idx;         /* worker scratch: matches of the current run */
+    unsigned char *seen; /* worker scratch: windows already counted */
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int started;
+    int quit;
+
+    /* request (guarded by lock) */
+    char pattern[256];
+    int kind_mask;
+    unsigned req_gen;
+
+    /* latest finished result (guarded by lock) */
+    struct preview_result result;
+};
+
+void preview_init(struct match_preview *p);
+int preview_add(struct match_preview *p, const char *text, int kind, long window);
+int preview_start(struct match_preview *p);
+void preview_post(struct match_preview *p, const char *pattern, int kind_mask);
+int preview_pending(struct match_preview *p);
+int preview_snapshot(struct match_preview *p, struct preview_result *out, size_t max_idx);
+void preview_result_free(struct preview_result *r);
+void preview_free(struct match_preview *p);
+
+#endif
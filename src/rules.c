@@ -6,57 +6,217 @@
 #include <unistd.h>
 
 #include "hyprconf.h"
+#include "scan.h"
 #include "util.h"
 
+/* --- field access (public) --- */
+
+static struct rule_sstr *sso_slot(struct rule *r, enum rule_field f) {
+    return &r->sso[f - RF_FIRST_SSO];
+}
+
+static int sso_spilled(const struct rule *r, enum rule_field f) {
+    return (r->spilled >> (f - RF_FIRST_SSO)) & 1;
+}
+
+const char *rule_get(const struct rule *r, enum rule_field f) {
+    if (!r || f >= RF_STR_COUNT || !rule_has(r, f)) {
+        return NULL;
+    }
+    if (f < RF_FIRST_SSO) {
+        return r->str[f];
+    }
+    const struct rule_sstr *s = &r->sso[f - RF_FIRST_SSO];
+    return sso_spilled(r, f) ? s->u.heap : s->u.inl;
+}
+
+const char *rule_get_or(const struct rule *r, enum rule_field f, const char *fallback) {
+    const char *v = rule_get(r, f);
+    return v ? v : fallback;
+}
+
+/* display name, falling back to the configured name */
+const char *rule_label_or(const struct rule *r, const char *fallback) {
+    const char *v = rule_get(r, RF_DISPLAY_NAME);
+    if (!v) v = rule_get(r, RF_NAME);
+    return v ? v : fallback;
+}
+
+void rule_clear(struct rule *r, enum rule_field f) {
+    if (!r || f >= RF_COUNT) {
+        return;
+    }
+    if (f < RF_FIRST_SSO) {
+        free(r->str[f]);
+        r->str[f] = NULL;
+    } else if (f < RF_STR_COUNT) {
+        if (sso_spilled(r, f)) {
+            free(sso_slot(r, f)->u.heap);
+            r->spilled &= (uint8_t)~(1u << (f - RF_FIRST_SSO));
+        }
+        sso_slot(r, f)->u.inl[0] = '\0';
+    } else {
+        r->bool_val &= (uint8_t)~(1u << (f - RF_FLOAT));
+    }
+    r->present &= (uint32_t)~RF_BIT(f);
+    r->version++;
+}
+
+int rule_set_n(struct rule *r, enum rule_field f, const char *val, size_t len) {
+    if (!r || f >= RF_STR_COUNT) {
+        return -1;
+    }
+    if (!val) {
+        rule_clear(r, f);
+        return 0;
+    }
+
+    if (f >= RF_FIRST_SSO && len <= RULE_SSO_CAP) {
+        /* val may alias the current inline value; copy before releasing */
+        char tmp[RULE_SSO_CAP + 1];
+        memcpy(tmp, val, len);
+        tmp[len] = '\0';
+        rule_clear(r, f);
+        memcpy(sso_slot(r, f)->u.inl, tmp, len + 1);
+        r->present |= (uint32_t)RF_BIT(f);
+        r->version++;
+        return 0;
+    }
+
+    char *copy = (char *)malloc(len + 1);
+    if (!copy) {
+        return -1;
+    }
+    memcpy(copy, val, len);
+    copy[len] = '\0';
+    rule_clear(r, f);
+    if (f < RF_FIRST_SSO) {
+        r->str[f] = copy;
+    } else {
+        sso_slot(r, f)->u.heap = copy;
+        r->spilled |= (uint8_t)(1u << (f - RF_FIRST_SSO));
+    }
+    r->present |= (uint32_t)RF_BIT(f);
+    r->version++;
+    return 0;
+}
+
+int rule_set(struct rule *r, enum rule_field f, const char *val) {
+    return rule_set_n(r, f, val, val ? strlen(val) : 0);
+}
+
+int rule_get_bool(const struct rule *r, enum rule_field f) {
+    if (!r || f < RF_FLOAT || f >= RF_COUNT) {
+        return 0;
+    }
+    return (r->bool_val >> (f - RF_FLOAT)) & 1;
+}
+
+void rule_set_bool(struct rule *r, enum rule_field f, int val) {
+    if (!r || f < RF_FLOAT || f >= RF_COUNT) {
+        return;
+    }
+    if (val) {
+        r->bool_val |= (uint8_t)(1u << (f - RF_FLOAT));
+    } else {
+        r->bool_val &= (uint8_t)~(1u << (f - RF_FLOAT));
+    }
+    r->present |= (uint32_t)RF_BIT(f);
+    r->version++;
+}
+
+/* --- derived values --- */
+
+struct rule_cache *rule_cache(struct rule *r) {
+    if (!r->cache && !(r->cache = calloc(1, sizeof(struct rule_cache)))) return NULL;
+    struct rule_cache *c = r->cache;
+    if (c->valid && c->version == r->version) return c;
+    free(c->fold_label);
+    free(c->fold_class);
+    for (int i = 0; i < RULE_CELL_COUNT; i++) text_cell_reset(&c->cells[i]);
+    memset(c, 0, sizeof(*c));
+    c->version = r->version;
+    c->valid = 1;
+    return c;
+}
+
+static void cache_free(struct rule_cache *c) {
+    if (!c) return;
+    free(c->fold_label);
+    free(c->fold_class);
+    for (int i = 0; i < RULE_CELL_COUNT; i++) text_cell_reset(&c->cells[i]);
+    free(c);
+}
+
+static char *fold_dup(const char *s) {
+    char *out = strdup(s ? s : "");
+    if (out) str_to_lower_inplace(out);
+    return out;
+}
+
+const char *rule_fold_label(struct rule *r) {
+    struct rule_cache *c = rule_cache(r);
+    if (!c) return "";
+    if (!c->fold_label) c->fold_label = fold_dup(rule_label_or(r, ""));
+    return c->fold_label ? c->fold_label : "";
+}
+
+const char *rule_fold_class(struct rule *r) {
+    struct rule_cache *c = rule_cache(r);
+    if (!c) return "";
+    if (!c->fold_class) c->fold_class = fold_dup(rule_get(r, RF_CLASS));
+    return c->fold_class ? c->fold_class : "";
+}
+
 /* --- single rule lifecycle (public) --- */
 
 void rule_free(struct rule *r) {
     if (!r) {
         return;
     }
-    free(r->name);
-    free(r->display_name);
-    free(r->match.class_re);
-    free(r->match.title_re);
-    free(r->match.initial_class_re);
-    free(r->match.initial_title_re);
-    free(r->match.tag_re);
-
-    free(r->actions.tag);
-    free(r->actions.workspace);
-    free(r->actions.opacity);
-    free(r->actions.size);
-    free(r->actions.move);
+    for (int f = 0; f < RF_HEAP_COUNT; f++) {
+        free(r->str[f]);
+    }
+    for (int f = RF_FIRST_SSO; f < RF_STR_COUNT; f++) {
+        if (sso_spilled(r, (enum rule_field)f)) {
+            free(r->sso[f - RF_FIRST_SSO].u.heap);
+        }
+    }
 
     for (size_t i = 0; i < r->extras_count; i++) {
         free(r->extras[i].key);
         free(r->extras[i].value);
     }
     free(r->extras);
+    cache_free(r->cache);
 }
 
 struct rule rule_copy(const struct rule *src) {
     struct rule dst = {0};
     if (!src) return dst;
 
-    dst.name = src->name ? strdup(src->name) : NULL;
-    dst.display_name = src->display_name ? strdup(src->display_name) : NULL;
-
-    dst.match.class_re = src->match.class_re ? strdup(src->match.class_re) : NULL;
-    dst.match.title_re = src->match.title_re ? strdup(src->match.title_re) : NULL;
-    dst.match.initial_class_re = src->match.initial_class_re ? strdup(src->match.initial_class_re) : NULL;
-    dst.match.initial_title_re = src->match.initial_title_re ? strdup(src->match.initial_title_re) : NULL;
-    dst.match.tag_re = src->match.tag_re ? strdup(src->match.tag_re) : NULL;
-
-    dst.actions.tag = src->actions.tag ? strdup(src->actions.tag) : NULL;
-    dst.actions.workspace = src->actions.workspace ? strdup(src->actions.workspace) : NULL;
-    dst.actions.float_set = src->actions.float_set;
-    dst.actions.float_val = src->actions.float_val;
-    dst.actions.center_set = src->actions.center_set;
-    dst.actions.center_val = src->actions.center_val;
-    dst.actions.size = src->actions.size ? strdup(src->actions.size) : NULL;
-    dst.actions.move = src->actions.move ? strdup(src->actions.move) : NULL;
-    dst.actions.opacity = src->actions.opacity ? strdup(src->actions.opacity) : NULL;
+    /* inline strings and flags come along with the bitwise copy */
+    dst = *src;
+    dst.cache = NULL;
+    dst.extras = NULL;
+    dst.extras_count = 0;
+    /* a value that cannot be copied is dropped, so rule_get never
+     * returns NULL for a field marked present */
+    for (int f = 0; f < RF_HEAP_COUNT; f++) {
+        dst.str[f] = src->str[f] ? strdup(src->str[f]) : NULL;
+        if (!dst.str[f]) dst.present &= (uint32_t)~RF_BIT(f);
+    }
+    for (int f = RF_FIRST_SSO; f < RF_STR_COUNT; f++) {
+        if (sso_spilled(src, (enum rule_field)f)) {
+            struct rule_sstr *s = &dst.sso[f - RF_FIRST_SSO];
+            s->u.heap = strdup(src->sso[f - RF_FIRST_SSO].u.heap);
+            if (!s->u.heap) {
+                dst.spilled &= (uint8_t)~(1u << (f - RF_FIRST_SSO));
+                dst.present &= (uint32_t)~RF_BIT(f);
+                s->u.inl[0] = '\0';
+            }
+        }
+    }
 
     if (src->extras_count > 0) {
         dst.extras = malloc(src->extras_count * sizeof(struct rule_extra));
@@ -72,27 +232,110 @@ struct rule rule_copy(const struct rule *src) {
     return dst;
 }
 
-void rule_write(FILE *f, const struct rule *r) {
-    if (!f || !r) return;
+/* --- fingerprint --- */
 
+#define FP_OFFSET 14695981039346656037ull
+#define FP_PRIME 1099511628211ull
+
+static uint64_t fp_bytes(uint64_t h, const char *s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= FP_PRIME;
+    }
+    return h;
+}
+
+/* field tag + value + terminator, so adjacent values cannot alias */
+static uint64_t fp_str(uint64_t h, unsigned char tag, const char *s) {
+    h = fp_bytes(h, (const char *)&tag, 1);
+    h = fp_bytes(h, s, strlen(s));
+    return fp_bytes(h, "", 1);
+}
+
+uint64_t rule_fingerprint(const struct rule *r) {
+    uint64_t h = FP_OFFSET;
+    for (int f = 0; f < RF_COUNT; f++) {
+        if (f == RF_DISPLAY_NAME || !rule_has(r, f)) continue;
+        if (f >= RF_FLOAT)
+            h = fp_str(h, (unsigned char)f, rule_get_bool(r, f) ? "1" : "0");
+        else
+            h = fp_str(h, (unsigned char)f, rule_get(r, f));
+    }
+    for (size_t j = 0; j < r->extras_count; j++) {
+        h = fp_str(h, 0xfe, r->extras[j].key);
+        h = fp_str(h, 0xff, r->extras[j].value);
+    }
+    return h;
+}
+
+/* config keys in the order rule_write emits them */
+static const struct { enum rule_field field; const char *key; } rule_keys[] = {
+    {RF_NAME, "name"},
+    {RF_CLASS, "match:class"},
+    {RF_TITLE, "match:title"},
+    {RF_INITIAL_CLASS, "match:initial_class"},
+    {RF_INITIAL_TITLE, "match:initial_title"},
+    {RF_TAG_MATCH, "match:tag"},
+    {RF_MATCH_WORKSPACE, "match:workspace"},
+    {RF_MATCH_XWAYLAND, "match:xwayland"},
+    {RF_MATCH_FLOAT, "match:float"},
+    {RF_MATCH_FULLSCREEN, "match:fullscreen"},
+    {RF_MATCH_PIN, "match:pin"},
+    {RF_TAG, "tag"},
+    {RF_WORKSPACE, "workspace"},
+    {RF_FLOAT, "float"},
+    {RF_CENTER, "center"},
+    {RF_SIZE, "size"},
+    {RF_MOVE, "move"},
+    {RF_OPACITY, "opacity"},
+};
+
+const char *rule_field_key(enum rule_field f) {
+    for (size_t k = 0; k < sizeof(rule_keys) / sizeof(rule_keys[0]); k++)
+        if (rule_keys[k].field == f) return rule_keys[k].key;
+    return NULL;
+}
+
+int rule_field_of_key(const char *key) {
+    for (size_t k = 0; k < sizeof(rule_keys) / sizeof(rule_keys[0]); k++)
+        if (strcmp(rule_keys[k].key, key) == 0) return (int)rule_keys[k].field;
+    return -1;
+}
+
+/* '#' starts a comment in the config; "##" is a literal one */
+static void write_value(FILE *f, const char *s) {
+    for (const char *h; (h = strchr(s, '#')) != NULL; s = h + 1) {
+        fwrite(s, 1, (size_t)(h - s) + 1, f);
+        fputc('#', f);
+    }
+    fputs(s, f);
+}
+
+int rule_write(FILE *f, const struct rule *r) {
+    if (!f || !r) return 0;
+
+    int lines = 3; /* header, closing brace, blank */
     fprintf(f, "windowrule {\n");
-    if (r->name) fprintf(f, "    name = %s\n", r->name);
-    if (r->match.class_re) fprintf(f, "    match:class = %s\n", r->match.class_re);
-    if (r->match.title_re) fprintf(f, "    match:title = %s\n", r->match.title_re);
-    if (r->match.initial_class_re) fprintf(f, "    match:initial_class = %s\n", r->match.initial_class_re);
-    if (r->match.initial_title_re) fprintf(f, "    match:initial_title = %s\n", r->match.initial_title_re);
-    if (r->match.tag_re) fprintf(f, "    match:tag = %s\n", r->match.tag_re);
-    if (r->actions.tag) fprintf(f, "    tag = %s\n", r->actions.tag);
-    if (r->actions.workspace) fprintf(f, "    workspace = %s\n", r->actions.workspace);
-    if (r->actions.float_set) fprintf(f, "    float = %s\n", r->actions.float_val ? "true" : "false");
-    if (r->actions.center_set) fprintf(f, "    center = %s\n", r->actions.center_val ? "true" : "false");
-    if (r->actions.size) fprintf(f, "    size = %s\n", r->actions.size);
-    if (r->actions.move) fprintf(f, "    move = %s\n", r->actions.move);
-    if (r->actions.opacity) fprintf(f, "    opacity = %s\n", r->actions.opacity);
+    for (size_t k = 0; k < sizeof(rule_keys) / sizeof(rule_keys[0]); k++) {
+        enum rule_field fld = rule_keys[k].field;
+        if (!rule_has(r, fld)) continue;
+        if (fld >= RF_FLOAT)
+            fprintf(f, "    %s = %s\n", rule_keys[k].key, rule_get_bool(r, fld) ? "true" : "false");
+        else {
+            fprintf(f, "    %s = ", rule_keys[k].key);
+            write_value(f, rule_get(r, fld));
+            fputc('\n', f);
+        }
+        lines++;
+    }
     for (size_t j = 0; j < r->extras_count; j++) {
-        fprintf(f, "    %s = %s\n", r->extras[j].key, r->extras[j].value);
+        fprintf(f, "    %s = ", r->extras[j].key);
+        write_value(f, r->extras[j].value);
+        fputc('\n', f);
+        lines++;
     }
     fprintf(f, "}\n\n");
+    return lines;
 }
 
 /* --- ruleset --- */
@@ -109,6 +352,28 @@ void ruleset_free(struct ruleset *set) {
     set->count = 0;
 }
 
+int ruleset_insert(struct ruleset *set, const int *at, const struct rule *const *rules, size_t k) {
+    size_t old_n = set->count, new_n = old_n + k;
+    if (k == 0) return 0;
+    struct rule *nr = realloc(set->rules, new_n * sizeof(struct rule));
+    if (!nr) return -1;
+    set->rules = nr;
+
+    size_t src = old_n;
+    size_t j = k;
+    for (size_t dst = new_n; dst-- > 0;) {
+        if (j > 0 && (size_t)at[j - 1] >= dst) {
+            set->rules[dst] = rule_copy(rules[--j]);
+        } else {
+            src--;
+            if (src == dst) break; /* everything below is already in place */
+            set->rules[dst] = set->rules[src];
+        }
+    }
+    set->count = new_n;
+    return 0;
+}
+
 int ruleset_load(const char *path, struct ruleset *out) {
     return hyprconf_parse_file(path, out);
 }
@@ -147,30 +412,21 @@ char *hypr_find_rules_config(void) {
     }
 
     /* scan for source = lines and check if they contain windowrules */
-    char *line = buf;
-    while (line && *line) {
-        while (*line && isspace((unsigned char)*line)) {
-            line++;
-        }
-        if (*line == '#') {
-            while (*line && *line != '\n') line++;
-            if (*line == '\n') line++;
-            continue;
-        }
-        if (strncmp(line, "source", 6) == 0) {
-            char *p = line + 6;
-            while (*p && isspace((unsigned char)*p)) p++;
-            if (*p == '=') {
-                p++;
-                while (*p && isspace((unsigned char)*p)) p++;
-                char *start = p;
-                while (*p && *p != '\n' && *p != '#') p++;
-                size_t plen = (size_t)(p - start);
-                while (plen > 0 && isspace((unsigned char)start[plen - 1])) plen--;
+    size_t pos = 0;
+    while (pos < len) {
+        pos = scan_skip_ws(buf, len, pos);
+        if (pos < len && buf[pos] != '#' && strncmp(buf + pos, "source", 6) == 0) {
+            size_t p = scan_skip_ws(buf, len, pos + 6);
+            if (p < len && buf[p] == '=') {
+                p = scan_skip_ws(buf, len, p + 1);
+                size_t end = scan_line_end(buf, len, p);
+                size_t hash = scan_comment(buf, end, p);
+                size_t plen = hash - p;
+                while (plen > 0 && isspace((unsigned char)buf[p + plen - 1])) plen--;
                 if (plen > 0) {
                     char *spath = (char *)malloc(plen + 1);
                     if (spath) {
-                        memcpy(spath, start, plen);
+                        memcpy(spath, buf + p, plen);
                         spath[plen] = '\0';
                         if (file_has_windowrules(spath)) {
                             free(buf);
@@ -183,8 +439,8 @@ char *hypr_find_rules_config(void) {
                 }
             }
         }
-        while (*line && *line != '\n') line++;
-        if (*line == '\n') line++;
+        pos = scan_line_end(buf, len, pos);
+        if (pos < len) pos++;
     }
 
     if (strstr(buf, "windowrule") != NULL) {
@@ -2,26 +2,63 @@
 #define HYPRWINDOWS_RULES_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
-struct rule_match {
-    char *class_re;
-    char *title_re;
-    char *initial_class_re;
-    char *initial_title_re;
-    char *tag_re;
+#include "textwidth.h"
+
+/*
+ * Rule fields, addressed by index. Which fields are set is tracked in
+ * rule.present, so scans test a bit instead of chasing a pointer.
+ */
+enum rule_field {
+    /* heap strings (names and regexes, usually long) */
+    RF_NAME,
+    RF_DISPLAY_NAME,     /* derived human-readable name */
+    RF_CLASS,
+    RF_TITLE,
+    RF_INITIAL_CLASS,
+    RF_INITIAL_TITLE,
+    RF_TAG_MATCH,
+    /* small strings, stored inline ("2", "yes", "+term") */
+    RF_TAG,
+    RF_WORKSPACE,
+    RF_OPACITY,
+    RF_SIZE,
+    RF_MOVE,
+    RF_MATCH_WORKSPACE,  /* match:workspace: id, or "name:..." */
+    RF_STR_COUNT,
+    /* booleans: presence bit means "set", value lives in rule.bool_val */
+    RF_FLOAT = RF_STR_COUNT,
+    RF_CENTER,
+    RF_MATCH_XWAYLAND,
+    RF_MATCH_FLOAT,
+    RF_MATCH_FULLSCREEN,
+    RF_MATCH_PIN,
+    RF_COUNT,
 };
 
-struct rule_actions {
-    char *tag;
-    char *workspace;
-    char *opacity;
-    char *size;
-    char *move;
-    int float_set;
-    int float_val;
-    int center_set;
-    int center_val;
+#define RF_BIT(f) (1u << (f))
+#define RF_FIRST_SSO RF_TAG
+#define RF_HEAP_COUNT RF_FIRST_SSO
+#define RF_SSO_COUNT (RF_STR_COUNT - RF_FIRST_SSO)
+#define RF_STATE_MASK (RF_BIT(RF_MATCH_WORKSPACE) | RF_BIT(RF_MATCH_XWAYLAND) | \
+                       RF_BIT(RF_MATCH_FLOAT) | RF_BIT(RF_MATCH_FULLSCREEN) | RF_BIT(RF_MATCH_PIN))
+#define RF_MATCH_MASK (RF_BIT(RF_CLASS) | RF_BIT(RF_TITLE) | RF_BIT(RF_INITIAL_CLASS) | \
+                       RF_BIT(RF_INITIAL_TITLE) | RF_BIT(RF_TAG_MATCH) | RF_STATE_MASK)
+
+/* rule.flags */
+#define RULE_F_BROKEN 0x01 /* Hyprland reported a config error inside this rule */
+
+/* inline capacity of a small string, excluding NUL */
+#define RULE_SSO_CAP 15
+
+/* small string: inline when short, heap pointer otherwise (see rule.spilled) */
+struct rule_sstr {
+    union {
+        char inl[RULE_SSO_CAP + 1];
+        char *heap;
+    } u;
 };
 
 /* key-value pair for unknown/extra fields */
@@ -30,13 +67,32 @@ struct rule_extra {
     char *value;
 };
 
+#define RULE_CELL_COUNT 3
+
+/* values derived from a rule, computed on demand and dropped when
+ * rule.version moves; touched by the UI thread only */
+struct rule_cache {
+    uint32_t version;    /* rule.version these belong to */
+    int valid;
+    int display_done;    /* RF_DISPLAY_NAME is up to date (see ui.c) */
+    char *fold_label;    /* lowercased label, for search and name sort */
+    char *fold_class;    /* lowercased match:class */
+    struct text_cell cells[RULE_CELL_COUNT]; /* rules list columns (see ui.c) */
+};
+
 struct rule {
-    char *name;
-    char *display_name;  /* derived human-readable name */
-    struct rule_match match;
-    struct rule_actions actions;
+    uint32_t present;   /* RF_BIT(field) for every field that has a value */
+    uint32_t version;   /* bumped by every field change */
+    uint8_t spilled;    /* bit (f - RF_FIRST_SSO): small string lives on the heap */
+    uint8_t bool_val;   /* bit (f - RF_FLOAT): value of a set boolean */
+    uint8_t flags;      /* RULE_F_* */
+    uint32_t src_line;  /* source span of the windowrule block, 1-based lines; */
+    uint32_t src_end;   /* 0 when unknown (rule created in the UI) */
+    char *str[RF_HEAP_COUNT];
+    struct rule_sstr sso[RF_SSO_COUNT];
     struct rule_extra *extras;
     size_t extras_count;
+    struct rule_cache *cache; /* NULL until asked for; never shared by copies */
 };
 
 struct ruleset {
@@ -46,13 +102,44 @@ struct ruleset {
 
 int ruleset_load(const char *path, struct ruleset *out);
 void ruleset_free(struct ruleset *set);
+/* insert copies of rules[j] so they end up at final index at[j] (ascending),
+ * in a single pass from the end; 0 on success, -1 (set unchanged) on failure */
+int ruleset_insert(struct ruleset *set, const int *at, const struct rule *const *rules, size_t k);
 
 /* single rule lifecycle */
 void rule_free(struct rule *r);
 struct rule rule_copy(const struct rule *src);
 
-/* write a rule block to an open FILE stream */
-void rule_write(FILE *f, const struct rule *r);
+/* field access; rule_get returns NULL for unset fields */
+#define rule_has(r, f) (((r)->present & RF_BIT(f)) != 0)
+const char *rule_get(const struct rule *r, enum rule_field f);
+const char *rule_get_or(const struct rule *r, enum rule_field f, const char *fallback);
+const char *rule_label_or(const struct rule *r, const char *fallback);
+int rule_set(struct rule *r, enum rule_field f, const char *val);
+int rule_set_n(struct rule *r, enum rule_field f, const char *val, size_t len);
+void rule_clear(struct rule *r, enum rule_field f);
+int rule_get_bool(const struct rule *r, enum rule_field f);
+void rule_set_bool(struct rule *r, enum rule_field f, int val);
+
+/* derived-value cache, reset if the rule changed since it was filled;
+ * NULL when out of memory */
+struct rule_cache *rule_cache(struct rule *r);
+/* lowercased label / match:class, computed once per rule version */
+const char *rule_fold_label(struct rule *r);
+const char *rule_fold_class(struct rule *r);
+
+/* config key of a field ("match:class"), or NULL for derived fields */
+const char *rule_field_key(enum rule_field f);
+/* field a config key names, or -1 when the key is not a field */
+int rule_field_of_key(const char *key);
+
+/* 64-bit content hash of everything rule_write emits; equal rules hash
+ * equal regardless of field order in the source */
+uint64_t rule_fingerprint(const struct rule *r);
+
+/* write a rule block to an open FILE stream; returns the number of lines
+ * written, including the blank separator line */
+int rule_write(FILE *f, const struct rule *r);
 
 char *hypr_find_rules_config(void);
 
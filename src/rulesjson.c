@@ -0,0 +1,509 @@
+#include "rulesjson.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+/* --- writer --- */
+
+int rules_json_write(FILE *f, const struct ruleset *rs) {
+    const char *keys[RF_COUNT];
+    for (int fld = 0; fld < RF_COUNT; fld++) keys[fld] = rule_field_key((enum rule_field)fld);
+
+    fputs("{\"version\": 1, \"rules\": [\n", f);
+    for (size_t i = 0; i < rs->count; i++) {
+        const struct rule *r = &rs->rules[i];
+        const char *sep = "";
+        fputc('{', f);
+        for (int fld = 0; fld < RF_COUNT; fld++) {
+            if (!keys[fld] || !rule_has(r, fld)) continue;
+            fputs(sep, f);
+            json_put_string(f, keys[fld]);
+            fputs(": ", f);
+            if (fld >= RF_FLOAT) fputs(rule_get_bool(r, fld) ? "true" : "false", f);
+            else json_put_string(f, rule_get(r, fld));
+            sep = ", ";
+        }
+        if (r->extras_count) {
+            fprintf(f, "%s\"extras\": [", sep);
+            for (size_t j = 0; j < r->extras_count; j++) {
+                fputs(j ? ", {\"key\": " : "{\"key\": ", f);
+                json_put_string(f, r->extras[j].key);
+                fputs(", \"value\": ", f);
+                json_put_string(f, r->extras[j].value);
+                fputc('}', f);
+            }
+            fputc(']', f);
+            sep = ", ";
+        }
+        if (r->src_line)
+            fprintf(f, "%s\"source\": {\"line\": %u, \"end\": %u}", sep, r->src_line, r->src_end);
+        fputs(i + 1 < rs->count ? "},\n" : "}\n", f);
+    }
+    fputs("]}\n", f);
+    return ferror(f) ? -1 : 0;
+}
+
+/* --- reader: input --- */
+
+#define JSON_BUF_SIZE (64 * 1024)
+#define JSON_MAX_DEPTH 64
+
+/* a growable string, reused for every token read into it */
+struct jstr {
+    char *s;
+    size_t len, cap;
+};
+
+struct jreader {
+    FILE *f;
+    size_t pos, len;
+    unsigned line;
+    int failed;
+    char *err;
+    size_t errsz;
+    struct jstr key, val;
+    size_t rules_cap;
+    char buf[JSON_BUF_SIZE];
+};
+
+static int jr_fail(struct jreader *jr, const char *fmt, ...) {
+    if (jr->failed) return -1;
+    jr->failed = 1;
+    if (!jr->err || !jr->errsz) return -1;
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    snprintf(jr->err, jr->errsz, "line %u: %s", jr->line, msg);
+    return -1;
+}
+
+/* 1 while there is input left at jr->pos */
+static int jr_fill(struct jreader *jr) {
+    if (jr->pos < jr->len) return 1;
+    jr->pos = 0;
+    jr->len = fread(jr->buf, 1, sizeof(jr->buf), jr->f);
+    return jr->len > 0;
+}
+
+static int jr_peek(struct jreader *jr) {
+    return jr_fill(jr) ? (unsigned char)jr->buf[jr->pos] : -1;
+}
+
+static int jr_get(struct jreader *jr) {
+    int c = jr_peek(jr);
+    if (c >= 0) {
+        jr->pos++;
+        if (c == '\n') jr->line++;
+    }
+    return c;
+}
+
+/* the next significant character, not consumed */
+static int jr_skip_ws(struct jreader *jr) {
+    while (jr_fill(jr)) {
+        for (; jr->pos < jr->len; jr->pos++) {
+            char c = jr->buf[jr->pos];
+            if (c == '\n') jr->line++;
+            else if (c != ' ' && c != '\t' && c != '\r') return (unsigned char)c;
+        }
+    }
+    return -1;
+}
+
+static int jr_expect(struct jreader *jr, int want, const char *what) {
+    if (jr_skip_ws(jr) != want) return jr_fail(jr, "expected %s", what);
+    jr_get(jr);
+    return 0;
+}
+
+/* --- reader: tokens --- */
+
+static int jstr_push(struct jreader *jr, struct jstr *s, const char *p, size_t n) {
+    if (s->len + n + 1 > s->cap) {
+        size_t cap = s->cap ? s->cap : 256;
+        while (cap < s->len + n + 1) cap *= 2;
+        char *grown = realloc(s->s, cap);
+        if (!grown) return jr_fail(jr, "out of memory");
+        s->s = grown;
+        s->cap = cap;
+    }
+    memcpy(s->s + s->len, p, n);
+    s->len += n;
+    s->s[s->len] = '\0';
+    return 0;
+}
+
+static int jr_read_hex4(struct jreader *jr, uint32_t *out) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = jr_get(jr);
+        if (c >= '0' && c <= '9') v = v << 4 | (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') v = v << 4 | (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v = v << 4 | (uint32_t)(c - 'A' + 10);
+        else return jr_fail(jr, "bad \\u escape");
+    }
+    *out = v;
+    return 0;
+}
+
+static int jr_read_escape(struct jreader *jr, struct jstr *s) {
+    int c = jr_get(jr);
+    char ch;
+    switch (c) {
+    case '"': case '\\': case '/': ch = (char)c; break;
+    case 'b': ch = '\b'; break;
+    case 'f': ch = '\f'; break;
+    case 'n': ch = '\n'; break;
+    case 'r': ch = '\r'; break;
+    case 't': ch = '\t'; break;
+    case 'u': {
+        uint32_t cp, lo;
+        if (jr_read_hex4(jr, &cp) != 0) return -1;
+        if (cp >= 0xd800 && cp <= 0xdbff) {
+            if (jr_get(jr) != '\\' || jr_get(jr) != 'u' || jr_read_hex4(jr, &lo) != 0 ||
+                lo < 0xdc00 || lo > 0xdfff)
+                return jr_fail(jr, "unpaired surrogate in \\u escape");
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+        } else if (cp >= 0xdc00 && cp <= 0xdfff) {
+            return jr_fail(jr, "unpaired surrogate in \\u escape");
+        }
+        if (cp == 0) return jr_fail(jr, "NUL in string");
+        char u[4];
+        size_t n;
+        if (cp < 0x80) { u[0] = (char)cp; n = 1; }
+        else if (cp < 0x800) { u[0] = (char)(0xc0 | cp >> 6); n = 2; }
+        else if (cp < 0x10000) { u[0] = (char)(0xe0 | cp >> 12); n = 3; }
+        else { u[0] = (char)(0xf0 | cp >> 18); n = 4; }
+        for (size_t i = 1; i < n; i++)
+            u[i] = (char)(0x80 | ((cp >> (6 * (n - 1 - i))) & 0x3f));
+        return jstr_push(jr, s, u, n);
+    }
+    default:
+        return jr_fail(jr, "bad escape in string");
+    }
+    return jstr_push(jr, s, &ch, 1);
+}
+
+/* a string token into s; the opening quote is next in the input */
+static int jr_read_string(struct jreader *jr, struct jstr *s) {
+    if (jr_expect(jr, '"', "a string") != 0) return -1;
+    s->len = 0;
+    if (!s->s && jstr_push(jr, s, "", 0) != 0) return -1;
+    s->s[0] = '\0';
+    for (;;) {
+        if (!jr_fill(jr)) return jr_fail(jr, "unterminated string");
+        /* copy the plain run in one go */
+        size_t start = jr->pos, end = start;
+        while (end < jr->len) {
+            unsigned char c = (unsigned char)jr->buf[end];
+            if (c == '"' || c == '\\' || c < 0x20) break;
+            end++;
+        }
+        if (end > start && jstr_push(jr, s, jr->buf + start, end - start) != 0) return -1;
+        jr->pos = end;
+        if (end == jr->len) continue;
+
+        int c = jr_get(jr);
+        if (c == '"') return 0;
+        if (c != '\\') return jr_fail(jr, "control character in string");
+        if (jr_read_escape(jr, s) != 0) return -1;
+    }
+}
+
+/* true, false or null: 1, 0 or 2 */
+static int jr_read_literal(struct jreader *jr) {
+    static const char *const words[] = {"false", "true", "null"};
+    int c = jr_skip_ws(jr);
+    for (int w = 0; w < 3; w++) {
+        if (c != words[w][0]) continue;
+        for (const char *p = words[w]; *p; p++)
+            if (jr_get(jr) != *p) return jr_fail(jr, "bad literal");
+        return w;
+    }
+    return jr_fail(jr, "expected true, false or null");
+}
+
+static int jr_read_uint(struct jreader *jr, uint32_t *out) {
+    int c = jr_skip_ws(jr);
+    if (c < '0' || c > '9') return jr_fail(jr, "expected a line number");
+    uint64_t v = 0;
+    while ((c = jr_peek(jr)) >= '0' && c <= '9') {
+        v = v * 10 + (uint64_t)(c - '0');
+        if (v > UINT32_MAX) return jr_fail(jr, "line number out of range");
+        jr_get(jr);
+    }
+    *out = (uint32_t)v;
+    return 0;
+}
+
+/* step through an object whose '{' was consumed: 1 with the next key in
+ * jr->key and its ':' consumed, 0 after the closing '}' */
+static int jr_object_next(struct jreader *jr, int *first) {
+    int c = jr_skip_ws(jr);
+    if (c == '}') {
+        jr_get(jr);
+        return 0;
+    }
+    if (!*first) {
+        jr_get(jr);
+        if (c != ',') return jr_fail(jr, "expected ',' or '}'");
+        if (jr_skip_ws(jr) == '}') return jr_fail(jr, "trailing comma");
+    }
+    *first = 0;
+    if (jr_read_string(jr, &jr->key) != 0 || jr_expect(jr, ':', "':'") != 0) return -1;
+    return 1;
+}
+
+/* the same for an array whose '[' was consumed: 1 when a value follows */
+static int jr_array_next(struct jreader *jr, int *first) {
+    int c = jr_skip_ws(jr);
+    if (c == ']') {
+        jr_get(jr);
+        return 0;
+    }
+    if (!*first) {
+        jr_get(jr);
+        if (c != ',') return jr_fail(jr, "expected ',' or ']'");
+        if (jr_skip_ws(jr) == ']') return jr_fail(jr, "trailing comma");
+    }
+    *first = 0;
+    return 1;
+}
+
+static int jr_skip_value(struct jreader *jr, int depth) {
+    if (depth > JSON_MAX_DEPTH) return jr_fail(jr, "nesting too deep");
+    int c = jr_skip_ws(jr), k, first = 1;
+    switch (c) {
+    case '"':
+        return jr_read_string(jr, &jr->val);
+    case '{':
+        jr_get(jr);
+        while ((k = jr_object_next(jr, &first)) > 0)
+            if (jr_skip_value(jr, depth + 1) != 0) return -1;
+        return k;
+    case '[':
+        jr_get(jr);
+        while ((k = jr_array_next(jr, &first)) > 0)
+            if (jr_skip_value(jr, depth + 1) != 0) return -1;
+        return k;
+    case 't': case 'f': case 'n':
+        return jr_read_literal(jr) < 0 ? -1 : 0;
+    default:
+        if (c != '-' && (c < '0' || c > '9')) return jr_fail(jr, "unexpected character");
+        while ((c = jr_peek(jr)) >= 0 && strchr("+-.eE0123456789", c)) jr_get(jr);
+        return 0;
+    }
+}
+
+/* --- reader: rules --- */
+
+static char *jstr_take(const struct jstr *s) {
+    char *out = malloc(s->len + 1);
+    if (out) memcpy(out, s->s, s->len + 1);
+    return out;
+}
+
+/* a value goes on one config line */
+static int jr_check_value(struct jreader *jr, const char *key, const struct jstr *v) {
+    if (memchr(v->s, '\n', v->len) || memchr(v->s, '\r', v->len))
+        return jr_fail(jr, "\"%s\": value spans lines", key);
+    return 0;
+}
+
+/* takes key and value; extras grow by doubling, as in hyprconf */
+static int jr_add_extra(struct jreader *jr, struct rule *r, char *key, char *value) {
+    size_t n = r->extras_count;
+    if (n == 0 || (n & (n - 1)) == 0) {
+        struct rule_extra *grown = realloc(r->extras, (n ? n * 2 : 4) * sizeof(*grown));
+        if (!grown) {
+            free(key);
+            free(value);
+            return jr_fail(jr, "out of memory");
+        }
+        r->extras = grown;
+    }
+    r->extras[n].key = key;
+    r->extras[n].value = value;
+    r->extras_count = n + 1;
+    return 0;
+}
+
+static int jr_add_extra_str(struct jreader *jr, struct rule *r, const struct jstr *key,
+                         const struct jstr *value) {
+    if (!key->len || strcspn(key->s, " \t\r\n={}#") != key->len)
+        return jr_fail(jr, "\"%s\" is not a config key", key->s);
+    if (jr_check_value(jr, key->s, value) != 0) return -1;
+    char *k = jstr_take(key), *v = jstr_take(value);
+    if (!k || !v) {
+        free(k);
+        free(v);
+        return jr_fail(jr, "out of memory");
+    }
+    return jr_add_extra(jr, r, k, v);
+}
+
+/* "extras": [{"key": ..., "value": ...}, ...] */
+static int jr_read_extras(struct jreader *jr, struct rule *r) {
+    if (jr_expect(jr, '[', "an array of extras") != 0) return -1;
+    int first = 1, k;
+    while ((k = jr_array_next(jr, &first)) > 0) {
+        if (jr_expect(jr, '{', "an extra object") != 0) return -1;
+        struct jstr ekey = {0};
+        int efirst = 1, has_value = 0, e;
+        while ((e = jr_object_next(jr, &efirst)) > 0) {
+            if (strcmp(jr->key.s, "key") == 0) {
+                e = jr_read_string(jr, &ekey);
+            } else if (strcmp(jr->key.s, "value") == 0) {
+                e = jr_read_string(jr, &jr->val);
+                has_value = 1;
+            } else {
+                e = jr_skip_value(jr, 1);
+            }
+            if (e != 0) break;
+        }
+        if (e == 0 && (!ekey.s || !has_value)) e = jr_fail(jr, "extra without key or value");
+        if (e == 0) e = jr_add_extra_str(jr, r, &ekey, &jr->val);
+        free(ekey.s);
+        if (e != 0) return -1;
+    }
+    return k;
+}
+
+/* "source": {"line": N, "end": M} or null */
+static int jr_read_source(struct jreader *jr, struct rule *r) {
+    if (jr_skip_ws(jr) == 'n') return jr_read_literal(jr) == 2 ? 0 : jr_fail(jr, "bad source");
+    if (jr_expect(jr, '{', "a source object") != 0) return -1;
+    int first = 1, k;
+    while ((k = jr_object_next(jr, &first)) > 0) {
+        int e;
+        if (strcmp(jr->key.s, "line") == 0) e = jr_read_uint(jr, &r->src_line);
+        else if (strcmp(jr->key.s, "end") == 0) e = jr_read_uint(jr, &r->src_end);
+        else e = jr_skip_value(jr, 1);
+        if (e != 0) return -1;
+    }
+    return k;
+}
+
+static int jr_read_field(struct jreader *jr, struct rule *r, enum rule_field f) {
+    if (f >= RF_FLOAT) {
+        int v = jr_read_literal(jr);
+        if (v < 0) return -1;
+        if (v == 2) rule_clear(r, f);
+        else rule_set_bool(r, f, v);
+        return 0;
+    }
+    if (jr_skip_ws(jr) == 'n') {
+        if (jr_read_literal(jr) != 2) return jr_fail(jr, "expected a string for \"%s\"", jr->key.s);
+        rule_clear(r, f);
+        return 0;
+    }
+    /* the key names the error; keep it while the value is read */
+    char key[64];
+    snprintf(key, sizeof(key), "%s", jr->key.s);
+    if (jr_read_string(jr, &jr->val) != 0 || jr_check_value(jr, key, &jr->val) != 0) return -1;
+    if (rule_set_n(r, f, jr->val.s, jr->val.len) != 0) return jr_fail(jr, "out of memory");
+    return 0;
+}
+
+static int jr_read_rule(struct jreader *jr, struct rule *r) {
+    if (jr_expect(jr, '{', "a rule object") != 0) return -1;
+    int first = 1, k;
+    while ((k = jr_object_next(jr, &first)) > 0) {
+        int e;
+        int f = rule_field_of_key(jr->key.s);
+        if (f >= 0) {
+            e = jr_read_field(jr, r, (enum rule_field)f);
+        } else if (strcmp(jr->key.s, "extras") == 0) {
+            e = jr_read_extras(jr, r);
+        } else if (strcmp(jr->key.s, "source") == 0) {
+            e = jr_read_source(jr, r);
+        } else if (jr_skip_ws(jr) == '"') {
+            /* a key the config does not know, like any other extra */
+            struct jstr key = {0};
+            e = jstr_push(jr, &key, jr->key.s, jr->key.len);
+            if (e == 0) e = jr_read_string(jr, &jr->val);
+            if (e == 0) e = jr_add_extra_str(jr, r, &key, &jr->val);
+            free(key.s);
+        } else {
+            e = jr_skip_value(jr, 1);
+        }
+        if (e != 0) return -1;
+    }
+    return k;
+}
+
+static int jr_read_rules(struct jreader *jr, struct ruleset *out) {
+    if (jr_expect(jr, '[', "an array of rules") != 0) return -1;
+    int first = 1, k;
+    while ((k = jr_array_next(jr, &first)) > 0) {
+        if (out->count == jr->rules_cap) {
+            size_t cap = jr->rules_cap ? jr->rules_cap * 2 : 256;
+            struct rule *grown = realloc(out->rules, cap * sizeof(*grown));
+            if (!grown) return jr_fail(jr, "out of memory");
+            out->rules = grown;
+            jr->rules_cap = cap;
+        }
+        /* counted before it is filled so a failure still frees it */
+        struct rule *r = &out->rules[out->count++];
+        memset(r, 0, sizeof(*r));
+        if (jr_read_rule(jr, r) != 0) return -1;
+    }
+    return k;
+}
+
+static int jr_read_document(struct jreader *jr, struct ruleset *out) {
+    int c = jr_skip_ws(jr);
+    if (c == '[') return jr_read_rules(jr, out);
+    if (c != '{') return jr_fail(jr, "expected a JSON object or array");
+    jr_get(jr);
+
+    int first = 1, k, seen = 0;
+    while ((k = jr_object_next(jr, &first)) > 0) {
+        int e;
+        if (strcmp(jr->key.s, "version") == 0) {
+            uint32_t v;
+            e = jr_read_uint(jr, &v);
+            if (e == 0 && v != 1) e = jr_fail(jr, "unsupported version %u", v);
+        } else if (strcmp(jr->key.s, "rules") == 0 && !seen) {
+            e = jr_read_rules(jr, out);
+            seen = 1;
+        } else {
+            e = jr_skip_value(jr, 1);
+        }
+        if (e != 0) return -1;
+    }
+    if (k == 0 && !seen) return jr_fail(jr, "no \"rules\" array");
+    return k;
+}
+
+int rules_json_read(FILE *f, struct ruleset *out, char *err, size_t errsz) {
+    memset(out, 0, sizeof(*out));
+    if (err && errsz) err[0] = '\0';
+    struct jreader *jr = calloc(1, sizeof(*jr));
+    if (!jr) {
+        if (err && errsz) snprintf(err, errsz, "out of memory");
+        return -1;
+    }
+    jr->f = f;
+    jr->line = 1;
+    jr->err = err;
+    jr->errsz = errsz;
+
+    int rc = jr_read_document(jr, out);
+    if (rc == 0 && jr_skip_ws(jr) >= 0) rc = jr_fail(jr, "unexpected data after the rules");
+    if (rc == 0 && ferror(f)) rc = jr_fail(jr, "read error");
+    free(jr->key.s);
+    free(jr->val.s);
+    free(jr);
+    if (rc != 0) {
+        ruleset_free(out);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef HYPRWINDOWS_RULESJSON_H
+#define HYPRWINDOWS_RULESJSON_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "rules.h"
+
+/*
+ * Rules as JSON, for export to and import from other tools.
+ *
+ *   {"version": 1, "rules": [
+ *   {"name": "pavu", "match:class": "^pavucontrol$", "float": true,
+ *    "extras": [{"key": "pin", "value": "1"}], "source": {"line": 4, "end": 8}},
+ *   ...
+ *   ]}
+ *
+ * Fields use their config keys; booleans are JSON booleans. Keys the
+ * config does not know about live in "extras", in source order. "source"
+ * is the rule's line span in the file it was loaded from and is left out
+ * for rules without one.
+ *
+ * Both directions stream: the writer prints one rule per line as it goes,
+ * the reader parses through a fixed buffer and only allocates what the
+ * rules themselves keep.
+ */
+
+/* 0 on success, -1 when the stream reported an error */
+int rules_json_write(FILE *f, const struct ruleset *rs);
+
+/* parse rules from f into out (zeroed first). Accepts the object above or
+ * a bare array of rules; unknown string-valued keys in a rule become
+ * extras. On error returns -1, leaves out empty and describes the problem
+ * in err. */
+int rules_json_read(FILE *f, struct ruleset *out, char *err, size_t errsz);
+
+#endif
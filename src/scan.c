@@ -0,0 +1,128 @@
+#include "scan.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+/* --- byte classes --- */
+
+#define C_WS     0x01u
+#define C_NL     0x02u
+#define C_HASH   0x04u
+#define C_LBRACE 0x08u
+#define C_RBRACE 0x10u
+#define C_EQ     0x20u
+
+static inline int is_ws(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int in_class(unsigned char c, unsigned cls) {
+    return ((cls & C_WS) && is_ws(c)) || ((cls & C_NL) && c == '\n') ||
+           ((cls & C_HASH) && c == '#') || ((cls & C_LBRACE) && c == '{') ||
+           ((cls & C_RBRACE) && c == '}') || ((cls & C_EQ) && c == '=');
+}
+
+/* first byte whose membership in cls differs from skip */
+static inline size_t scalar_scan(const char *buf, size_t len, size_t pos, unsigned cls, int skip) {
+    while (pos < len && in_class((unsigned char)buf[pos], cls) == skip) pos++;
+    return pos;
+}
+
+#ifdef SCAN_X86
+
+/* --- SSE2, 16 bytes per step (baseline on x86-64) --- */
+
+static inline unsigned sse2_mask(__m128i v, unsigned cls) {
+    __m128i m = _mm_setzero_si128();
+    if (cls & C_WS) {
+        /* ' ' or '\t'..'\r': (c - '\t') <= 4 unsigned */
+        __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    }
+    if (cls & C_NL) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    if (cls & C_HASH) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('#')));
+    if (cls & C_LBRACE) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('{')));
+    if (cls & C_RBRACE) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+    if (cls & C_EQ) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('=')));
+    return (unsigned)_mm_movemask_epi8(m);
+}
+
+static inline size_t sse2_scan(const char *buf, size_t len, size_t pos, unsigned cls, int skip) {
+    while (len - pos >= 16) {
+        unsigned mask = sse2_mask(_mm_loadu_si128((const __m128i *)(buf + pos)), cls);
+        if (skip) mask ^= 0xffffu;
+        if (mask) return pos + (size_t)__builtin_ctz(mask);
+        pos += 16;
+    }
+    return scalar_scan(buf, len, pos, cls, skip);
+}
+
+/* --- AVX2, 32 bytes per step --- */
+
+__attribute__((target("avx2")))
+static inline unsigned avx2_mask(__m256i v, unsigned cls) {
+    __m256i m = _mm256_setzero_si256();
+    if (cls & C_WS) {
+        __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(4)), t));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+    }
+    if (cls & C_NL) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    if (cls & C_HASH) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#')));
+    if (cls & C_LBRACE) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')));
+    if (cls & C_RBRACE) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}')));
+    if (cls & C_EQ) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('=')));
+    return (unsigned)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2")))
+static inline size_t avx2_scan(const char *buf, size_t len, size_t pos, unsigned cls, int skip) {
+    while (len - pos >= 32) {
+        unsigned mask = avx2_mask(_mm256_loadu_si256((const __m256i *)(buf + pos)), cls);
+        if (skip) mask = ~mask;
+        if (mask) return pos + (size_t)__builtin_ctz(mask);
+        pos += 32;
+    }
+    return sse2_scan(buf, len, pos, cls, skip);
+}
+
+#define SCAN_DEFINE(name, cls, skip)                                              \
+    __attribute__((target("avx2")))                                               \
+    static size_t name##_avx2(const char *buf, size_t len, size_t pos) {          \
+        return avx2_scan(buf, len, pos, cls, skip);                               \
+    }                                                                             \
+    size_t name(const char *buf, size_t len, size_t pos) {                        \
+        /* tokens are short: settle the common one-byte case before dispatch */ \
+        if (pos >= len || in_class((unsigned char)buf[pos], cls) != (skip))       \
+            return pos;                                                           \
+        if (len - pos >= 64 && __builtin_cpu_supports("avx2"))                    \
+            return name##_avx2(buf, len, pos + 1);                                \
+        return sse2_scan(buf, len, pos + 1, cls, skip);                           \
+    }
+
+const char *scan_kernel_name(void) {
+    return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+}
+
+#else
+
+#define SCAN_DEFINE(name, cls, skip)                                              \
+    size_t name(const char *buf, size_t len, size_t pos) {                        \
+        return scalar_scan(buf, len, pos, cls, skip);                             \
+    }
+
+const char *scan_kernel_name(void) {
+    return "scalar";
+}
+
+#endif
+
+SCAN_DEFINE(scan_skip_ws, C_WS, 1)
+SCAN_DEFINE(scan_word_end, C_WS | C_LBRACE | C_RBRACE | C_EQ, 0)
+SCAN_DEFINE(scan_value_end, C_NL | C_RBRACE, 0)
+SCAN_DEFINE(scan_line_end, C_NL, 0)
+SCAN_DEFINE(scan_comment, C_HASH, 0)
+SCAN_DEFINE(scan_syntax, C_HASH | C_NL | C_LBRACE | C_RBRACE, 0)
@@ -0,0 +1,26 @@
+#ifndef HYPRWINDOWS_SCAN_H
+#define HYPRWINDOWS_SCAN_H
+
+#include <stddef.h>
+
+/*
+ * Byte-class scanning kernels for the config tokenizer.
+ *
+ * Each returns the index of the first byte at or after pos that belongs
+ * to (or, for scan_skip_ws, falls outside) a class, or len when there is
+ * none. Whitespace is the ASCII set isspace() accepts in the C locale.
+ * On x86 the bytes are classified 32 at a time with AVX2 when the CPU
+ * has it, else 16 at a time with SSE2; elsewhere a scalar loop runs.
+ */
+
+size_t scan_skip_ws(const char *buf, size_t len, size_t pos);   /* first non-whitespace */
+size_t scan_word_end(const char *buf, size_t len, size_t pos);  /* whitespace { } = */
+size_t scan_value_end(const char *buf, size_t len, size_t pos); /* newline or } */
+size_t scan_line_end(const char *buf, size_t len, size_t pos);  /* newline */
+size_t scan_comment(const char *buf, size_t len, size_t pos);   /* # */
+size_t scan_syntax(const char *buf, size_t len, size_t pos);    /* # { } or newline */
+
+/* name of the kernel set in use ("avx2", "sse2" or "scalar") */
+const char *scan_kernel_name(void);
+
+#endif
@@ -0,0 +1,190 @@
+#include "session.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "util.h"
+
+#define SESSION_MAGIC "hyprwindows-session 1"
+
+/* --- path --- */
+
+char *session_path(void) {
+    const char *state = getenv("XDG_STATE_HOME");
+    const char *home = getenv("HOME");
+    char buf[1024];
+    if (state && state[0] == '/')
+        snprintf(buf, sizeof(buf), "%s/hyprwindows/session", state);
+    else if (home)
+        snprintf(buf, sizeof(buf), "%s/.local/state/hyprwindows/session", home);
+    else
+        return NULL;
+    return strdup(buf);
+}
+
+/* mkdir -p for every directory above path */
+static int make_parents(const char *path) {
+    char buf[1024];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0700) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return 0;
+}
+
+/* --- hashing --- */
+
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+}
+
+static uint64_t hash_str(uint64_t h, const char *s) {
+    for (const char *p = s ? s : ""; *p; p++) {
+        h ^= (unsigned char)*p;
+        h *= 1099511628211ull;
+    }
+    /* terminator, so ("ab","c") and ("a","bc") differ */
+    h ^= 0xff;
+    return h * 1099511628211ull;
+}
+
+uint64_t session_rules_hash(const struct ruleset *rs, const int *order) {
+    uint64_t h = 14695981039346656037ull ^ rs->count;
+    for (size_t i = 0; i < rs->count; i++) {
+        const struct rule *r = &rs->rules[order ? (size_t)order[i] : i];
+        h = mix(h ^ rule_fingerprint(r));
+    }
+    return h;
+}
+
+uint64_t session_clients_hash(const struct clients *cl) {
+    /* a sum of per-window hashes: hyprctl lists windows in focus order */
+    uint64_t sum = cl->count;
+    for (size_t i = 0; i < cl->count; i++) {
+        const struct client *c = &cl->items[i];
+        uint64_t h = 14695981039346656037ull;
+        h = hash_str(h, c->class_name);
+        h = hash_str(h, c->title);
+        h = hash_str(h, c->initial_class);
+        h = hash_str(h, c->initial_title);
+        h = hash_str(h, c->workspace_name);
+        h ^= (uint64_t)(unsigned)c->workspace_id << 8;
+        h ^= (uint64_t)(c->floating != 0) | (uint64_t)(c->xwayland != 0) << 1 |
+             (uint64_t)(c->fullscreen != 0) << 2 | (uint64_t)(c->pinned != 0) << 3;
+        sum += mix(h);
+    }
+    return sum;
+}
+
+/* --- load / save --- */
+
+static void copy_value(char *dst, size_t cap, const char *v) {
+    snprintf(dst, cap, "%s", v);
+}
+
+static int parse_status(struct session *s, const char *v) {
+    char *end;
+    size_t n = strtoull(v, &end, 10);
+    if (*end != ' ' || strlen(end + 1) != n) return -1;
+    for (const char *p = end + 1; *p; p++)
+        if (*p != SESSION_OK && *p != SESSION_UNUSED && *p != SESSION_DUPLICATE) return -1;
+    s->status = malloc(n ? n : 1);
+    if (!s->status) return -1;
+    memcpy(s->status, end + 1, n);
+    s->status_count = n;
+    return 0;
+}
+
+int session_load(const char *path, struct session *s) {
+    memset(s, 0, sizeof(*s));
+    if (!path) return -1;
+    char *buf = read_file(path, NULL);
+    if (!buf) return -1;
+
+    char *save = NULL;
+    char *line = strtok_r(buf, "\n", &save);
+    if (!line || strcmp(line, SESSION_MAGIC) != 0) {
+        free(buf);
+        return -1;
+    }
+    while ((line = strtok_r(NULL, "\n", &save))) {
+        char *v = strchr(line, ' ');
+        if (!v) continue;
+        *v++ = '\0';
+        if (strcmp(line, "rules") == 0) copy_value(s->rules_path, sizeof(s->rules_path), v);
+        else if (strcmp(line, "hash") == 0) s->rules_hash = strtoull(v, NULL, 16);
+        else if (strcmp(line, "view") == 0) s->view = atoi(v);
+        else if (strcmp(line, "sort") == 0) s->sort_mode = atoi(v);
+        else if (strcmp(line, "tree") == 0) s->tree_key = atoi(v);
+        else if (strcmp(line, "selected") == 0) s->selected = strtoull(v, NULL, 16);
+        else if (strcmp(line, "search") == 0) copy_value(s->search, sizeof(s->search), v);
+        else if (strcmp(line, "wfilter") == 0) copy_value(s->win_filter, sizeof(s->win_filter), v);
+        else if (strcmp(line, "wsort") == 0) s->win_sort = atoi(v);
+        else if (strcmp(line, "wgroup") == 0) s->win_group = atoi(v);
+        else if (strcmp(line, "clients") == 0) s->clients_hash = strtoull(v, NULL, 16);
+        else if (strcmp(line, "status") == 0 && !s->status && parse_status(s, v) != 0) {
+            /* a damaged cache is only a cache */
+            free(s->status);
+            s->status = NULL;
+            s->status_count = 0;
+        }
+    }
+    free(buf);
+    return 0;
+}
+
+/* text values are single-line; anything else would split the entry */
+static void put_value(FILE *f, const char *key, const char *v) {
+    fprintf(f, "%s ", key);
+    for (const char *p = v; *p; p++)
+        if (*p != '\n' && *p != '\r') fputc(*p, f);
+    fputc('\n', f);
+}
+
+int session_save(const char *path, const struct session *s) {
+    if (!path || make_parents(path) != 0) return -1;
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+
+    fprintf(f, "%s\n", SESSION_MAGIC);
+    put_value(f, "rules", s->rules_path);
+    fprintf(f, "hash %016llx\n", (unsigned long long)s->rules_hash);
+    fprintf(f, "view %d\nsort %d\ntree %d\n", s->view, s->sort_mode, s->tree_key);
+    fprintf(f, "selected %016llx\n", (unsigned long long)s->selected);
+    if (s->search[0]) put_value(f, "search", s->search);
+    if (s->win_filter[0]) put_value(f, "wfilter", s->win_filter);
+    fprintf(f, "wsort %d\nwgroup %d\n", s->win_sort, s->win_group);
+    if (s->status) {
+        fprintf(f, "clients %016llx\n", (unsigned long long)s->clients_hash);
+        fprintf(f, "status %zu ", s->status_count);
+        fwrite(s->status, 1, s->status_count, f);
+        fputc('\n', f);
+    }
+
+    int err = ferror(f);
+    if (fclose(f) != 0 || err || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+void session_free(struct session *s) {
+    if (!s) return;
+    free(s->status);
+    s->status = NULL;
+    s->status_count = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef HYPRWINDOWS_SESSION_H
+#define HYPRWINDOWS_SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hyprctl.h"
+#include "rules.h"
+
+/*
+ * Where the TUI left off, for resuming on the next launch.
+ *
+ * A short line-based file under $XDG_STATE_HOME/hyprwindows (default
+ * ~/.local/state/hyprwindows). View settings and the selection are always
+ * restored; the selection is stored as the rule's identity (see
+ * merge_identities) so it survives re-sorting. Per-rule status is cached
+ * in file order and only reused while the rules hash still matches; the
+ * unused flags additionally need the same set of open windows.
+ */
+
+struct session {
+    char rules_path[512];
+    uint64_t rules_hash;        /* session_rules_hash() of the file order */
+    int view;
+    int sort_mode;
+    int tree_key;
+    uint64_t selected;          /* identity of the selected rule, 0 = none */
+    char search[256];
+    char win_filter[64];
+    int win_sort, win_group;
+
+    /* status cache: one of SESSION_* per rule in file order, NULL = none */
+    char *status;
+    size_t status_count;
+    uint64_t clients_hash;      /* windows the unused flags were checked against */
+};
+
+#define SESSION_OK        '0'
+#define SESSION_UNUSED    '1'
+#define SESSION_DUPLICATE '2'
+
+/* the session file path (malloc'd), NULL without a home directory */
+char *session_path(void);
+
+/* 0 when a session was read; s is zeroed either way first */
+int session_load(const char *path, struct session *s);
+/* write via a temporary file and rename; creates the directory */
+int session_save(const char *path, const struct session *s);
+void session_free(struct session *s);
+
+/* content hash of rs->rules[order[i]] for i < rs->count (order NULL: as is) */
+uint64_t session_rules_hash(const struct ruleset *rs, const int *order);
+/* order-independent hash of the open windows' matchable fields */
+uint64_t session_clients_hash(const struct clients *cl);
+
+#endif
@@ -0,0 +1,145 @@
+#include "simulate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* match subjects each input feeds */
+static const unsigned sim_subjects[SIM_FIELD_COUNT] = {
+    [SIM_CLASS] = 1u << MS_CLASS,
+    [SIM_TITLE] = 1u << MS_TITLE,
+    [SIM_INITIAL_CLASS] = 1u << MS_INITIAL_CLASS,
+    [SIM_INITIAL_TITLE] = 1u << MS_INITIAL_TITLE,
+    [SIM_WORKSPACE] = 1u << MS_WORKSPACE | 1u << MS_WORKSPACE_NAME,
+    [SIM_FLOATING] = 1u << MS_FLOATING,
+    [SIM_XWAYLAND] = 1u << MS_XWAYLAND,
+    [SIM_FULLSCREEN] = 1u << MS_FULLSCREEN,
+    [SIM_PINNED] = 1u << MS_PINNED,
+};
+
+static int sim_flag(const char *s) {
+    return strcasecmp(s, "yes") == 0 || strcasecmp(s, "true") == 0 || strcmp(s, "1") == 0;
+}
+
+/* update the window from input f */
+static void sim_apply_input(struct simulator *s, enum sim_field f) {
+    const char *in = s->input[f];
+    struct client *w = &s->win;
+    switch (f) {
+    case SIM_WORKSPACE: {
+        /* a number is an id (and its own name); anything else a named
+         * workspace, which never has a positive id */
+        char *end = NULL;
+        long id = strtol(in, &end, 10);
+        int numeric = end != in && *end == '\0';
+        w->workspace_id = numeric ? (int)id : 0;
+        w->workspace_name = strncmp(in, "name:", 5) == 0 ? s->input[f] + 5 : s->input[f];
+        break;
+    }
+    case SIM_FLOATING: w->floating = sim_flag(in); break;
+    case SIM_XWAYLAND: w->xwayland = sim_flag(in); break;
+    case SIM_FULLSCREEN: w->fullscreen = sim_flag(in); break;
+    case SIM_PINNED: w->pinned = sim_flag(in); break;
+    default: break; /* text fields point into input */
+    }
+}
+
+int sim_init(struct simulator *s, const struct ruleset *rs) {
+    memset(s, 0, sizeof(*s));
+    s->rules = rs;
+    size_t n = rs->count ? rs->count : 1;
+    s->reads = calloc(n, sizeof(unsigned));
+    s->ok = calloc(n, 1);
+    if (!s->reads || !s->ok || match_set_build(&s->progs, rs) != 0) {
+        free(s->reads);
+        free(s->ok);
+        memset(s, 0, sizeof(*s));
+        return -1;
+    }
+    s->win.class_name = s->input[SIM_CLASS];
+    s->win.title = s->input[SIM_TITLE];
+    s->win.initial_class = s->input[SIM_INITIAL_CLASS];
+    s->win.initial_title = s->input[SIM_INITIAL_TITLE];
+    for (int f = 0; f < SIM_FIELD_COUNT; f++) sim_apply_input(s, (enum sim_field)f);
+    for (size_t i = 0; i < rs->count; i++) {
+        s->reads[i] = match_subjects(&s->progs.progs[i]);
+        s->ok[i] = (unsigned char)match_eval(&s->progs.progs[i], &s->win);
+    }
+    return 0;
+}
+
+void sim_set_field(struct simulator *s, enum sim_field f, const char *text) {
+    if (!s->ok || f >= SIM_FIELD_COUNT) return;
+    s->last_evaluated = 0;
+    if (strcmp(s->input[f], text) == 0) return;
+    snprintf(s->input[f], SIM_INPUT_MAX, "%s", text);
+    sim_apply_input(s, f);
+
+    for (size_t i = 0; i < s->rules->count; i++) {
+        if (!(s->reads[i] & sim_subjects[f])) continue;
+        s->ok[i] = (unsigned char)match_eval(&s->progs.progs[i], &s->win);
+        s->last_evaluated++;
+    }
+}
+
+int sim_rule_matches(const struct simulator *s, size_t rule_idx) {
+    if (!s->ok || rule_idx >= s->rules->count) return 0;
+    return s->ok[rule_idx];
+}
+
+struct sim_order { int order; int idx; };
+
+static int compare_sim_order(const void *a, const void *b) {
+    const struct sim_order *x = a, *y = b;
+    return x->order - y->order;
+}
+
+/* matching rules in file order, and the rule that wins each property */
+int sim_outcome(const struct simulator *s, const int *file_order, struct sim_outcome *out) {
+    memset(out, 0, sizeof(*out));
+    for (int f = 0; f < RF_COUNT; f++) out->source[f] = -1;
+
+    size_t n = s->rules->count;
+    struct sim_order *ord = malloc((n ? n : 1) * sizeof(*ord));
+    if (!ord) return -1;
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!sim_rule_matches(s, i)) continue;
+        ord[k].order = file_order ? file_order[i] : (int)i;
+        ord[k].idx = (int)i;
+        k++;
+    }
+    qsort(ord, k, sizeof(*ord), compare_sim_order);
+
+    out->matches = malloc((k ? k : 1) * sizeof(int));
+    if (!out->matches) { free(ord); return -1; }
+    for (size_t i = 0; i < k; i++) {
+        int ri = ord[i].idx;
+        out->matches[i] = ri;
+        const struct rule *r = &s->rules->rules[ri];
+        /* later rules override earlier ones, as Hyprland applies them top to bottom */
+        for (int f = RF_FIRST_SSO; f < RF_COUNT; f++) {
+            if (RF_MATCH_MASK & RF_BIT(f)) continue;
+            if (rule_has(r, (enum rule_field)f)) out->source[f] = ri;
+        }
+    }
+    out->match_count = k;
+    free(ord);
+    return 0;
+}
+
+void sim_outcome_free(struct sim_outcome *out) {
+    if (!out) return;
+    free(out->matches);
+    out->matches = NULL;
+    out->match_count = 0;
+}
+
+void sim_free(struct simulator *s) {
+    if (!s->ok) return;
+    match_set_free(&s->progs);
+    free(s->reads);
+    free(s->ok);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,60 @@
+#ifndef HYPRWINDOWS_SIMULATE_H
+#define HYPRWINDOWS_SIMULATE_H
+
+#include <stddef.h>
+
+#include "match.h"
+#include "rules.h"
+
+/*
+ * What-if matching of a hypothetical window against a ruleset.
+ *
+ * Every rule is compiled once into the same match program the status
+ * column and the apply path use (match.h), so the simulator cannot
+ * disagree with them. The window is described by text inputs: the
+ * class and title fields, a workspace id or name, and "yes"/"no" for
+ * each state flag. Changing one input only re-evaluates the rules whose
+ * program reads it.
+ */
+
+enum sim_field {
+    SIM_CLASS,
+    SIM_TITLE,
+    SIM_INITIAL_CLASS,
+    SIM_INITIAL_TITLE,
+    SIM_WORKSPACE,   /* id, or a name */
+    SIM_FLOATING,    /* flags from here on: "yes" or "no" */
+    SIM_XWAYLAND,
+    SIM_FULLSCREEN,
+    SIM_PINNED,
+    SIM_FIELD_COUNT,
+};
+
+#define SIM_FIRST_FLAG SIM_FLOATING
+#define SIM_INPUT_MAX 256
+
+struct simulator {
+    const struct ruleset *rules; /* borrowed; must outlive the simulator */
+    struct match_set progs;
+    unsigned *reads;             /* per rule: subjects its program reads */
+    unsigned char *ok;           /* per rule result */
+    char input[SIM_FIELD_COUNT][SIM_INPUT_MAX];
+    struct client win;           /* the window the inputs describe */
+    size_t last_evaluated;       /* rules evaluated by the last update */
+};
+
+/* cascaded outcome: which rule supplies each property (-1 = none) */
+struct sim_outcome {
+    int *matches;           /* matching rules, in file order */
+    size_t match_count;
+    int source[RF_COUNT];   /* last matching rule setting the field */
+};
+
+int sim_init(struct simulator *s, const struct ruleset *rs);
+void sim_set_field(struct simulator *s, enum sim_field f, const char *text);
+int sim_rule_matches(const struct simulator *s, size_t rule_idx);
+int sim_outcome(const struct simulator *s, const int *file_order, struct sim_outcome *out);
+void sim_outcome_free(struct sim_outcome *out);
+void sim_free(struct simulator *s);
+
+#endif
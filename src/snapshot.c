@@ -0,0 +1,167 @@
+#include "snapshot.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "diff.h"
+
+/* --- nodes --- */
+
+static uint64_t node_print(const struct rule *r) {
+    /* the label is derived, so rule_fingerprint leaves it out */
+    uint64_t h = rule_fingerprint(r);
+    for (const char *p = rule_label_or(r, ""); *p; p++) {
+        h ^= (unsigned char)*p;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static int node_same(const struct rule_node *n, const struct rule *r, uint64_t print) {
+    if (n->print != print) return 0;
+    if (strcmp(rule_label_or(&n->rule, ""), rule_label_or(r, "")) != 0) return 0;
+    return rule_changed_fields(&n->rule, r) == 0;
+}
+
+static void node_unref(struct rule_node *n) {
+    if (--n->refs > 0) return;
+    rule_free(&n->rule);
+    free(n);
+}
+
+static void version_free(struct rule_snapshot *s) {
+    for (size_t i = 0; i < s->count; i++) node_unref(s->nodes[i]);
+    free(s->nodes);
+    free(s);
+}
+
+/* --- publishing (UI thread) --- */
+
+void snapshot_domain_init(struct snapshot_domain *d) {
+    memset(d, 0, sizeof(*d));
+    d->epoch = 1;
+}
+
+void snapshot_domain_free(struct snapshot_domain *d) {
+    if (d->current) version_free(d->current);
+    while (d->retired) {
+        struct rule_snapshot *next = d->retired->next_retired;
+        version_free(d->retired);
+        d->retired = next;
+    }
+    memset(d, 0, sizeof(*d));
+}
+
+static size_t slot_of(uint64_t print, size_t mask) {
+    print ^= print >> 33;
+    print *= 0xff51afd7ed558ccdull;
+    return (size_t)(print ^ (print >> 33)) & mask;
+}
+
+int snapshot_publish(struct snapshot_domain *d, const struct ruleset *rs, unsigned long gen) {
+    struct rule_snapshot *prev = d->current;
+    struct rule_snapshot *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    s->nodes = malloc((rs->count ? rs->count : 1) * sizeof(struct rule_node *));
+    if (!s->nodes) {
+        free(s);
+        return -1;
+    }
+    s->gen = gen;
+
+    /* index the previous version's nodes so unchanged rules are shared */
+    size_t cap = 0;
+    struct rule_node **tab = NULL;
+    if (prev && prev->count > 0) {
+        cap = 16;
+        while (cap < prev->count * 2) cap <<= 1;
+        tab = calloc(cap, sizeof(*tab));
+        for (size_t i = 0; tab && i < prev->count; i++) {
+            size_t k = slot_of(prev->nodes[i]->print, cap - 1);
+            while (tab[k] && tab[k] != prev->nodes[i]) k = (k + 1) & (cap - 1);
+            tab[k] = prev->nodes[i];
+        }
+    }
+
+    for (size_t i = 0; i < rs->count; i++) {
+        const struct rule *r = &rs->rules[i];
+        uint64_t print = node_print(r);
+        struct rule_node *n = NULL;
+        if (tab) {
+            for (size_t k = slot_of(print, cap - 1); tab[k]; k = (k + 1) & (cap - 1)) {
+                if (node_same(tab[k], r, print)) {
+                    n = tab[k];
+                    break;
+                }
+            }
+        }
+        if (!n) {
+            n = calloc(1, sizeof(*n));
+            if (!n) {
+                s->count = i;
+                version_free(s);
+                free(tab);
+                return -1;
+            }
+            n->rule = rule_copy(r);
+            n->print = print;
+        }
+        n->refs++;
+        s->nodes[i] = n;
+    }
+    s->count = rs->count;
+    free(tab);
+
+    /* readers that saw the old pointer entered before the epoch moved */
+    __atomic_store_n(&d->current, s, __ATOMIC_SEQ_CST);
+    if (prev) {
+        prev->retired = __atomic_add_fetch(&d->epoch, 1, __ATOMIC_SEQ_CST);
+        prev->next_retired = d->retired;
+        d->retired = prev;
+    }
+    snapshot_collect(d);
+    return 0;
+}
+
+void snapshot_collect(struct snapshot_domain *d) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < SNAP_MAX_READERS; i++) {
+        uint64_t e = __atomic_load_n(&d->active[i], __ATOMIC_SEQ_CST);
+        if (e && e < oldest) oldest = e;
+    }
+    struct rule_snapshot **pp = &d->retired;
+    while (*pp) {
+        struct rule_snapshot *s = *pp;
+        if (s->retired <= oldest && __atomic_load_n(&s->pins, __ATOMIC_ACQUIRE) == 0) {
+            *pp = s->next_retired;
+            version_free(s);
+        } else {
+            pp = &s->next_retired;
+        }
+    }
+}
+
+/* --- readers (any thread) --- */
+
+struct rule_snapshot *snapshot_acquire(struct snapshot_domain *d) {
+    uint64_t e = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+    int slot = -1;
+    while (slot < 0) {
+        for (int i = 0; i < SNAP_MAX_READERS && slot < 0; i++) {
+            uint64_t idle = 0;
+            if (__atomic_compare_exchange_n(&d->active[i], &idle, e, 0,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+                slot = i;
+        }
+        if (slot < 0) sched_yield();
+    }
+    struct rule_snapshot *s = __atomic_load_n(&d->current, __ATOMIC_SEQ_CST);
+    if (s) __atomic_add_fetch(&s->pins, 1, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&d->active[slot], 0, __ATOMIC_RELEASE);
+    return s;
+}
+
+void snapshot_release(struct rule_snapshot *s) {
+    if (s) __atomic_sub_fetch(&s->pins, 1, __ATOMIC_ACQ_REL);
+}
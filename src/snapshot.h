@@ -0,0 +1,64 @@
+#ifndef HYPRWINDOWS_SNAPSHOT_H
+#define HYPRWINDOWS_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rules.h"
+
+/*
+ * Immutable, reference-counted ruleset versions for background readers.
+ *
+ * The UI thread keeps editing its own ruleset and publishes a version
+ * when a reader needs one. Versions are copy-on-write: a rule that did
+ * not change since the previous version shares its node with it, so
+ * publishing costs a fingerprint per rule plus copies of the edited ones.
+ *
+ * Readers pin the current version with snapshot_acquire() and unpin it
+ * with snapshot_release(); neither takes a lock. The window between
+ * loading the current pointer and counting the pin is covered by epochs:
+ * a replaced version is only freed once it is unpinned and no reader is
+ * still inside an acquire that began before it was replaced. Publishing
+ * and reclamation happen on the UI thread only.
+ */
+
+#define SNAP_MAX_READERS 8
+
+struct rule_node {
+    struct rule rule;
+    uint64_t print;     /* fingerprint plus label, for reuse across versions */
+    unsigned refs;      /* versions holding this node (publisher only) */
+};
+
+struct rule_snapshot {
+    struct rule_node **nodes;
+    size_t count;
+    unsigned long gen;  /* publisher's tag for the state this captures */
+    unsigned pins;      /* readers holding it; atomic */
+    uint64_t retired;   /* epoch it was replaced in, 0 while current */
+    struct rule_snapshot *next_retired;
+};
+
+struct snapshot_domain {
+    struct rule_snapshot *current;       /* atomic */
+    uint64_t epoch;                      /* atomic */
+    uint64_t active[SNAP_MAX_READERS];   /* epoch of an acquire in progress, 0 = free */
+    struct rule_snapshot *retired;       /* replaced, not yet freed */
+};
+
+void snapshot_domain_init(struct snapshot_domain *d);
+/* all readers must have released their versions */
+void snapshot_domain_free(struct snapshot_domain *d);
+
+/* publish rs as the current version (UI thread); returns 0 or -1 */
+int snapshot_publish(struct snapshot_domain *d, const struct ruleset *rs, unsigned long gen);
+/* free replaced versions no reader can reach any more (UI thread) */
+void snapshot_collect(struct snapshot_domain *d);
+
+/* pin the current version (any thread); NULL before the first publish */
+struct rule_snapshot *snapshot_acquire(struct snapshot_domain *d);
+void snapshot_release(struct rule_snapshot *s);
+
+#define snapshot_rule(s, i) ((const struct rule *)&(s)->nodes[i]->rule)
+
+#endif
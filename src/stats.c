@@ -0,0 +1,270 @@
+#include "stats.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "util.h"
+
+/* --- table --- */
+
+static unsigned key_hash(enum stats_kind kind, const char *s) {
+    unsigned h = 2166136261u ^ (unsigned)kind;
+    for (; *s; s++) {
+        /* labels compare case-insensitively, like the duplicate check */
+        unsigned char c = (unsigned char)*s;
+        h ^= kind == STATS_LABEL ? (unsigned char)tolower(c) : c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int key_equal(const struct rule_stats *s, const struct stats_bucket *b,
+                     enum stats_kind kind, unsigned hash, const char *key) {
+    if (b->kind != kind || b->hash != hash) return 0;
+    const char *k = rule_stats_key(s, b);
+    return kind == STATS_LABEL ? strcasecmp(k, key) == 0 : strcmp(k, key) == 0;
+}
+
+static int table_grow(struct rule_stats *s) {
+    size_t cap = (s->mask + 1) * 2;
+    struct stats_bucket *tab = calloc(cap, sizeof(*tab));
+    if (!tab) return -1;
+    for (size_t i = 0; i <= s->mask; i++) {
+        if (!s->table[i].count) continue;
+        size_t k = s->table[i].hash & (cap - 1);
+        while (tab[k].count) k = (k + 1) & (cap - 1);
+        tab[k] = s->table[i];
+    }
+    free(s->table);
+    s->table = tab;
+    s->mask = cap - 1;
+    return 0;
+}
+
+static int intern(struct rule_stats *s, const char *key, size_t *off) {
+    size_t len = strlen(key) + 1;
+    if (s->arena_len + len > s->arena_cap) {
+        size_t cap = s->arena_cap ? s->arena_cap : 1024;
+        while (cap < s->arena_len + len) cap *= 2;
+        char *a = realloc(s->arena, cap);
+        if (!a) return -1;
+        s->arena = a;
+        s->arena_cap = cap;
+    }
+    memcpy(s->arena + s->arena_len, key, len);
+    *off = s->arena_len;
+    s->arena_len += len;
+    return 0;
+}
+
+/* count one occurrence of (kind, key); returns the new count or 0 on failure */
+static size_t bump(struct rule_stats *s, enum stats_kind kind, const char *key) {
+    unsigned h = key_hash(kind, key);
+    size_t k = h & s->mask;
+    for (; s->table[k].count; k = (k + 1) & s->mask)
+        if (key_equal(s, &s->table[k], kind, h, key)) return ++s->table[k].count;
+
+    if ((s->used + 1) * 2 > s->mask + 1) {
+        if (table_grow(s) != 0) return 0;
+        k = h & s->mask;
+        while (s->table[k].count) k = (k + 1) & s->mask;
+    }
+    struct stats_bucket *b = &s->table[k];
+    if (intern(s, key, &b->key) != 0) return 0;
+    b->hash = h;
+    b->kind = kind;
+    b->count = 1;
+    s->used++;
+    return 1;
+}
+
+/* --- compute --- */
+
+struct order_entry {
+    const char *key;
+    size_t count;
+    size_t idx;
+};
+
+static int compare_order(const void *a, const void *b) {
+    const struct order_entry *x = a, *y = b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    /* "" (no tag / no workspace) after the named ones */
+    if (!x->key[0] || !y->key[0]) return !x->key[0] - !y->key[0];
+    return strcmp(x->key, y->key);
+}
+
+static int build_order(struct rule_stats *s) {
+    memset(s->kind_start, 0, sizeof(s->kind_start));
+    for (size_t i = 0; i <= s->mask; i++)
+        if (s->table[i].count) s->kind_start[s->table[i].kind + 1]++;
+    for (int k = 0; k < STATS_KIND_COUNT; k++) s->kind_start[k + 1] += s->kind_start[k];
+
+    struct order_entry *tmp = malloc((s->used ? s->used : 1) * sizeof(*tmp));
+    s->order = malloc((s->used ? s->used : 1) * sizeof(size_t));
+    if (!tmp || !s->order) {
+        free(tmp);
+        return -1;
+    }
+    size_t fill[STATS_KIND_COUNT];
+    memcpy(fill, s->kind_start, sizeof(fill));
+    for (size_t i = 0; i <= s->mask; i++) {
+        const struct stats_bucket *b = &s->table[i];
+        if (!b->count) continue;
+        tmp[fill[b->kind]++] = (struct order_entry){rule_stats_key(s, b), b->count, i};
+    }
+    for (int k = 0; k < STATS_KIND_COUNT; k++)
+        qsort(tmp + s->kind_start[k], s->kind_start[k + 1] - s->kind_start[k],
+              sizeof(*tmp), compare_order);
+    for (size_t i = 0; i < s->used; i++) s->order[i] = tmp[i].idx;
+    free(tmp);
+    return 0;
+}
+
+static const enum rule_field action_field[STATS_ACTION_COUNT] = {
+    [STATS_FLOAT] = RF_FLOAT,
+    [STATS_CENTER] = RF_CENTER,
+    [STATS_SIZE] = RF_SIZE,
+    [STATS_MOVE] = RF_MOVE,
+    [STATS_OPACITY] = RF_OPACITY,
+};
+
+int rule_stats_compute(struct rule_stats *s, const struct ruleset *rs, const unsigned char *unused) {
+    memset(s, 0, sizeof(*s));
+    size_t cap = 64;
+    while (cap < rs->count * 2) cap <<= 1;
+    s->table = calloc(cap, sizeof(*s->table));
+    if (!s->table) return -1;
+    s->mask = cap - 1;
+    s->rules = rs->count;
+    s->unused_checked = unused != NULL;
+
+    for (size_t i = 0; i < rs->count; i++) {
+        const struct rule *r = &rs->rules[i];
+        const char *tag = rule_get_or(r, RF_TAG, "");
+        if (tag[0] == '+') tag++;
+        if (!bump(s, STATS_TAG, tag)) goto fail;
+        if (!bump(s, STATS_WORKSPACE, rule_get_or(r, RF_WORKSPACE, ""))) goto fail;
+        for (size_t e = 0; e < r->extras_count; e++)
+            if (!bump(s, STATS_EXTRA, r->extras[e].key)) goto fail;
+
+        const char *label = rule_label_or(r, NULL);
+        if (label) {
+            size_t seen = bump(s, STATS_LABEL, label);
+            if (!seen) goto fail;
+            /* the first copy becomes a duplicate once a second shows up */
+            if (seen > 1) s->duplicates += seen == 2 ? 2 : 1;
+        }
+
+        for (int a = 0; a < STATS_ACTION_COUNT; a++) {
+            if (!rule_has(r, action_field[a])) continue;
+            s->action_set[a]++;
+            if (action_field[a] >= RF_STR_COUNT && rule_get_bool(r, action_field[a]))
+                s->action_on[a]++;
+        }
+        if (r->flags & RULE_F_BROKEN) s->broken++;
+        if (unused && unused[i]) s->unused++;
+    }
+    if (build_order(s) != 0) goto fail;
+    return 0;
+
+fail:
+    rule_stats_free(s);
+    return -1;
+}
+
+void rule_stats_free(struct rule_stats *s) {
+    if (!s) return;
+    free(s->table);
+    free(s->arena);
+    free(s->order);
+    memset(s, 0, sizeof(*s));
+}
+
+size_t rule_stats_count(const struct rule_stats *s, enum stats_kind kind) {
+    return s->order ? s->kind_start[kind + 1] - s->kind_start[kind] : 0;
+}
+
+const struct stats_bucket *rule_stats_at(const struct rule_stats *s, enum stats_kind kind, size_t i) {
+    if (i >= rule_stats_count(s, kind)) return NULL;
+    return &s->table[s->order[s->kind_start[kind] + i]];
+}
+
+const char *stats_action_name(enum stats_action a) {
+    switch (a) {
+    case STATS_FLOAT:   return "float";
+    case STATS_CENTER:  return "center";
+    case STATS_SIZE:    return "size";
+    case STATS_MOVE:    return "move";
+    case STATS_OPACITY: return "opacity";
+    default:            return "?";
+    }
+}
+
+/* --- output --- */
+
+static void print_section(FILE *f, const struct rule_stats *s, enum stats_kind kind,
+                          const char *title, const char *none, size_t top) {
+    size_t n = rule_stats_count(s, kind);
+    if (n == 0) return;
+    fprintf(f, "\n%s (%zu)\n", title, n);
+    size_t shown = top && top < n ? top : n;
+    for (size_t i = 0; i < shown; i++) {
+        const struct stats_bucket *b = rule_stats_at(s, kind, i);
+        const char *key = rule_stats_key(s, b);
+        fprintf(f, "  %6zu  %s\n", b->count, key[0] ? key : none);
+    }
+    if (shown < n) fprintf(f, "  ... %zu more\n", n - shown);
+}
+
+void rule_stats_print(FILE *f, const struct rule_stats *s, size_t top) {
+    fprintf(f, "%zu rules: %zu duplicate, %zu with config errors", s->rules, s->duplicates, s->broken);
+    if (s->unused_checked) fprintf(f, ", %zu unused", s->unused);
+    fprintf(f, "\n\nActions\n");
+    for (int a = 0; a < STATS_ACTION_COUNT; a++) {
+        fprintf(f, "  %-8s %6zu", stats_action_name((enum stats_action)a), s->action_set[a]);
+        if (action_field[a] >= RF_STR_COUNT) fprintf(f, "  (%zu on)", s->action_on[a]);
+        fputc('\n', f);
+    }
+    print_section(f, s, STATS_TAG, "Tags", "(untagged)", top);
+    print_section(f, s, STATS_WORKSPACE, "Workspaces", "(none)", top);
+    print_section(f, s, STATS_EXTRA, "Other keys", "?", top);
+}
+
+static void json_section(FILE *f, const struct rule_stats *s, enum stats_kind kind,
+                         const char *name, const char *field, const char *count) {
+    fprintf(f, ",\n  \"%s\": [", name);
+    size_t n = rule_stats_count(s, kind);
+    for (size_t i = 0; i < n; i++) {
+        const struct stats_bucket *b = rule_stats_at(s, kind, i);
+        const char *key = rule_stats_key(s, b);
+        fprintf(f, "%s\n    {\"%s\": ", i ? "," : "", field);
+        if (key[0]) json_put_string(f, key);
+        else fputs("null", f);
+        fprintf(f, ", \"%s\": %zu}", count, b->count);
+    }
+    fprintf(f, "%s]", n ? "\n  " : "");
+}
+
+void rule_stats_print_json(FILE *f, const struct rule_stats *s) {
+    fprintf(f, "{\n  \"rules\": %zu,\n", s->rules);
+    fprintf(f, "  \"status\": {\"duplicates\": %zu, \"errors\": %zu, \"unused\": ",
+            s->duplicates, s->broken);
+    if (s->unused_checked) fprintf(f, "%zu},\n", s->unused);
+    else fputs("null},\n", f);
+
+    fputs("  \"actions\": {", f);
+    for (int a = 0; a < STATS_ACTION_COUNT; a++) {
+        fprintf(f, "%s\"%s\": {\"set\": %zu", a ? ", " : "",
+                stats_action_name((enum stats_action)a), s->action_set[a]);
+        if (action_field[a] >= RF_STR_COUNT) fprintf(f, ", \"on\": %zu", s->action_on[a]);
+        fputc('}', f);
+    }
+    fputc('}', f);
+    json_section(f, s, STATS_TAG, "tags", "tag", "rules");
+    json_section(f, s, STATS_WORKSPACE, "workspaces", "workspace", "rules");
+    json_section(f, s, STATS_EXTRA, "other_keys", "key", "count");
+    fputs("\n}\n", f);
+}
@@ -0,0 +1,78 @@
+#ifndef HYPRWINDOWS_STATS_H
+#define HYPRWINDOWS_STATS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "rules.h"
+
+/*
+ * Ruleset statistics in a single pass.
+ *
+ * Every rule is hashed once into one open-addressing table keyed by
+ * (kind, text): its tag, its workspace, each extra key and its label.
+ * Key text is interned into one growing arena, so the whole summary
+ * costs a handful of allocations and does not point into the rules it
+ * was computed from. Labels seen more than once give the duplicate
+ * total, the same way the review view counts them.
+ */
+
+enum stats_kind {
+    STATS_TAG,
+    STATS_WORKSPACE,
+    STATS_EXTRA,
+    STATS_LABEL,  /* internal: duplicate detection */
+    STATS_KIND_COUNT,
+};
+
+enum stats_action {
+    STATS_FLOAT,
+    STATS_CENTER,
+    STATS_SIZE,
+    STATS_MOVE,
+    STATS_OPACITY,
+    STATS_ACTION_COUNT,
+};
+
+struct stats_bucket {
+    size_t key;    /* offset into the arena; "" for rules without one */
+    size_t count;
+    unsigned hash;
+    enum stats_kind kind;
+};
+
+struct rule_stats {
+    size_t rules;
+    size_t action_set[STATS_ACTION_COUNT];  /* rules setting the action */
+    size_t action_on[STATS_ACTION_COUNT];   /* booleans set to on */
+    size_t duplicates;                      /* rules sharing a label */
+    size_t broken;                          /* rules with a config error */
+    size_t unused;
+    int unused_checked;                     /* 0: no window data given */
+
+    struct stats_bucket *table;
+    size_t mask, used;
+    char *arena;
+    size_t arena_len, arena_cap;
+    /* table indices per kind, most frequent first */
+    size_t *order;
+    size_t kind_start[STATS_KIND_COUNT + 1];
+};
+
+/* unused[i] != 0 marks rule i as matching no open window; NULL when unknown.
+ * Returns 0 or -1 (out of memory). */
+int rule_stats_compute(struct rule_stats *s, const struct ruleset *rs, const unsigned char *unused);
+void rule_stats_free(struct rule_stats *s);
+
+size_t rule_stats_count(const struct rule_stats *s, enum stats_kind kind);
+/* i-th most frequent bucket of a kind */
+const struct stats_bucket *rule_stats_at(const struct rule_stats *s, enum stats_kind kind, size_t i);
+#define rule_stats_key(s, b) ((const char *)(s)->arena + (b)->key)
+
+const char *stats_action_name(enum stats_action a);
+
+/* plain text, at most top entries per section (0 = all) */
+void rule_stats_print(FILE *f, const struct rule_stats *s, size_t top);
+void rule_stats_print_json(FILE *f, const struct rule_stats *s);
+
+#endif
@@ -0,0 +1,173 @@
+#include "textwidth.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/* --- code points --- */
+
+/* decode one UTF-8 sequence; 0 when p does not start a valid one */
+static size_t utf8_decode(const unsigned char *p, uint32_t *cp) {
+    if (p[0] < 0x80) {
+        *cp = p[0];
+        return 1;
+    }
+    size_t len;
+    uint32_t v, min;
+    if ((p[0] & 0xe0) == 0xc0) { len = 2; v = p[0] & 0x1f; min = 0x80; }
+    else if ((p[0] & 0xf0) == 0xe0) { len = 3; v = p[0] & 0x0f; min = 0x800; }
+    else if ((p[0] & 0xf8) == 0xf0) { len = 4; v = p[0] & 0x07; min = 0x10000; }
+    else return 0;
+    for (size_t i = 1; i < len; i++) {
+        if ((p[i] & 0xc0) != 0x80) return 0;
+        v = v << 6 | (p[i] & 0x3f);
+    }
+    if (v < min || v > 0x10ffff || (v >= 0xd800 && v <= 0xdfff)) return 0;
+    *cp = v;
+    return len;
+}
+
+#define CP_ZWJ 0x200d
+#define CP_VS16 0xfe0f
+
+static int is_regional(uint32_t cp) { return cp >= 0x1f1e6 && cp <= 0x1f1ff; }
+static int is_skin_tone(uint32_t cp) { return cp >= 0x1f3fb && cp <= 0x1f3ff; }
+
+/* attaches to the previous character, in any locale */
+static int is_extender(uint32_t cp) {
+    return (cp >= 0x0300 && cp <= 0x036f) || (cp >= 0x1ab0 && cp <= 0x1aff) ||
+           (cp >= 0x1dc0 && cp <= 0x1dff) || (cp >= 0x20d0 && cp <= 0x20ff) ||
+           (cp >= 0xfe00 && cp <= 0xfe0f) || (cp >= 0xfe20 && cp <= 0xfe2f) ||
+           (cp >= 0x200b && cp <= 0x200f) || is_skin_tone(cp) ||
+           (cp >= 0xe0020 && cp <= 0xe007f);
+}
+
+/* East Asian wide and emoji blocks, for when the locale cannot tell */
+static int is_wide(uint32_t cp) {
+    return (cp >= 0x1100 && cp <= 0x115f) || (cp >= 0x2e80 && cp <= 0x303e) ||
+           (cp >= 0x3041 && cp <= 0xa4cf) || (cp >= 0xac00 && cp <= 0xd7a3) ||
+           (cp >= 0xf900 && cp <= 0xfaff) || (cp >= 0xfe30 && cp <= 0xfe4f) ||
+           (cp >= 0xff00 && cp <= 0xff60) || (cp >= 0xffe0 && cp <= 0xffe6) ||
+           (cp >= 0x1f300 && cp <= 0x1f64f) || (cp >= 0x1f900 && cp <= 0x1f9ff) ||
+           (cp >= 0x20000 && cp <= 0x3fffd);
+}
+
+/* columns of a lone code point; -1 for control characters */
+static int cp_width(uint32_t cp) {
+    if (cp < 0x20 || (cp >= 0x7f && cp < 0xa0)) return -1;
+    if (cp < 0x7f) return 1;
+    if (is_extender(cp)) return 0;
+    int w = wcwidth((wchar_t)cp);
+    if (w >= 0) return w;
+    return is_wide(cp) ? 2 : 1;
+}
+
+/* --- clusters --- */
+
+/* measure the grapheme cluster at s: its byte length goes to *len, the
+ * return value is its width. *clean is 0 when it must print as '?'. */
+static int next_cluster(const char *s, size_t *len, int *clean) {
+    const unsigned char *p = (const unsigned char *)s;
+    uint32_t base;
+    size_t n = utf8_decode(p, &base);
+    int w = n ? cp_width(base) : -1;
+    *clean = w >= 0;
+    if (w < 0) {
+        /* one byte at a time, so the rest of the string still decodes */
+        *len = n ? n : 1;
+        return 1;
+    }
+
+    for (;;) {
+        uint32_t cp;
+        size_t k = utf8_decode(p + n, &cp);
+        if (!k) break;
+        if (cp == CP_ZWJ) {
+            /* the joined character is drawn as part of this one */
+            uint32_t next;
+            size_t j = utf8_decode(p + n + k, &next);
+            n += k + (j && cp_width(next) >= 0 ? j : 0);
+        } else if (cp == CP_VS16) {
+            n += k;
+            if (w == 1) w = 2;  /* emoji presentation */
+        } else if (is_regional(base) && is_regional(cp) && n == 4) {
+            n += k;             /* a flag: two indicators, one glyph */
+            w = 2;
+        } else if (cp_width(cp) == 0) {
+            n += k;
+        } else {
+            break;
+        }
+    }
+    *len = n;
+    return w;
+}
+
+int text_width(const char *s) {
+    int total = 0;
+    while (s && *s) {
+        size_t len;
+        int clean;
+        total += next_cluster(s, &len, &clean);
+        s += len;
+    }
+    return total;
+}
+
+size_t text_fit(const char *s, int cols, int *width) {
+    size_t off = 0;
+    int used = 0;
+    while (s && s[off]) {
+        size_t len;
+        int clean;
+        int w = next_cluster(s + off, &len, &clean);
+        if (used + w > cols) break;
+        used += w;
+        off += len;
+    }
+    if (width) *width = used;
+    return off;
+}
+
+/* --- cells --- */
+
+const char *text_cell_get(struct text_cell *c, const char *s, int cols) {
+    if (cols < 0) cols = 0;
+    if (c->text && c->cols == cols) return c->text;
+    if (!s) s = "";
+
+    int measure = !c->text;
+    free(c->text);
+    /* never longer than the source plus padding: '?' replaces whole clusters */
+    char *out = malloc(strlen(s) + (size_t)cols + 1);
+    c->text = out;
+    c->cols = cols;
+    if (!out) return "";
+
+    size_t o = 0;
+    int used = 0, total = 0;
+    while (*s && (measure || (used < cols && used == total))) {
+        size_t len;
+        int clean;
+        int w = next_cluster(s, &len, &clean);
+        if (used + w <= cols && used == total) {
+            if (clean) memcpy(out + o, s, len);
+            else out[o] = '?';
+            o += clean ? len : 1;
+            used += w;
+        }
+        total += w;
+        s += len;
+    }
+    /* a wide character that did not fit leaves a gap to pad */
+    memset(out + o, ' ', (size_t)(cols - used));
+    out[o + (size_t)(cols - used)] = '\0';
+    if (measure) c->width = total;
+    return out;
+}
+
+void text_cell_reset(struct text_cell *c) {
+    free(c->text);
+    memset(c, 0, sizeof(*c));
+}
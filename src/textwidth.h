@@ -0,0 +1,36 @@
+#ifndef HYPRWINDOWS_TEXTWIDTH_H
+#define HYPRWINDOWS_TEXTWIDTH_H
+
+#include <stddef.h>
+
+/*
+ * Terminal column widths of UTF-8 text, one grapheme cluster at a time.
+ *
+ * A cluster is a base character plus whatever attaches to it: combining
+ * marks, variation selectors, emoji modifiers, zero-width-joined
+ * sequences and regional-indicator pairs. Wide characters take two
+ * columns; a cluster never gets split when cutting text to a width.
+ * Bytes that are not valid UTF-8 and control characters render as '?'.
+ */
+
+/* columns s takes when printed */
+int text_width(const char *s);
+
+/* bytes of the longest prefix of s that fits in cols columns; *width
+ * (may be NULL) gets the columns that prefix takes */
+size_t text_fit(const char *s, int cols, int *width);
+
+/* one string drawn into a fixed-width column; zeroed means empty. The
+ * owner resets the cell whenever the string changes. Until then the width
+ * is measured once and the rendering is only redone when the column
+ * width changes. */
+struct text_cell {
+    char *text;   /* s cut to cols columns and padded with spaces */
+    int cols;
+    int width;    /* columns of the whole string; valid while text is set */
+};
+
+const char *text_cell_get(struct text_cell *c, const char *s, int cols);
+void text_cell_reset(struct text_cell *c);
+
+#endif
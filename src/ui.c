@@ -1,18 +1,31 @@
 #include "ui.h"
 
 #include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
 #include <locale.h>
 #include <notcurses/notcurses.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <termios.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "actions.h"
+#include "appmap.h"
+#include "diff.h"
 #include "hyprctl.h"
+#include "match.h"
+#include "merge.h"
+#include "preview.h"
+#include "rulesjson.h"
+#include "session.h"
+#include "simulate.h"
+#include "snapshot.h"
+#include "stats.h"
 #include "rules.h"
 #include "util.h"
 #include "history.h"
@@ -47,6 +60,115 @@ enum sort_mode {
 struct ui_state_machine;
 typedef struct ui_state_machine ui_state_machine_t;
 
+/* review view model, rebuilt once per status change so drawing and
+ * navigation only touch the visible rows */
+struct review_index {
+    int *unused;          /* rule indices with RULE_UNUSED, ascending */
+    int unused_count;
+    int unused_cap;
+    int dup_rules;        /* rules flagged RULE_DUPLICATE */
+    int dup_groups;       /* distinct labels among them */
+    int missing_count;
+    /* display rows: [unused header] unused... [missing header] missing... */
+    int missing_hdr_row;  /* -1 when there is no missing section */
+    int display_total;
+    unsigned long gen;    /* status_gen this was built for */
+    int built;
+};
+
+/* unused-rule check running on a pinned ruleset version */
+struct status_scan {
+    pthread_t tid;
+    int running;
+    int wanted;                  /* start one when the main loop is next idle */
+    int done, cancel;            /* atomic */
+    unsigned long gen;           /* status_gen it started from */
+    struct rule_snapshot *snap;  /* pinned for the worker */
+    const struct clients *clients;
+    unsigned char *check;        /* per rule: not a duplicate, needs a window check */
+    unsigned char *unused;       /* per rule: result */
+};
+
+/* windows view ordering, cycled with 's' */
+enum win_sort { WSORT_HYPRLAND, WSORT_CLASS, WSORT_TITLE, WSORT_WORKSPACE, WSORT_MATCHES };
+#define WSORT_COUNT 5
+
+struct win_group {
+    int ws_id;
+    const char *ws_name;  /* borrowed from the first client */
+    int count;            /* windows passing the filter */
+    int collapsed;
+};
+
+/* windows view model. Each layer is rebuilt only when its own inputs
+ * move: match counts when clients or rules change, the order on a sort
+ * or grouping change, the filtered list when the query changes (narrowing
+ * the previous result when the query only grew), rows on a collapse. */
+struct window_index {
+    int *matches;             /* per client: rules matching it */
+    int *order;               /* client indices in display order */
+    int *shown;               /* order minus filtered-out windows */
+    int *rows;                /* >= 0 client index, < 0 header of group -row-1 */
+    struct win_group *groups;
+    size_t cap;
+    int shown_count, row_count, group_count;
+    unsigned long counts_gen;     /* status_gen the counts were built for */
+    unsigned long clients_gen;    /* clients_gen the counts were built for */
+    enum win_sort order_sort;
+    int order_group;
+    char shown_filter[64];
+    int counts_ok, order_ok, shown_ok, rows_ok;
+    /* per client WCELL_COUNT rendered columns, for the clients_gen below */
+    struct text_cell *cells;
+    size_t cells_count;
+    unsigned long cells_gen;
+};
+
+/* rules view grouping, cycled with 't' */
+enum tree_key { TREE_OFF, TREE_TAG, TREE_WORKSPACE };
+#define TREE_KEY_COUNT 3
+
+struct rule_group {
+    char *key;        /* tag or workspace, "" for rules without one */
+    int count;
+    int unused, dups, modified;
+    int collapsed;
+    int row;          /* display row of the header, -1 while empty */
+};
+
+/* what one rule last added to its group's aggregates */
+#define TREE_B_UNUSED 0x1
+#define TREE_B_DUP    0x2
+#define TREE_B_MOD    0x4
+
+struct tree_slot {
+    int group;
+    unsigned char bits;  /* TREE_B_* */
+};
+
+/* rules grouped by tag or workspace. Aggregates move by per-rule deltas:
+ * an edit re-keys just that rule, and a status or index change only
+ * touches the groups of rules whose contribution actually changed. */
+struct rule_tree {
+    enum tree_key key;
+    struct rule_group *groups;  /* never shrinks while the key stays */
+    int group_count, group_cap;
+    int *sorted;                /* groups by key, "" last */
+    int sorted_ok;
+    int *table;                 /* key hash -> group + 1 */
+    size_t table_mask;
+    struct tree_slot *slots;    /* per rule */
+    size_t slot_count, slot_cap;
+    unsigned long gen;          /* status_gen the slots were synced at */
+    int *rows;                  /* >= 0 rule index, < 0 header of group -row-1 */
+    int *row_of;                /* per rule: display row, -1 while folded */
+    int row_count;
+    int rows_ok;
+    int header;                 /* group under the cursor, -1 on a rule */
+    int header_anchor;          /* st->selected when the header was picked */
+    int built, failed;
+};
+
 struct ui_state {
     int selected;
     int scroll;
@@ -62,13 +184,49 @@ struct ui_state {
     enum sort_mode sort_mode;
     int *file_order; /* original index of each rule (for SORT_FILE_ORDER) */
 
+    /* rules view tree (TREE_OFF = flat list) */
+    struct rule_tree tree;
+
     /* cached review data */
     struct missing_rules missing;
     int review_loaded;
+    struct review_index review;
+    struct appmap appmap; /* known apps, loaded with the review data */
+
+    /* bumped whenever rule indices, rule_status or missing change */
+    unsigned long status_gen;
 
     /* cached window data */
     struct clients clients;
     int clients_loaded;
+    unsigned long clients_gen;  /* bumped whenever clients is replaced */
+    unsigned long status_clients_gen;  /* clients_gen the unused flags were checked at */
+
+    /* windows view: sort, filter-as-you-type, workspace groups */
+    enum win_sort win_sort;
+    int win_group;
+    char win_filter[64];
+    int win_filter_editing;
+    int *win_collapsed;         /* workspace ids folded while grouped */
+    int win_collapsed_count;
+    struct window_index windex;
+
+    /* bumped by in-place rule edits, which leave status_gen alone */
+    unsigned long edit_gen;
+
+    /* summary for the actions view, rebuilt when either gen moves */
+    struct rule_stats stats;
+    unsigned long stats_gen, stats_edit;
+    int stats_ok;
+
+    /* compiled match programs, rebuilt when status_gen moves; an in-place
+     * edit recompiles its own rule (matchers_rule_changed) */
+    struct match_set matchers;
+    unsigned long matchers_gen;
+
+    /* versions of the rules for background readers */
+    struct snapshot_domain snaps;
+    struct status_scan scan;
 
     /* dirty tracking */
     int modified;
@@ -81,6 +239,23 @@ struct ui_state {
     /* per-rule modified tracking */
     int *rule_modified;
 
+    /* multi-select (parallel to rules) */
+    unsigned char *rule_marked;
+    size_t marked_count;
+    int mark_anchor;
+
+    /* rules file as last loaded or saved, for merging external edits */
+    struct merge_base base;
+    struct timespec base_mtime;
+    off_t base_size;
+
+    /* errors from the last reload, mapped onto rules via RULE_F_BROKEN */
+    struct config_errors cfg_errors;
+
+    /* where the last run left off; status is dropped once adopted */
+    struct session session;
+    char search_query[256];     /* last '/' query, kept across searches */
+
     /* status message */
     char status[256];
 };
@@ -155,6 +330,10 @@ static void ui_reset_color(struct ncplane *n) {
 static void clean_class_name(const char *regex, char *out, size_t out_sz);
 static void update_display_name(struct rule *r);
 static void compute_rule_status(struct ui_state *st);
+static void status_scan_stop(struct ui_state *st);
+static void rule_tree_touch(struct ui_state *st, size_t i);
+static void matchers_rule_changed(struct ui_state *st, size_t i);
+static void clients_adopt(struct ui_state *st, struct clients *cur, int rescan);
 static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_index, struct history_stack *history);
 static int confirm_dialog(ui_state_machine_t *sm, const char *title, const char *msg);
 static void run_with_spinner(ui_state_machine_t *sm, const char *msg,
@@ -169,16 +348,27 @@ static void handle_actions_input(ui_state_machine_t *sm, uint32_t id, ncinput *n
 
 /* --- parallel array helpers --- */
 
+/* flag a rule edited in place; indices are unchanged */
+static void mark_rule_modified(struct ui_state *st, int idx) {
+    if (st->rule_modified) st->rule_modified[idx] = 1;
+    st->edit_gen++;
+    rule_tree_touch(st, (size_t)idx);
+    matchers_rule_changed(st, (size_t)idx);
+}
+
 /* remove rule at index, shifting all parallel arrays down */
 static void remove_rule_at(struct ui_state *st, int idx) {
     rule_free(&st->rules.rules[idx]);
+    if (st->rule_marked && st->rule_marked[idx]) st->marked_count--;
     for (int i = idx; i < (int)st->rules.count - 1; i++) {
         st->rules.rules[i] = st->rules.rules[i + 1];
         if (st->rule_status) st->rule_status[i] = st->rule_status[i + 1];
         if (st->rule_modified) st->rule_modified[i] = st->rule_modified[i + 1];
         if (st->file_order) st->file_order[i] = st->file_order[i + 1];
+        if (st->rule_marked) st->rule_marked[i] = st->rule_marked[i + 1];
     }
     st->rules.count--;
+    st->status_gen++;
 }
 
 /* insert rule at index, shifting all parallel arrays up; returns 0 on success, -1 on failure */
@@ -195,6 +385,8 @@ static int insert_rule_at(struct ui_state *st, int idx, const struct rule *r) {
     if (nm) st->rule_modified = nm;
     int *nf = realloc(st->file_order, st->rules.count * sizeof(int));
     if (nf) st->file_order = nf;
+    unsigned char *nk = realloc(st->rule_marked, st->rules.count);
+    if (nk) st->rule_marked = nk;
 
     /* shift elements up from the end */
     for (int i = (int)st->rules.count - 1; i > idx; i--) {
@@ -202,6 +394,7 @@ static int insert_rule_at(struct ui_state *st, int idx, const struct rule *r) {
         if (st->rule_status) st->rule_status[i] = st->rule_status[i - 1];
         if (st->rule_modified) st->rule_modified[i] = st->rule_modified[i - 1];
         if (st->file_order) st->file_order[i] = st->file_order[i - 1];
+        if (st->rule_marked) st->rule_marked[i] = st->rule_marked[i - 1];
     }
 
     /* place the rule */
@@ -209,6 +402,8 @@ static int insert_rule_at(struct ui_state *st, int idx, const struct rule *r) {
     if (st->rule_status) st->rule_status[idx] = RULE_OK;
     if (st->rule_modified) st->rule_modified[idx] = 1;
     if (st->file_order) st->file_order[idx] = idx;
+    if (st->rule_marked) st->rule_marked[idx] = 0;
+    st->status_gen++;
     return 0;
 }
 
@@ -227,6 +422,9 @@ static int append_rule(struct ui_state *st) {
     if (nm) { st->rule_modified = nm; st->rule_modified[idx] = 0; }
     int *nf = realloc(st->file_order, st->rules.count * sizeof(int));
     if (nf) { st->file_order = nf; st->file_order[idx] = idx; }
+    unsigned char *nk = realloc(st->rule_marked, st->rules.count);
+    if (nk) { st->rule_marked = nk; st->rule_marked[idx] = 0; }
+    st->status_gen++;
     return idx;
 }
 
@@ -242,6 +440,67 @@ static void delete_rule_with_history(struct ui_state *st, int idx, const char *d
     compute_rule_status(st);
 }
 
+/* drop every rule with drop[i] set in a single compaction pass over all parallel arrays */
+static void remove_rules_masked(struct ui_state *st, const unsigned char *drop) {
+    size_t out = 0;
+    for (size_t i = 0; i < st->rules.count; i++) {
+        if (drop[i]) {
+            rule_free(&st->rules.rules[i]);
+            if (st->rule_marked && st->rule_marked[i]) st->marked_count--;
+            continue;
+        }
+        if (out != i) {
+            st->rules.rules[out] = st->rules.rules[i];
+            if (st->rule_status) st->rule_status[out] = st->rule_status[i];
+            if (st->rule_modified) st->rule_modified[out] = st->rule_modified[i];
+            if (st->file_order) st->file_order[out] = st->file_order[i];
+            if (st->rule_marked) st->rule_marked[out] = st->rule_marked[i];
+        }
+        out++;
+    }
+    st->rules.count = out;
+    st->status_gen++;
+}
+
+/* insert copies of rules[k] so they end up at final index at[k] (ascending), in a
+ * single pass from the end; returns 0 on success, -1 on failure */
+static int insert_rules_at(struct ui_state *st, const int *at, const struct rule *const *rules, size_t k) {
+    size_t old_n = st->rules.count, new_n = old_n + k;
+    if (k == 0) return 0;
+
+    enum rule_status *ns = realloc(st->rule_status, new_n * sizeof(enum rule_status));
+    if (ns) st->rule_status = ns;
+    int *nm = realloc(st->rule_modified, new_n * sizeof(int));
+    if (nm) st->rule_modified = nm;
+    int *nf = realloc(st->file_order, new_n * sizeof(int));
+    if (nf) st->file_order = nf;
+    unsigned char *nk = realloc(st->rule_marked, new_n);
+    if (nk) st->rule_marked = nk;
+    if (ruleset_insert(&st->rules, at, rules, k) != 0) return -1;
+
+    /* the parallel arrays follow the same walk */
+    size_t src = old_n;
+    size_t j = k;
+    for (size_t dst = new_n; dst-- > 0;) {
+        if (j > 0 && (size_t)at[j - 1] >= dst) {
+            j--;
+            if (st->rule_status) st->rule_status[dst] = RULE_OK;
+            if (st->rule_modified) st->rule_modified[dst] = 1;
+            if (st->file_order) st->file_order[dst] = (int)dst;
+            if (st->rule_marked) st->rule_marked[dst] = 0;
+        } else {
+            src--;
+            if (src == dst) break; /* everything below is already in place */
+            if (st->rule_status) st->rule_status[dst] = st->rule_status[src];
+            if (st->rule_modified) st->rule_modified[dst] = st->rule_modified[src];
+            if (st->file_order) st->file_order[dst] = st->file_order[src];
+            if (st->rule_marked) st->rule_marked[dst] = st->rule_marked[src];
+        }
+    }
+    st->status_gen++;
+    return 0;
+}
+
 static void set_status(struct ui_state *st, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
@@ -286,23 +545,28 @@ static void permute_rules(struct ui_state *st, int *idx) {
     enum rule_status *tmp_status = st->rule_status ? malloc(n * sizeof(enum rule_status)) : NULL;
     int *tmp_modified = st->rule_modified ? malloc(n * sizeof(int)) : NULL;
     int *tmp_fo = st->file_order ? malloc(n * sizeof(int)) : NULL;
+    unsigned char *tmp_marked = st->rule_marked ? malloc(n) : NULL;
 
     for (size_t i = 0; i < n; i++) {
         tmp_rules[i] = st->rules.rules[idx[i]];
         if (tmp_status) tmp_status[i] = st->rule_status[idx[i]];
         if (tmp_modified) tmp_modified[i] = st->rule_modified[idx[i]];
         if (tmp_fo) tmp_fo[i] = st->file_order[idx[i]];
+        if (tmp_marked) tmp_marked[i] = st->rule_marked[idx[i]];
     }
 
     memcpy(st->rules.rules, tmp_rules, n * sizeof(struct rule));
     if (tmp_status) memcpy(st->rule_status, tmp_status, n * sizeof(enum rule_status));
     if (tmp_modified) memcpy(st->rule_modified, tmp_modified, n * sizeof(int));
     if (tmp_fo) memcpy(st->file_order, tmp_fo, n * sizeof(int));
+    if (tmp_marked) memcpy(st->rule_marked, tmp_marked, n);
 
     free(tmp_rules);
     free(tmp_status);
     free(tmp_modified);
     free(tmp_fo);
+    free(tmp_marked);
+    st->status_gen++;
 }
 
 /* sort context for index-based comparators */
@@ -310,18 +574,16 @@ static struct ui_state *sort_ctx;
 
 static int compare_idx_by_tag(const void *a, const void *b) {
     int ia = *(const int *)a, ib = *(const int *)b;
-    const char *ta = sort_ctx->rules.rules[ia].actions.tag ? sort_ctx->rules.rules[ia].actions.tag : "";
-    const char *tb = sort_ctx->rules.rules[ib].actions.tag ? sort_ctx->rules.rules[ib].actions.tag : "";
+    const char *ta = rule_get_or(&sort_ctx->rules.rules[ia], RF_TAG, "");
+    const char *tb = rule_get_or(&sort_ctx->rules.rules[ib], RF_TAG, "");
     return strcmp(ta, tb);
 }
 
 static int compare_idx_by_name(const void *a, const void *b) {
     int ia = *(const int *)a, ib = *(const int *)b;
-    const struct rule *ra = &sort_ctx->rules.rules[ia];
-    const struct rule *rb = &sort_ctx->rules.rules[ib];
-    const char *na = ra->display_name ? ra->display_name : ra->name ? ra->name : "";
-    const char *nb = rb->display_name ? rb->display_name : rb->name ? rb->name : "";
-    return strcasecmp(na, nb);
+    /* folded once per rule version instead of per comparison */
+    return strcmp(rule_fold_label(&sort_ctx->rules.rules[ia]),
+                  rule_fold_label(&sort_ctx->rules.rules[ib]));
 }
 
 static int compare_idx_by_status(const void *a, const void *b) {
@@ -331,11 +593,8 @@ static int compare_idx_by_status(const void *a, const void *b) {
     /* sort errors/warnings first: DUPLICATE(2) > UNUSED(1) > OK(0) */
     if (sa != sb) return sb - sa;
     /* tie-break by name */
-    const struct rule *ra = &sort_ctx->rules.rules[ia];
-    const struct rule *rb = &sort_ctx->rules.rules[ib];
-    const char *na = ra->display_name ? ra->display_name : ra->name ? ra->name : "";
-    const char *nb = rb->display_name ? rb->display_name : rb->name ? rb->name : "";
-    return strcasecmp(na, nb);
+    return strcmp(rule_fold_label(&sort_ctx->rules.rules[ia]),
+                  rule_fold_label(&sort_ctx->rules.rules[ib]));
 }
 
 static int compare_idx_by_file_order(const void *a, const void *b) {
@@ -367,60 +626,214 @@ static void apply_sort(struct ui_state *st) {
     free(idx);
 }
 
-static int rules_duplicate(const struct rule *a, const struct rule *b) {
-    /* duplicate if they share the same effective name */
-    const char *na = a->display_name ? a->display_name : a->name;
-    const char *nb = b->display_name ? b->display_name : b->name;
-    if (!na || !nb) return 0;
-    return strcasecmp(na, nb) == 0;
+/* case-insensitive label -> occurrence count, open addressing */
+struct label_count {
+    const char *label;
+    int count;
+    int group; /* 1-based duplicate group, 0 = not assigned */
+};
+
+static uint32_t label_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    for (; *s; s++) {
+        h ^= (uint32_t)tolower((unsigned char)*s);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static struct label_count *label_slot(struct label_count *tab, size_t mask, const char *label) {
+    size_t i = label_hash(label) & mask;
+    while (tab[i].label && strcasecmp(tab[i].label, label) != 0)
+        i = (i + 1) & mask;
+    return &tab[i];
+}
+
+/* count every rule label; returns the table (size *mask_out + 1) or NULL */
+static struct label_count *count_labels(struct ui_state *st, const unsigned char *refresh,
+                                        size_t *mask_out) {
+    size_t n = st->rules.count;
+    size_t cap = 16;
+    while (cap < n * 2) cap <<= 1;
+    struct label_count *tab = calloc(cap, sizeof(*tab));
+    if (!tab) return NULL;
+
+    for (size_t i = 0; i < n; i++) {
+        if (refresh && refresh[i]) update_display_name(&st->rules.rules[i]);
+        const char *label = rule_label_or(&st->rules.rules[i], NULL);
+        if (!label) continue;
+        struct label_count *lc = label_slot(tab, cap - 1, label);
+        lc->label = label;
+        lc->count++;
+    }
+    *mask_out = cap - 1;
+    return tab;
 }
 
 static void load_clients(struct ui_state *st) {
     if (st->clients_loaded) return;
-    clients_free(&st->clients);
-    memset(&st->clients, 0, sizeof(st->clients));
-    hyprctl_clients(&st->clients);
+    /* a scan cut short here has to run again on the new list */
+    int rescan = st->scan.running || st->scan.wanted;
+    status_scan_stop(st);
+    struct clients cur;
+    hyprctl_clients(&cur);
+    clients_adopt(st, &cur, rescan);
     st->clients_loaded = 1;
 }
 
+/* below this many rule/window pairs the unused check runs inline */
+#define STATUS_SCAN_ASYNC_MIN 200000
+
 static void compute_rule_status(struct ui_state *st) {
+    st->status_gen++;
     free(st->rule_status);
     st->rule_status = calloc(st->rules.count, sizeof(enum rule_status));
     if (!st->rule_status) return;
 
     load_clients(st);
+    st->status_clients_gen = st->clients_gen;
+    int async = st->rules.count * st->clients.count >= STATUS_SCAN_ASYNC_MIN;
 
     /* ensure display_name is populated before duplicate check */
     for (size_t i = 0; i < st->rules.count; i++) {
         update_display_name(&st->rules.rules[i]);
     }
 
+    /* one pass over a label count instead of comparing every pair */
+    size_t mask = 0;
+    struct label_count *tab = count_labels(st, NULL, &mask);
     for (size_t i = 0; i < st->rules.count; i++) {
         struct rule *r = &st->rules.rules[i];
+        const char *label = rule_label_or(r, NULL);
+        if (tab && label && label_slot(tab, mask, label)->count > 1)
+            st->rule_status[i] = RULE_DUPLICATE;
 
-        for (size_t j = 0; j < st->rules.count; j++) {
-            if (i != j && rules_duplicate(r, &st->rules.rules[j])) {
-                st->rule_status[i] = RULE_DUPLICATE;
-                break;
+        if (st->rule_status[i] == RULE_OK && st->clients.count > 0 && !async) {
+            if (!rule_matches_any_client(r, &st->clients)) {
+                st->rule_status[i] = RULE_UNUSED;
             }
         }
+    }
+    free(tab);
+    /* large sets are checked against windows off the UI thread */
+    st->scan.wanted = async;
+}
 
-        if (st->rule_status[i] == RULE_OK && st->clients.count > 0) {
-            int matched = 0;
-            for (size_t c = 0; c < st->clients.count; c++) {
-                if (rule_matches_client(r, &st->clients.items[c])) {
-                    matched = 1;
-                    break;
-                }
-            }
-            if (!matched) {
+/* incremental status update after a bulk change that did not touch match fields
+ * of surviving rules: duplicate flags are recounted in O(n), and client matching
+ * is only redone for rules that stopped being duplicates or are flagged in recheck */
+static void refresh_rule_status(struct ui_state *st, const unsigned char *recheck) {
+    size_t n = st->rules.count;
+    size_t mask;
+    struct label_count *tab = st->rule_status ? count_labels(st, recheck, &mask) : NULL;
+    if (!tab) {
+        compute_rule_status(st);
+        return;
+    }
+    st->status_gen++;
+
+    for (size_t i = 0; i < n; i++) {
+        struct rule *r = &st->rules.rules[i];
+        const char *label = rule_label_or(r, NULL);
+        int dup = label && label_slot(tab, mask, label)->count > 1;
+
+        if (dup) {
+            st->rule_status[i] = RULE_DUPLICATE;
+        } else if (st->rule_status[i] == RULE_DUPLICATE || (recheck && recheck[i])) {
+            st->rule_status[i] = RULE_OK;
+            if (st->clients.count > 0 && !rule_matches_any_client(r, &st->clients))
                 st->rule_status[i] = RULE_UNUSED;
+        }
+    }
+    free(tab);
+}
+
+/* --- background status scan --- */
+
+static void *status_scan_fn(void *arg) {
+    struct status_scan *sc = arg;
+    for (size_t i = 0; i < sc->snap->count; i++) {
+        if (__atomic_load_n(&sc->cancel, __ATOMIC_RELAXED)) break;
+        if (sc->check[i])
+            sc->unused[i] = !rule_matches_any_client(snapshot_rule(sc->snap, i), sc->clients);
+    }
+    __atomic_store_n(&sc->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void status_scan_reset(struct ui_state *st) {
+    struct status_scan *sc = &st->scan;
+    snapshot_release(sc->snap);
+    free(sc->check);
+    free(sc->unused);
+    int wanted = sc->wanted;
+    memset(sc, 0, sizeof(*sc));
+    sc->wanted = wanted;
+    snapshot_collect(&st->snaps);
+}
+
+static void status_scan_stop(struct ui_state *st) {
+    struct status_scan *sc = &st->scan;
+    if (!sc->running) return;
+    __atomic_store_n(&sc->cancel, 1, __ATOMIC_RELAXED);
+    pthread_join(sc->tid, NULL);
+    status_scan_reset(st);
+}
+
+static void status_scan_start(struct ui_state *st) {
+    struct status_scan *sc = &st->scan;
+    size_t n = st->rules.count;
+    sc->wanted = 0;
+    if (!st->rule_status || st->clients.count == 0) return;
+
+    /* the worker reads its own version, so edits can carry on meanwhile */
+    struct rule_snapshot *cur = st->snaps.current;
+    if ((!cur || cur->gen != st->status_gen || cur->count != n) &&
+        snapshot_publish(&st->snaps, &st->rules, st->status_gen) != 0)
+        return;
+    sc->snap = snapshot_acquire(&st->snaps);
+    sc->check = calloc(n ? n : 1, 1);
+    sc->unused = calloc(n ? n : 1, 1);
+    if (!sc->snap || !sc->check || !sc->unused) {
+        status_scan_reset(st);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) sc->check[i] = st->rule_status[i] != RULE_DUPLICATE;
+    sc->gen = st->status_gen;
+    sc->clients = &st->clients;
+    if (pthread_create(&sc->tid, NULL, status_scan_fn, sc) != 0) {
+        status_scan_reset(st);
+        return;
+    }
+    sc->running = 1;
+}
+
+/* main-loop step: adopt a finished scan, start a wanted one */
+static void status_scan_poll(struct ui_state *st) {
+    struct status_scan *sc = &st->scan;
+    if (sc->running) {
+        if (!__atomic_load_n(&sc->done, __ATOMIC_ACQUIRE)) {
+            /* the rules moved on: this result would be stale */
+            if (sc->gen != st->status_gen) __atomic_store_n(&sc->cancel, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        pthread_join(sc->tid, NULL);
+        if (!sc->cancel && sc->gen == st->status_gen && sc->snap->count == st->rules.count) {
+            for (size_t i = 0; i < st->rules.count; i++) {
+                if (!sc->check[i] || st->rule_status[i] == RULE_DUPLICATE) continue;
+                st->rule_status[i] = sc->unused[i] ? RULE_UNUSED : RULE_OK;
             }
+            st->status_gen++;
+        } else {
+            sc->wanted = 1;
         }
+        status_scan_reset(st);
     }
+    if (sc->wanted) status_scan_start(st);
 }
 
 static void load_review_data(struct ui_state *st) {
+    st->status_gen++;
     missing_rules_free(&st->missing);
     st->review_loaded = 0;
 
@@ -429,6 +842,8 @@ static void load_review_data(struct ui_state *st) {
     find_missing_rules(path ? path : st->rules_path,
                        appmap_path ? appmap_path : st->appmap_path,
                        st->dotfiles_path, &st->missing);
+    appmap_free(&st->appmap);
+    appmap_load(appmap_path ? appmap_path : st->appmap_path, &st->appmap);
     free(appmap_path);
     free(path);
 
@@ -440,7 +855,7 @@ static void load_review_data(struct ui_state *st) {
     st->review_loaded = 1;
 }
 
-static void load_rules(struct ui_state *st) {
+static void reset_rule_arrays(struct ui_state *st) {
     ruleset_free(&st->rules);
     free(st->rule_status);
     st->rule_status = NULL;
@@ -448,21 +863,101 @@ static void load_rules(struct ui_state *st) {
     st->rule_modified = NULL;
     free(st->file_order);
     st->file_order = NULL;
+    free(st->rule_marked);
+    st->rule_marked = NULL;
+    st->marked_count = 0;
+    st->mark_anchor = -1;
     st->review_loaded = 0;
+}
+
+/* take rule status from the session instead of recomputing it; rules must
+ * still be in file order. The duplicate flags hold while the rules hash
+ * matches, the unused flags only while the same windows are open. */
+static int restore_rule_status(struct ui_state *st) {
+    struct session *s = &st->session;
+    size_t n = st->rules.count;
+    int ok = s->status && s->status_count == n && n > 0 &&
+             strcmp(s->rules_path, st->rules_path) == 0 &&
+             s->rules_hash == session_rules_hash(&st->rules, NULL);
+    if (!ok) {
+        session_free(s);
+        return -1;
+    }
+    free(st->rule_status);
+    st->rule_status = calloc(n, sizeof(enum rule_status));
+    if (!st->rule_status) {
+        session_free(s);
+        return -1;
+    }
+    st->status_gen++;
+
+    load_clients(st);
+    st->status_clients_gen = st->clients_gen;
+    int same_windows = s->clients_hash && s->clients_hash == session_clients_hash(&st->clients);
+    int async = !same_windows && n * st->clients.count >= STATUS_SCAN_ASYNC_MIN;
+
+    for (size_t i = 0; i < n; i++) {
+        struct rule *r = &st->rules.rules[i];
+        update_display_name(r);
+        if (s->status[i] == SESSION_DUPLICATE)
+            st->rule_status[i] = RULE_DUPLICATE;
+        else if (same_windows)
+            st->rule_status[i] = s->status[i] == SESSION_UNUSED ? RULE_UNUSED : RULE_OK;
+        else if (st->clients.count > 0 && !async && !rule_matches_any_client(r, &st->clients))
+            st->rule_status[i] = RULE_UNUSED;
+    }
+    st->scan.wanted = async;
+    session_free(s);
+    return 0;
+}
+
+/* take ownership of rs as the in-memory rules; modified may be NULL or
+ * hold one flag per rule in rs order */
+static void adopt_rules(struct ui_state *st, struct ruleset *rs, int *modified) {
+    reset_rule_arrays(st);
+    st->rules = *rs;
+    rs->rules = NULL;
+    rs->count = 0;
+
+    /* record original file order before sorting */
+    st->file_order = malloc(st->rules.count * sizeof(int));
+    if (st->file_order) {
+        for (size_t i = 0; i < st->rules.count; i++)
+            st->file_order[i] = (int)i;
+    }
+    st->rule_modified = modified ? modified : calloc(st->rules.count ? st->rules.count : 1, sizeof(int));
+    st->rule_marked = calloc(st->rules.count ? st->rules.count : 1, 1);
+    if (restore_rule_status(st) != 0)
+        compute_rule_status(st);
+    apply_sort(st);
+}
+
+/* remember what the rules file looks like now, for merge_with_disk */
+static void snapshot_base(struct ui_state *st, const struct ruleset *rs) {
+    merge_base_free(&st->base);
+    merge_base_init(&st->base, rs);
+
+    char *path = expand_home(st->rules_path);
+    struct stat sb;
+    if (stat(path ? path : st->rules_path, &sb) == 0) {
+        st->base_mtime = sb.st_mtim;
+        st->base_size = sb.st_size;
+    }
+    free(path);
+}
+
+static void load_rules(struct ui_state *st) {
+    status_scan_stop(st);
+    reset_rule_arrays(st);
     clients_free(&st->clients);
     st->clients_loaded = 0;
+    st->clients_gen++;
 
     char *path = expand_home(st->rules_path);
-    if (ruleset_load(path ? path : st->rules_path, &st->rules) == 0) {
-        /* record original file order before sorting */
-        st->file_order = malloc(st->rules.count * sizeof(int));
-        if (st->file_order) {
-            for (size_t i = 0; i < st->rules.count; i++)
-                st->file_order[i] = (int)i;
-        }
-        compute_rule_status(st);
-        apply_sort(st);
-        st->rule_modified = calloc(st->rules.count, sizeof(int));
+    struct ruleset rs = {0};
+    if (ruleset_load(path ? path : st->rules_path, &rs) == 0) {
+        snapshot_base(st, &rs);
+        adopt_rules(st, &rs, NULL);
         set_status(st, "Loaded %zu rules from %s", st->rules.count, st->rules_path);
     } else {
         set_status(st, "Failed to load rules from %s", st->rules_path);
@@ -472,6 +967,23 @@ static void load_rules(struct ui_state *st) {
 
 /* --- drawing helpers --- */
 
+/* list columns cached per rule (rule_cache.cells) and per window */
+enum { CELL_NAME, CELL_TAG, CELL_WS };
+enum { WCELL_CLASS, WCELL_TITLE, WCELL_WS, WCELL_COUNT };
+
+/* s cut and padded to cols terminal columns; the cell keeps the result
+ * for the next frame. Without one, the cut is made for this draw only. */
+static void put_cell(struct ncplane *n, int y, int x, struct text_cell *c,
+                     const char *s, int cols) {
+    if (c) {
+        ncplane_putstr_yx(n, y, x, text_cell_get(c, s, cols));
+        return;
+    }
+    struct text_cell tmp = {0};
+    ncplane_putstr_yx(n, y, x, text_cell_get(&tmp, s, cols));
+    text_cell_reset(&tmp);
+}
+
 static void ui_fill_row(struct ncplane *n, int y, int x, int w, char ch) {
     for (int i = 0; i < w; i++) {
         ncplane_putchar_yx(n, y, x + i, ch);
@@ -649,25 +1161,30 @@ static void clean_class_name(const char *regex, char *out, size_t out_sz) {
     }
 }
 
+/* derive RF_DISPLAY_NAME from class, title or name; a no-op until one changes */
 static void update_display_name(struct rule *r) {
+    struct rule_cache *c = rule_cache(r);
+    if (c && c->display_done) return;
+
     char buf[64] = "";
 
-    clean_class_name(r->match.class_re, buf, sizeof(buf));
+    clean_class_name(rule_get(r, RF_CLASS), buf, sizeof(buf));
 
     if (!buf[0]) {
-        clean_class_name(r->match.title_re, buf, sizeof(buf));
+        clean_class_name(rule_get(r, RF_TITLE), buf, sizeof(buf));
     }
 
-    if (!buf[0] && r->name) {
-        snprintf(buf, sizeof(buf), "%s", r->name);
+    if (!buf[0] && rule_get(r, RF_NAME)) {
+        snprintf(buf, sizeof(buf), "%s", rule_get(r, RF_NAME));
     }
 
     if (!buf[0]) {
         snprintf(buf, sizeof(buf), "(unnamed)");
     }
 
-    free(r->display_name);
-    r->display_name = strdup(buf);
+    const char *cur = rule_get(r, RF_DISPLAY_NAME);
+    if (!cur || strcmp(cur, buf) != 0) rule_set(r, RF_DISPLAY_NAME, buf);
+    if ((c = rule_cache(r))) c->display_done = 1;
 }
 
 static const char *clean_tag(const char *tag) {
@@ -676,11 +1193,333 @@ static const char *clean_tag(const char *tag) {
     return tag;
 }
 
+/* --- rules tree --- */
+
+static const char *tree_key_label(enum tree_key k) {
+    switch (k) {
+    case TREE_TAG:       return "Tag";
+    case TREE_WORKSPACE: return "Workspace";
+    default:             return "Off";
+    }
+}
+
+static const char *tree_key_of(enum tree_key k, const struct rule *r) {
+    if (k == TREE_WORKSPACE) return rule_get_or(r, RF_WORKSPACE, "");
+    const char *tag = rule_get(r, RF_TAG);
+    return tag ? clean_tag(tag) : "";
+}
+
+static unsigned char tree_bits_of(const struct ui_state *st, size_t i) {
+    unsigned char bits = 0;
+    if (st->rule_status && st->rule_status[i] == RULE_UNUSED) bits |= TREE_B_UNUSED;
+    if (st->rule_status && st->rule_status[i] == RULE_DUPLICATE) bits |= TREE_B_DUP;
+    if (st->rule_modified && st->rule_modified[i]) bits |= TREE_B_MOD;
+    return bits;
+}
+
+static void rule_tree_free(struct rule_tree *t) {
+    for (int g = 0; g < t->group_count; g++) free(t->groups[g].key);
+    free(t->groups);
+    free(t->sorted);
+    free(t->table);
+    free(t->slots);
+    free(t->rows);
+    free(t->row_of);
+    enum tree_key key = t->key;
+    memset(t, 0, sizeof(*t));
+    t->key = key;
+    t->header = -1;
+}
+
+static size_t tree_hash(const char *s) {
+    size_t h = 5381;
+    while (*s) h = h * 33 + (unsigned char)*s++;
+    return h;
+}
+
+/* group index for key, created on first sight; -1 on allocation failure */
+static int tree_group_for(struct rule_tree *t, const char *key) {
+    size_t k = tree_hash(key) & t->table_mask;
+    for (; t->table[k]; k = (k + 1) & t->table_mask)
+        if (strcmp(t->groups[t->table[k] - 1].key, key) == 0) return t->table[k] - 1;
+
+    if (t->group_count == t->group_cap) {
+        int cap = t->group_cap ? t->group_cap * 2 : 16;
+        struct rule_group *g = realloc(t->groups, (size_t)cap * sizeof(*g));
+        if (!g) return -1;
+        t->groups = g;
+        int *so = realloc(t->sorted, (size_t)cap * sizeof(int));
+        if (!so) return -1;
+        t->sorted = so;
+        t->group_cap = cap;
+    }
+    /* keep the table at most half full */
+    if ((size_t)(t->group_count + 1) * 2 > t->table_mask + 1) {
+        size_t mask = t->table_mask * 2 + 1;
+        int *tab = calloc(mask + 1, sizeof(int));
+        if (!tab) return -1;
+        for (int g = 0; g < t->group_count; g++) {
+            size_t j = tree_hash(t->groups[g].key) & mask;
+            while (tab[j]) j = (j + 1) & mask;
+            tab[j] = g + 1;
+        }
+        free(t->table);
+        t->table = tab;
+        t->table_mask = mask;
+        k = tree_hash(key) & mask;
+        while (tab[k]) k = (k + 1) & mask;
+    }
+
+    struct rule_group *g = &t->groups[t->group_count];
+    memset(g, 0, sizeof(*g));
+    if (!(g->key = strdup(key))) return -1;
+    g->row = -1;
+    t->table[k] = ++t->group_count;
+    t->sorted_ok = 0;
+    return t->group_count - 1;
+}
+
+static void tree_account(struct rule_tree *t, int g, unsigned char bits, int sign) {
+    struct rule_group *gr = &t->groups[g];
+    gr->count += sign;
+    if (bits & TREE_B_UNUSED) gr->unused += sign;
+    if (bits & TREE_B_DUP) gr->dups += sign;
+    if (bits & TREE_B_MOD) gr->modified += sign;
+}
+
+/* move rule i's contribution to where it belongs now; returns 1 when it
+ * changed group, 0 when it stayed, -1 on allocation failure */
+static int tree_sync_rule(struct ui_state *st, size_t i, int fresh) {
+    struct rule_tree *t = &st->tree;
+    struct tree_slot *s = &t->slots[i];
+    const char *key = tree_key_of(t->key, &st->rules.rules[i]);
+    unsigned char bits = tree_bits_of(st, i);
+
+    if (!fresh && strcmp(t->groups[s->group].key, key) == 0) {
+        if (bits != s->bits) {
+            tree_account(t, s->group, s->bits, -1);
+            tree_account(t, s->group, bits, 1);
+            s->bits = bits;
+        }
+        return 0;
+    }
+    int g = tree_group_for(t, key);
+    if (g < 0) return -1;
+    if (!fresh) tree_account(t, s->group, s->bits, -1);
+    s->group = g;
+    s->bits = bits;
+    tree_account(t, g, bits, 1);
+    return 1;
+}
+
+static int compare_group_key(const void *a, const void *b) {
+    const char *ka = sort_ctx->tree.groups[*(const int *)a].key;
+    const char *kb = sort_ctx->tree.groups[*(const int *)b].key;
+    if (!ka[0] || !kb[0]) return !ka[0] - !kb[0]; /* ungrouped last */
+    return strcasecmp(ka, kb);
+}
+
+static int tree_build_rows(struct ui_state *st) {
+    struct rule_tree *t = &st->tree;
+    size_t n = st->rules.count;
+    int gc = t->group_count;
+
+    if (!t->sorted_ok) {
+        for (int g = 0; g < gc; g++) t->sorted[g] = g;
+        sort_ctx = st;
+        qsort(t->sorted, (size_t)gc, sizeof(int), compare_group_key);
+        sort_ctx = NULL;
+        t->sorted_ok = 1;
+    }
+
+    /* bucket rule indices by group, keeping rules order inside each */
+    int *start = calloc((size_t)gc + 1, sizeof(int));
+    int *members = malloc((n ? n : 1) * sizeof(int));
+    int *rows = realloc(t->rows, (n + (size_t)gc + 1) * sizeof(int));
+    if (rows) t->rows = rows;
+    if (!start || !members || !rows) {
+        free(start);
+        free(members);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) start[t->slots[i].group + 1]++;
+    for (int g = 0; g < gc; g++) start[g + 1] += start[g];
+    for (size_t i = 0; i < n; i++) members[start[t->slots[i].group]++] = (int)i;
+    /* start[g] now marks the end of group g */
+
+    for (size_t i = 0; i < n; i++) t->row_of[i] = -1;
+    int r = 0;
+    for (int k = 0; k < gc; k++) {
+        int g = t->sorted[k];
+        struct rule_group *gr = &t->groups[g];
+        gr->row = -1;
+        if (gr->count == 0) continue;
+        gr->row = r;
+        t->rows[r++] = -1 - g;
+        if (gr->collapsed) continue;
+        for (int m = start[g] - gr->count; m < start[g]; m++) {
+            t->row_of[members[m]] = r;
+            t->rows[r++] = members[m];
+        }
+    }
+    t->row_count = r;
+    t->rows_ok = 1;
+    free(start);
+    free(members);
+    return 0;
+}
+
+/* bring the tree up to date; NULL when the view is flat or out of memory */
+static const struct rule_tree *rule_tree_get(struct ui_state *st) {
+    struct rule_tree *t = &st->tree;
+    if (t->key == TREE_OFF || t->failed) return NULL;
+    size_t n = st->rules.count;
+
+    if (!t->built) {
+        rule_tree_free(t);
+        t->table_mask = 31;
+        if (!(t->table = calloc(t->table_mask + 1, sizeof(int)))) goto fail;
+    }
+    if (!t->built || t->gen != st->status_gen) {
+        if (n > t->slot_cap) {
+            size_t cap = t->slot_cap ? t->slot_cap : 64;
+            while (cap < n) cap *= 2;
+            struct tree_slot *sl = realloc(t->slots, cap * sizeof(*sl));
+            if (!sl) goto fail;
+            t->slots = sl;
+            int *ro = realloc(t->row_of, cap * sizeof(int));
+            if (!ro) goto fail;
+            t->row_of = ro;
+            t->slot_cap = cap;
+        }
+        /* slots past the new end belonged to rules that are gone */
+        size_t old = t->built ? t->slot_count : 0;
+        for (size_t i = n; i < old; i++)
+            tree_account(t, t->slots[i].group, t->slots[i].bits, -1);
+        for (size_t i = 0; i < n; i++)
+            if (tree_sync_rule(st, i, i >= old) < 0) goto fail;
+        t->slot_count = n;
+        t->gen = st->status_gen;
+        t->built = 1;
+        t->rows_ok = 0; /* indices may have moved */
+    }
+    if (!t->rows_ok && tree_build_rows(st) != 0) goto fail;
+    return t;
+
+fail:
+    rule_tree_free(t);
+    t->failed = 1;
+    set_status(st, "Out of memory building the rule tree");
+    return NULL;
+}
+
+static void rule_tree_touch(struct ui_state *st, size_t i) {
+    struct rule_tree *t = &st->tree;
+    if (!t->built || t->gen != st->status_gen || i >= t->slot_count) return;
+    int moved = tree_sync_rule(st, i, 0);
+    if (moved < 0) {
+        t->built = 0;
+        return;
+    }
+    if (moved) t->rows_ok = 0;
+}
+
+/* group whose header is under the cursor, or -1 */
+static int rule_tree_header(const struct ui_state *st) {
+    const struct rule_tree *t = &st->tree;
+    if (t->key == TREE_OFF || !t->built || t->header < 0 || t->header >= t->group_count) return -1;
+    /* any handler that moved st->selected put the cursor back on a rule */
+    if (t->header_anchor != st->selected || t->groups[t->header].row < 0) return -1;
+    return t->header;
+}
+
+/* display row under the cursor; unfolds the group of a rule that was
+ * selected from elsewhere (search, undo) while folded */
+static int rule_tree_cursor(struct ui_state *st) {
+    const struct rule_tree *t = rule_tree_get(st);
+    if (!t || t->row_count == 0) return 0;
+    int g = rule_tree_header(st);
+    if (g >= 0) return t->groups[g].row;
+    if (st->selected < 0 || st->selected >= (int)t->slot_count) return 0;
+    if (t->row_of[st->selected] < 0) {
+        st->tree.groups[t->slots[st->selected].group].collapsed = 0;
+        st->tree.rows_ok = 0;
+        if (!(t = rule_tree_get(st))) return 0;
+    }
+    return t->row_of[st->selected] >= 0 ? t->row_of[st->selected] : 0;
+}
+
+static void rule_tree_set_cursor(struct ui_state *st, int row) {
+    const struct rule_tree *t = rule_tree_get(st);
+    if (!t || t->row_count == 0) return;
+    if (row < 0) row = 0;
+    if (row >= t->row_count) row = t->row_count - 1;
+    int v = t->rows[row];
+    if (v >= 0) {
+        st->tree.header = -1;
+        st->selected = v;
+    } else {
+        st->tree.header = -1 - v;
+        st->tree.header_anchor = st->selected;
+    }
+}
+
+static void rule_tree_fold(struct ui_state *st, int g, int collapsed) {
+    struct rule_tree *t = &st->tree;
+    if (g < 0 || g >= t->group_count || t->groups[g].collapsed == collapsed) return;
+    t->groups[g].collapsed = collapsed;
+    t->rows_ok = 0;
+    /* keep the cursor on the header it was folded from */
+    t->header = g;
+    t->header_anchor = st->selected;
+}
+
 /* --- view drawing --- */
 
+static void draw_group_header(struct ncplane *n, const struct rule_group *g, enum tree_key key,
+                              int row, int w, int sel) {
+    if (sel) {
+        ui_set_color(n, COL_SELECT);
+        ui_fill_row(n, row, 1, w - 2, ' ');
+    } else {
+        ui_set_color(n, COL_TITLE);
+    }
+    int cx = 2;
+    ncplane_putstr_yx(n, row, cx, g->collapsed ? "\u25b8 " : "\u25be "); cx += 2;
+    char label[96];
+    int len = snprintf(label, sizeof(label), "%s (%d)",
+                       g->key[0] ? g->key : key == TREE_WORKSPACE ? "(no workspace)" : "(untagged)",
+                       g->count);
+    ncplane_on_styles(n, NCSTYLE_BOLD);
+    ncplane_printf_yx(n, row, cx, "%.*s", w - cx - 2, label);
+    ncplane_off_styles(n, NCSTYLE_BOLD);
+    cx += len + 2;
+
+    /* aggregates, only the ones that are non-zero */
+    const struct { int v; const char *what; int color; } aggs[] = {
+        {g->unused, "unused", COL_WARN},
+        {g->dups, "dup", COL_ERROR},
+        {g->modified, "modified", COL_ACCENT},
+    };
+    for (size_t a = 0; a < sizeof(aggs) / sizeof(aggs[0]); a++) {
+        if (aggs[a].v == 0) continue;
+        char buf[32];
+        int bl = snprintf(buf, sizeof(buf), "%d %s", aggs[a].v, aggs[a].what);
+        if (cx + bl > w - 2) break;
+        if (!sel) ui_set_color(n, aggs[a].color);
+        ncplane_putstr_yx(n, row, cx, buf);
+        cx += bl + 2;
+    }
+    ui_reset_color(n);
+}
+
 static void draw_rules_view(struct ncplane *n, struct ui_state *st, int y, int h, int w) {
-    char title[64];
-    snprintf(title, sizeof(title), "Window Rules [%s]", sort_mode_label(st->sort_mode));
+    char title[96];
+    int tl = snprintf(title, sizeof(title), "Window Rules [%s]", sort_mode_label(st->sort_mode));
+    if (st->tree.key != TREE_OFF)
+        tl += snprintf(title + tl, sizeof(title) - (size_t)tl, " [by %s]", tree_key_label(st->tree.key));
+    if (st->marked_count > 0)
+        snprintf(title + tl, sizeof(title) - (size_t)tl, " [%zu marked]", st->marked_count);
     draw_box(n, y, 0, h, w, title);
 
     if (st->rules.count == 0) {
@@ -690,13 +1529,19 @@ static void draw_rules_view(struct ncplane *n, struct ui_state *st, int y, int h
         return;
     }
 
+    /* in tree mode rows are group headers and the rules of open groups */
+    int cursor = st->tree.key != TREE_OFF ? rule_tree_cursor(st) : st->selected;
+    const struct rule_tree *tree = rule_tree_get(st);
+    int total = tree ? tree->row_count : (int)st->rules.count;
+    if (!tree) cursor = st->selected;
+
     int visible = h - 3;
-    int max_scroll = (int)st->rules.count > visible ? (int)st->rules.count - visible : 0;
+    int max_scroll = total > visible ? total - visible : 0;
     if (st->scroll > max_scroll) st->scroll = max_scroll;
     if (st->scroll < 0) st->scroll = 0;
 
-    if (st->selected < st->scroll) st->scroll = st->selected;
-    if (st->selected >= st->scroll + visible) st->scroll = st->selected - visible + 1;
+    if (cursor < st->scroll) st->scroll = cursor;
+    if (cursor >= st->scroll + visible) st->scroll = cursor - visible + 1;
 
     /* proportional column layout: name(30%) tag(20%) ws(10%) status(12%) opts(rest) */
     int usable = w - 4; /* 2 padding each side */
@@ -728,27 +1573,36 @@ static void draw_rules_view(struct ncplane *n, struct ui_state *st, int y, int h
 
     const char *last_tag = NULL;
 
-    for (int i = 0; i < visible && (st->scroll + i) < (int)st->rules.count; i++) {
-        int idx = st->scroll + i;
-        struct rule *r = &st->rules.rules[idx];
+    for (int i = 0; i < visible && (st->scroll + i) < total; i++) {
+        int di = st->scroll + i;
+        int idx = tree ? tree->rows[di] : di;
+        int sel = di == cursor;
         int row = y + 2 + i;
 
+        if (idx < 0) {
+            const struct rule_group *g = &tree->groups[-1 - idx];
+            draw_group_header(n, g, st->tree.key, row, w, sel);
+            last_tag = NULL;
+            continue;
+        }
+        struct rule *r = &st->rules.rules[idx];
+
         enum rule_status status = st->rule_status ? st->rule_status[idx] : RULE_OK;
 
-        const char *display = r->display_name ? r->display_name : "(unnamed)";
-        const char *tag = clean_tag(r->actions.tag);
-        const char *ws = r->actions.workspace ? r->actions.workspace : "-";
+        const char *display = rule_get_or(r, RF_DISPLAY_NAME, "(unnamed)");
+        const char *tag = clean_tag(rule_get(r, RF_TAG));
+        const char *ws = rule_get_or(r, RF_WORKSPACE, "-");
 
         /* build options string */
         char opts[32] = "";
         int opos = 0;
-        if (r->actions.float_set && r->actions.float_val)
+        if (rule_get_bool(r, RF_FLOAT))
             opos += snprintf(opts + opos, sizeof(opts) - (size_t)opos, "F ");
-        if (r->actions.center_set && r->actions.center_val)
+        if (rule_get_bool(r, RF_CENTER))
             opos += snprintf(opts + opos, sizeof(opts) - (size_t)opos, "C ");
-        if (r->actions.size)
+        if (rule_get(r, RF_SIZE))
             opos += snprintf(opts + opos, sizeof(opts) - (size_t)opos, "S ");
-        if (r->actions.opacity)
+        if (rule_get(r, RF_OPACITY))
             opos += snprintf(opts + opos, sizeof(opts) - (size_t)opos, "O ");
         if (r->extras_count > 0) {
             snprintf(opts + opos, sizeof(opts) - (size_t)opos, "+%zu", r->extras_count);
@@ -756,12 +1610,12 @@ static void draw_rules_view(struct ncplane *n, struct ui_state *st, int y, int h
         if (opts[0] == '\0') strcpy(opts, "-");
 
         int show_tag = 1;
-        if (last_tag && r->actions.tag && strcmp(last_tag, r->actions.tag) == 0) {
+        if (last_tag && rule_get(r, RF_TAG) && strcmp(last_tag, rule_get(r, RF_TAG)) == 0) {
             show_tag = 0;
         }
-        last_tag = r->actions.tag;
+        last_tag = rule_get(r, RF_TAG);
 
-        if (idx == st->selected) {
+        if (sel) {
             ui_set_color(n, COL_SELECT);
             ui_fill_row(n, row, 1, w - 2, ' ');
         }
@@ -769,31 +1623,45 @@ static void draw_rules_view(struct ncplane *n, struct ui_state *st, int y, int h
         /* modified indicator */
         int is_mod = (st->rule_modified && st->rule_modified[idx]);
         if (is_mod) {
-            if (idx != st->selected) ui_set_color(n, COL_WARN);
+            if (!sel) ui_set_color(n, COL_WARN);
             ncplane_putchar_yx(n, row, 1, '*');
-            if (idx == st->selected) ui_set_color(n, COL_SELECT);
+            if (sel) ui_set_color(n, COL_SELECT);
+            else ui_reset_color(n);
+        }
+
+        /* marked indicator (takes the modified column) */
+        if (st->rule_marked && st->rule_marked[idx]) {
+            if (!sel) ui_set_color(n, COL_ACCENT);
+            ncplane_putchar_yx(n, row, 1, '+');
+            if (sel) ui_set_color(n, COL_SELECT);
             else ui_reset_color(n);
         }
 
-        ncplane_printf_yx(n, row, col_name, "%-*.*s", col_name_w, col_name_w, display);
+        struct rule_cache *rc = rule_cache(r);
+        put_cell(n, row, col_name, rc ? &rc->cells[CELL_NAME] : NULL, display, col_name_w);
 
         if (show_tag && tag[0] != '-') {
             ncplane_on_styles(n, NCSTYLE_BOLD);
-            if (idx != st->selected) ui_set_color(n, COL_ACCENT);
-            ncplane_printf_yx(n, row, col_tag, "%-*.*s", col_tag_w, col_tag_w, tag);
+            if (!sel) ui_set_color(n, COL_ACCENT);
+            put_cell(n, row, col_tag, rc ? &rc->cells[CELL_TAG] : NULL, tag, col_tag_w);
             ncplane_off_styles(n, NCSTYLE_BOLD);
-            if (idx == st->selected) ui_set_color(n, COL_SELECT);
+            if (sel) ui_set_color(n, COL_SELECT);
             else ui_reset_color(n);
+        } else if (show_tag) {
+            put_cell(n, row, col_tag, rc ? &rc->cells[CELL_TAG] : NULL, tag, col_tag_w);
         } else {
-            ncplane_printf_yx(n, row, col_tag, "%-*.*s", col_tag_w, col_tag_w, show_tag ? tag : "");
+            ncplane_printf_yx(n, row, col_tag, "%*s", col_tag_w, "");
         }
 
-        if (idx == st->selected) ui_set_color(n, COL_SELECT);
-        ncplane_printf_yx(n, row, col_ws, "%-*.*s", col_ws_w, col_ws_w, ws);
+        if (sel) ui_set_color(n, COL_SELECT);
+        put_cell(n, row, col_ws, rc ? &rc->cells[CELL_WS] : NULL, ws, col_ws_w);
 
         const char *status_str;
         int status_color;
-        switch (status) {
+        if (r->flags & RULE_F_BROKEN) {
+            status_str = "error";
+            status_color = COL_ERROR;
+        } else switch (status) {
         case RULE_UNUSED:
             status_str = "unused";
             status_color = COL_WARN;
@@ -807,10 +1675,10 @@ static void draw_rules_view(struct ncplane *n, struct ui_state *st, int y, int h
             status_color = COL_DIM;
             break;
         }
-        if (idx != st->selected) ui_set_color(n, status_color);
+        if (!sel) ui_set_color(n, status_color);
         ncplane_printf_yx(n, row, col_stat, "%-*s", col_stat_w, status_str);
 
-        if (idx != st->selected) ui_set_color(n, COL_DIM);
+        if (!sel) ui_set_color(n, COL_DIM);
         ncplane_printf_yx(n, row, col_opts, "%.*s", col_opts_w, opts);
 
         ui_reset_color(n);
@@ -818,10 +1686,84 @@ static void draw_rules_view(struct ncplane *n, struct ui_state *st, int y, int h
 
     /* scrollbar */
     if (max_scroll > 0)
-        draw_scrollbar(n, y + 2, w - 1, visible, (int)st->rules.count, st->scroll);
+        draw_scrollbar(n, y + 2, w - 1, visible, total, st->scroll);
+}
+
+/* does a configerrors path name the rules file? */
+static int same_file(const char *a, const char *b) {
+    char ra[PATH_MAX], rb[PATH_MAX];
+    if (realpath(a, ra) && realpath(b, rb)) return strcmp(ra, rb) == 0;
+    return strcmp(a, b) == 0;
+}
+
+/* does a reported error carry a line in the rules file? */
+static int config_error_in_rules(const struct config_error *ce, const char *rules_path) {
+    return ce->file && ce->line > 0 && same_file(ce->file, rules_path);
+}
+
+/* first reported error inside a rule's span, or NULL */
+static const struct config_error *rule_config_error(const struct ui_state *st, const struct rule *r) {
+    if (!(r->flags & RULE_F_BROKEN)) return NULL;
+    char *expanded = expand_home(st->rules_path);
+    const char *path = expanded ? expanded : st->rules_path;
+    const struct config_error *found = NULL;
+    for (size_t e = 0; e < st->cfg_errors.count && !found; e++) {
+        const struct config_error *ce = &st->cfg_errors.items[e];
+        if (config_error_in_rules(ce, path) &&
+            (uint32_t)ce->line >= r->src_line && (uint32_t)ce->line <= r->src_end)
+            found = ce;
+    }
+    free(expanded);
+    return found;
+}
+
+/* window-state conditions of a rule ("xwayland, not floating, workspace 3") */
+static void rule_state_str(const struct rule *r, char *buf, size_t sz) {
+    static const struct { enum rule_field f; const char *what; } flags[] = {
+        {RF_MATCH_XWAYLAND, "xwayland"}, {RF_MATCH_FLOAT, "floating"},
+        {RF_MATCH_FULLSCREEN, "fullscreen"}, {RF_MATCH_PIN, "pinned"},
+    };
+    size_t len = 0;
+    buf[0] = '\0';
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]) && len < sz; i++) {
+        if (!rule_has(r, flags[i].f)) continue;
+        len += (size_t)snprintf(buf + len, sz - len, "%s%s%s", len ? ", " : "",
+                                rule_get_bool(r, flags[i].f) ? "" : "not ", flags[i].what);
+    }
+    if (rule_has(r, RF_MATCH_WORKSPACE) && len < sz)
+        snprintf(buf + len, sz - len, "%sworkspace %s", len ? ", " : "", rule_get(r, RF_MATCH_WORKSPACE));
+}
+
+static void draw_group_detail(struct ncplane *n, struct ui_state *st, int g, int y, int x, int h, int w) {
+    const struct rule_group *gr = &st->tree.groups[g];
+    draw_box(n, y, x, h, w, "Group Details");
+    int row = y + 2;
+    int col = x + 3;
+
+    ncplane_on_styles(n, NCSTYLE_BOLD);
+    ui_set_color(n, COL_ACCENT);
+    ncplane_printf_yx(n, row++, col, "%.*s", w - 6,
+                      gr->key[0] ? gr->key : st->tree.key == TREE_WORKSPACE ? "(no workspace)" : "(untagged)");
+    ncplane_off_styles(n, NCSTYLE_BOLD);
+    ui_reset_color(n);
+    row++;
+
+    ncplane_printf_yx(n, row++, col + 2, "Rules:     %d", gr->count);
+    ncplane_printf_yx(n, row++, col + 2, "Unused:    %d", gr->unused);
+    ncplane_printf_yx(n, row++, col + 2, "Duplicate: %d", gr->dups);
+    ncplane_printf_yx(n, row++, col + 2, "Modified:  %d", gr->modified);
+
+    ui_set_color(n, COL_DIM);
+    ncplane_printf_yx(n, y + h - 2, col, "Enter:%s  Left/Right:Fold", gr->collapsed ? "Expand" : "Collapse");
+    ui_reset_color(n);
 }
 
 static void draw_rule_detail(struct ncplane *n, struct ui_state *st, int y, int x, int h, int w) {
+    int g = rule_tree_header(st);
+    if (g >= 0) {
+        draw_group_detail(n, st, g, y, x, h, w);
+        return;
+    }
     draw_box(n, y, x, h, w, "Rule Details");
 
     if (st->selected < 0 || st->selected >= (int)st->rules.count) {
@@ -835,7 +1777,7 @@ static void draw_rule_detail(struct ncplane *n, struct ui_state *st, int y, int
     int row = y + 2;
     int col = x + 3;
 
-    const char *display = r->display_name ? r->display_name : "(unnamed)";
+    const char *display = rule_get_or(r, RF_DISPLAY_NAME, "(unnamed)");
 
     ncplane_on_styles(n, NCSTYLE_BOLD);
     ui_set_color(n, COL_ACCENT);
@@ -849,10 +1791,15 @@ static void draw_rule_detail(struct ncplane *n, struct ui_state *st, int y, int
     ncplane_printf_yx(n, row++, col, "Matching");
     ui_reset_color(n);
 
-    if (r->match.class_re)
-        ncplane_printf_yx(n, row++, col + 2, "Class:  %.*s", w - 12, r->match.class_re);
-    if (r->match.title_re)
-        ncplane_printf_yx(n, row++, col + 2, "Title:  %.*s", w - 12, r->match.title_re);
+    if (rule_get(r, RF_CLASS))
+        ncplane_printf_yx(n, row++, col + 2, "Class:  %.*s", w - 12, rule_get(r, RF_CLASS));
+    if (rule_get(r, RF_TITLE))
+        ncplane_printf_yx(n, row++, col + 2, "Title:  %.*s", w - 12, rule_get(r, RF_TITLE));
+    if (r->present & RF_STATE_MASK) {
+        char state[128];
+        rule_state_str(r, state, sizeof(state));
+        ncplane_printf_yx(n, row++, col + 2, "State:  %.*s", w - 12, state);
+    }
 
     row++;
 
@@ -860,20 +1807,20 @@ static void draw_rule_detail(struct ncplane *n, struct ui_state *st, int y, int
     ncplane_printf_yx(n, row++, col, "Actions");
     ui_reset_color(n);
 
-    if (r->actions.tag)
-        ncplane_printf_yx(n, row++, col + 2, "Tag:       %s", clean_tag(r->actions.tag));
-    if (r->actions.workspace)
-        ncplane_printf_yx(n, row++, col + 2, "Workspace: %s", r->actions.workspace);
-    if (r->actions.float_set)
-        ncplane_printf_yx(n, row++, col + 2, "Float:     %s", r->actions.float_val ? "Yes" : "No");
-    if (r->actions.center_set)
-        ncplane_printf_yx(n, row++, col + 2, "Center:    %s", r->actions.center_val ? "Yes" : "No");
-    if (r->actions.size)
-        ncplane_printf_yx(n, row++, col + 2, "Size:      %s", r->actions.size);
-    if (r->actions.move)
-        ncplane_printf_yx(n, row++, col + 2, "Position:  %s", r->actions.move);
-    if (r->actions.opacity)
-        ncplane_printf_yx(n, row++, col + 2, "Opacity:   %s", r->actions.opacity);
+    if (rule_get(r, RF_TAG))
+        ncplane_printf_yx(n, row++, col + 2, "Tag:       %s", clean_tag(rule_get(r, RF_TAG)));
+    if (rule_get(r, RF_WORKSPACE))
+        ncplane_printf_yx(n, row++, col + 2, "Workspace: %s", rule_get(r, RF_WORKSPACE));
+    if (rule_has(r, RF_FLOAT))
+        ncplane_printf_yx(n, row++, col + 2, "Float:     %s", rule_get_bool(r, RF_FLOAT) ? "Yes" : "No");
+    if (rule_has(r, RF_CENTER))
+        ncplane_printf_yx(n, row++, col + 2, "Center:    %s", rule_get_bool(r, RF_CENTER) ? "Yes" : "No");
+    if (rule_get(r, RF_SIZE))
+        ncplane_printf_yx(n, row++, col + 2, "Size:      %s", rule_get(r, RF_SIZE));
+    if (rule_get(r, RF_MOVE))
+        ncplane_printf_yx(n, row++, col + 2, "Position:  %s", rule_get(r, RF_MOVE));
+    if (rule_get(r, RF_OPACITY))
+        ncplane_printf_yx(n, row++, col + 2, "Opacity:   %s", rule_get(r, RF_OPACITY));
 
     if (r->extras_count > 0) {
         row++;
@@ -887,29 +1834,447 @@ static void draw_rule_detail(struct ncplane *n, struct ui_state *st, int y, int
         }
     }
 
+    const struct config_error *ce = rule_config_error(st, r);
+    if (ce && row < y + h - 4) {
+        row++;
+        ui_set_color(n, COL_ERROR);
+        ncplane_printf_yx(n, row++, col, "Config error (line %d)", ce->line);
+        ncplane_printf_yx(n, row++, col + 2, "%.*s", w - 8, ce->message);
+        ui_reset_color(n);
+    }
+
     ui_set_color(n, COL_DIM);
     ncplane_printf_yx(n, y + h - 2, col, "Press Enter to edit");
     ui_reset_color(n);
 }
 
-static void draw_windows_view(struct ncplane *n, struct ui_state *st, int y, int h, int w) {
-    draw_box(n, y, 0, h, w, "Active Windows");
+/* match programs for the current rules; NULL if they could not be built */
+static const struct match_set *ui_matchers(struct ui_state *st) {
+    struct match_set *ms = &st->matchers;
+    if (ms->progs && st->matchers_gen == st->status_gen && ms->count == st->rules.count)
+        return ms;
+    match_set_free(ms);
+    if (match_set_build(ms, &st->rules) != 0) return NULL;
+    st->matchers_gen = st->status_gen;
+    return ms;
+}
+
+/* rule i was edited in place: recompile its program and move the window
+ * match counts by the difference, instead of rebuilding either */
+static void matchers_rule_changed(struct ui_state *st, size_t i) {
+    struct match_set *ms = &st->matchers;
+    if (!ms->progs || st->matchers_gen != st->status_gen || ms->count != st->rules.count ||
+        i >= ms->count) {
+        st->windex.counts_ok = 0; /* recounted once the programs are rebuilt */
+        return;
+    }
+
+    struct window_index *wi = &st->windex;
+    int counts = wi->counts_ok && wi->counts_gen == st->status_gen &&
+                 wi->clients_gen == st->clients_gen;
+    for (size_t c = 0; counts && c < st->clients.count; c++)
+        wi->matches[c] -= match_eval(&ms->progs[i], &st->clients.items[c]);
+
+    match_free(&ms->progs[i]);
+    if (match_compile(&ms->progs[i], &st->rules.rules[i]) != 0) {
+        match_set_free(ms);
+        wi->counts_ok = 0;
+        return;
+    }
+    for (size_t c = 0; counts && c < st->clients.count; c++)
+        wi->matches[c] += match_eval(&ms->progs[i], &st->clients.items[c]);
+    if (counts && st->win_sort == WSORT_MATCHES) wi->order_ok = 0;
+    if (!counts) wi->counts_ok = 0;
+}
+
+/* --- windows view model --- */
+
+static const char *const win_sort_names[WSORT_COUNT] = {
+    "hyprctl", "class", "title", "workspace", "matches",
+};
+
+static void window_cells_clear(struct window_index *wi) {
+    for (size_t i = 0; i < wi->cells_count * WCELL_COUNT; i++)
+        text_cell_reset(&wi->cells[i]);
+    wi->cells_count = 0;
+}
+
+/* the cached columns of one window, dropped whenever the list is replaced
+ * (window_index_remap keeps those of unchanged windows) */
+static struct text_cell *window_cells(struct ui_state *st, int client) {
+    struct window_index *wi = &st->windex;
+    size_t n = st->clients.count;
+    if (!wi->cells || wi->cells_gen != st->clients_gen || wi->cells_count != n) {
+        window_cells_clear(wi);
+        struct text_cell *c = realloc(wi->cells, (n ? n : 1) * WCELL_COUNT * sizeof(*c));
+        if (!c) return NULL;
+        memset(c, 0, (n ? n : 1) * WCELL_COUNT * sizeof(*c));
+        wi->cells = c;
+        wi->cells_count = n;
+        wi->cells_gen = st->clients_gen;
+    }
+    return &wi->cells[(size_t)client * WCELL_COUNT];
+}
+
+static void window_index_free(struct window_index *wi) {
+    window_cells_clear(wi);
+    free(wi->cells);
+    free(wi->matches);
+    free(wi->order);
+    free(wi->shown);
+    free(wi->rows);
+    free(wi->groups);
+    memset(wi, 0, sizeof(*wi));
+}
+
+static int window_index_reserve(struct window_index *wi, size_t n) {
+    if (n <= wi->cap && wi->cap) return 0;
+    size_t cap = wi->cap ? wi->cap : 64;
+    while (cap < n) cap *= 2;
+    int *tmp;
+    if (!(tmp = realloc(wi->matches, cap * sizeof(int)))) return -1;
+    wi->matches = tmp;
+    if (!(tmp = realloc(wi->order, cap * sizeof(int)))) return -1;
+    wi->order = tmp;
+    if (!(tmp = realloc(wi->shown, cap * sizeof(int)))) return -1;
+    wi->shown = tmp;
+    /* worst case every window sits under its own header */
+    if (!(tmp = realloc(wi->rows, 2 * cap * sizeof(int)))) return -1;
+    wi->rows = tmp;
+    struct win_group *g = realloc(wi->groups, cap * sizeof(*g));
+    if (!g) return -1;
+    wi->groups = g;
+    wi->cap = cap;
+    return 0;
+}
+
+static int compare_client_ws(const struct client *a, const struct client *b) {
+    return (a->workspace_id > b->workspace_id) - (a->workspace_id < b->workspace_id);
+}
+
+static int compare_client_idx(const void *a, const void *b) {
+    int ia = *(const int *)a, ib = *(const int *)b;
+    const struct client *ca = &sort_ctx->clients.items[ia];
+    const struct client *cb = &sort_ctx->clients.items[ib];
+    int d = sort_ctx->win_group ? compare_client_ws(ca, cb) : 0;
+    if (d == 0) {
+        switch (sort_ctx->win_sort) {
+        case WSORT_CLASS:
+            d = strcasecmp(ca->class_name ? ca->class_name : "",
+                           cb->class_name ? cb->class_name : "");
+            break;
+        case WSORT_TITLE:
+            d = strcasecmp(ca->title ? ca->title : "", cb->title ? cb->title : "");
+            break;
+        case WSORT_WORKSPACE:
+            d = compare_client_ws(ca, cb);
+            break;
+        case WSORT_MATCHES:
+            d = sort_ctx->windex.matches[ib] - sort_ctx->windex.matches[ia];
+            break;
+        case WSORT_HYPRLAND:
+            break;
+        }
+    }
+    return d ? d : (ia > ib) - (ia < ib);
+}
+
+static int client_passes_filter(const struct client *c, const char *q) {
+    if (!q[0]) return 1;
+    const char *fields[] = {c->class_name, c->title, c->initial_class, c->workspace_name};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        if (fields[i] && strcasestr(fields[i], q)) return 1;
+    return 0;
+}
+
+static int win_is_collapsed(const struct ui_state *st, int ws_id) {
+    for (int i = 0; i < st->win_collapsed_count; i++)
+        if (st->win_collapsed[i] == ws_id) return 1;
+    return 0;
+}
+
+static void win_toggle_collapsed(struct ui_state *st, int ws_id) {
+    for (int i = 0; i < st->win_collapsed_count; i++) {
+        if (st->win_collapsed[i] == ws_id) {
+            st->win_collapsed[i] = st->win_collapsed[--st->win_collapsed_count];
+            st->windex.rows_ok = 0;
+            return;
+        }
+    }
+    int *tmp = realloc(st->win_collapsed, (size_t)(st->win_collapsed_count + 1) * sizeof(int));
+    if (!tmp) return;
+    st->win_collapsed = tmp;
+    st->win_collapsed[st->win_collapsed_count++] = ws_id;
+    st->windex.rows_ok = 0;
+}
+
+/* bring the windows model up to date, redoing only the stale layers */
+static const struct window_index *window_index_get(struct ui_state *st) {
+    struct window_index *wi = &st->windex;
+    size_t n = st->clients.count;
+    if (window_index_reserve(wi, n) != 0) {
+        wi->counts_ok = wi->order_ok = wi->shown_ok = wi->rows_ok = 0;
+        wi->shown_count = wi->row_count = wi->group_count = 0;
+        return wi;
+    }
+
+    int clients_moved = !wi->counts_ok || wi->clients_gen != st->clients_gen;
+    if (clients_moved || wi->counts_gen != st->status_gen) {
+        const struct match_set *ms = ui_matchers(st);
+        for (size_t i = 0; i < n; i++) {
+            const struct client *c = &st->clients.items[i];
+            int count = 0;
+            for (size_t j = 0; j < st->rules.count; j++) {
+                if (ms ? match_eval(&ms->progs[j], c) : rule_matches_client(&st->rules.rules[j], c))
+                    count++;
+            }
+            wi->matches[i] = count;
+        }
+        wi->counts_gen = st->status_gen;
+        wi->clients_gen = st->clients_gen;
+        wi->counts_ok = 1;
+        /* a rule edit only reorders when sorting by match count */
+        if (clients_moved || st->win_sort == WSORT_MATCHES) wi->order_ok = 0;
+        if (clients_moved) wi->shown_ok = 0;
+    }
+
+    if (!wi->order_ok || wi->order_sort != st->win_sort || wi->order_group != st->win_group) {
+        for (size_t i = 0; i < n; i++) wi->order[i] = (int)i;
+        sort_ctx = st;
+        qsort(wi->order, n, sizeof(int), compare_client_idx);
+        sort_ctx = NULL;
+        wi->order_sort = st->win_sort;
+        wi->order_group = st->win_group;
+        wi->order_ok = 1;
+        wi->shown_ok = 0;
+    }
+
+    if (!wi->shown_ok || strcmp(wi->shown_filter, st->win_filter) != 0) {
+        /* a query that only grew can only drop windows from the last result */
+        const int *src = wi->order;
+        int src_count = (int)n;
+        if (wi->shown_ok && strstr(st->win_filter, wi->shown_filter)) {
+            src = wi->shown;
+            src_count = wi->shown_count;
+        }
+        int k = 0;
+        for (int i = 0; i < src_count; i++)
+            if (client_passes_filter(&st->clients.items[src[i]], st->win_filter))
+                wi->shown[k++] = src[i];
+        wi->shown_count = k;
+        snprintf(wi->shown_filter, sizeof(wi->shown_filter), "%s", st->win_filter);
+        wi->shown_ok = 1;
+        wi->rows_ok = 0;
+    }
 
+    if (!wi->rows_ok) {
+        int r = 0;
+        wi->group_count = 0;
+        for (int i = 0; i < wi->shown_count; i++) {
+            const struct client *c = &st->clients.items[wi->shown[i]];
+            if (st->win_group) {
+                struct win_group *g = wi->group_count > 0 ? &wi->groups[wi->group_count - 1] : NULL;
+                if (!g || g->ws_id != c->workspace_id) {
+                    g = &wi->groups[wi->group_count];
+                    g->ws_id = c->workspace_id;
+                    g->ws_name = c->workspace_name;
+                    g->count = 0;
+                    g->collapsed = win_is_collapsed(st, c->workspace_id);
+                    wi->rows[r++] = -1 - wi->group_count++;
+                }
+                g->count++;
+                if (g->collapsed) continue;
+            }
+            wi->rows[r++] = wi->shown[i];
+        }
+        wi->row_count = r;
+        wi->rows_ok = 1;
+    }
+    return wi;
+}
+
+/* client index under the selection, or -1 on a header / empty view */
+static int win_selected_client(struct ui_state *st) {
+    const struct window_index *wi = window_index_get(st);
+    if (st->selected < 0 || st->selected >= wi->row_count) return -1;
+    return wi->rows[st->selected];
+}
+
+/* after a sort, filter or grouping change, keep the same window selected */
+static void win_reselect(struct ui_state *st, int client) {
+    const struct window_index *wi = window_index_get(st);
+    st->selected = 0;
+    for (int r = 0; client >= 0 && r < wi->row_count; r++) {
+        if (wi->rows[r] == client) {
+            st->selected = r;
+            return;
+        }
+    }
+}
+
+/* --- client refresh --- */
+
+static int client_hits_rule(const struct match_set *ms, const struct ruleset *rs,
+                            size_t j, const struct client *c) {
+    return ms ? match_eval(&ms->progs[j], c) : rule_matches_client(&rs->rules[j], c);
+}
+
+/* move the per-window match counts onto cur, counting only new or
+ * changed windows; the order and filter layers rebuild from the counts */
+static void window_index_remap(struct ui_state *st, const struct clients *cur,
+                               const int *same, unsigned long old_gen, unsigned long new_gen) {
+    struct window_index *wi = &st->windex;
+    struct text_cell *cells = wi->cells && wi->cells_gen == old_gen ?
+                              calloc((cur->count ? cur->count : 1) * WCELL_COUNT, sizeof(*cells)) : NULL;
+    if (cells) {
+        for (size_t i = 0; i < cur->count; i++) {
+            if (same[i] < 0) continue;
+            struct text_cell *from = &wi->cells[(size_t)same[i] * WCELL_COUNT];
+            memcpy(&cells[i * WCELL_COUNT], from, WCELL_COUNT * sizeof(*cells));
+            memset(from, 0, WCELL_COUNT * sizeof(*cells));
+        }
+        window_cells_clear(wi);
+        free(wi->cells);
+        wi->cells = cells;
+        wi->cells_count = cur->count;
+        wi->cells_gen = new_gen;
+    }
+
+    if (!wi->counts_ok || wi->clients_gen != old_gen || wi->counts_gen != st->status_gen) return;
+    int *counts = malloc((cur->count ? cur->count : 1) * sizeof(int));
+    if (!counts || window_index_reserve(wi, cur->count) != 0) {
+        free(counts);
+        wi->counts_ok = 0;
+        return;
+    }
+    const struct match_set *ms = NULL;
+    for (size_t i = 0; i < cur->count; i++) {
+        if (same[i] >= 0) {
+            counts[i] = wi->matches[same[i]];
+            continue;
+        }
+        if (!ms) ms = ui_matchers(st);
+        int count = 0;
+        for (size_t j = 0; j < st->rules.count; j++)
+            count += client_hits_rule(ms, &st->rules, j, &cur->items[i]);
+        counts[i] = count;
+    }
+    memcpy(wi->matches, counts, cur->count * sizeof(int));
+    free(counts);
+    wi->clients_gen = new_gen;
+    wi->order_ok = wi->shown_ok = 0;
+}
+
+/* carry the unused flags from the windows in old over to cur: unused rules
+ * are tried on the windows that appeared or changed, used ones are only
+ * rechecked when a window they matched went away. Returns 1 when a flag
+ * moved. */
+static int rule_status_remap(struct ui_state *st, const struct clients *old,
+                             const struct clients *cur, const int *same,
+                             const unsigned char *kept) {
+    int *added = malloc((cur->count ? cur->count : 1) * sizeof(int));
+    int *gone = malloc((old->count ? old->count : 1) * sizeof(int));
+    size_t added_count = 0, gone_count = 0;
+    if (!added || !gone) {
+        free(added);
+        free(gone);
+        return -1;
+    }
+    for (size_t i = 0; i < cur->count; i++)
+        if (same[i] < 0) added[added_count++] = (int)i;
+    for (size_t i = 0; i < old->count; i++)
+        if (!kept[i]) gone[gone_count++] = (int)i;
+
+    int moved = 0;
+    const struct match_set *ms = added_count || gone_count ? ui_matchers(st) : NULL;
+    for (size_t j = 0; (added_count || gone_count) && j < st->rules.count; j++) {
+        enum rule_status s = st->rule_status[j];
+        if (s == RULE_DUPLICATE) continue;
+        /* with no windows nothing counts as unused */
+        if (old->count == 0) s = RULE_UNUSED;
+        enum rule_status want = s;
+        if (cur->count == 0) {
+            want = RULE_OK;
+        } else if (s == RULE_UNUSED) {
+            for (size_t k = 0; k < added_count && want == RULE_UNUSED; k++)
+                if (client_hits_rule(ms, &st->rules, j, &cur->items[added[k]])) want = RULE_OK;
+        } else {
+            int lost = 0;
+            for (size_t k = 0; k < gone_count && !lost; k++)
+                lost = client_hits_rule(ms, &st->rules, j, &old->items[gone[k]]);
+            if (lost) {
+                want = RULE_UNUSED;
+                for (size_t i = 0; i < cur->count && want == RULE_UNUSED; i++)
+                    if (client_hits_rule(ms, &st->rules, j, &cur->items[i])) want = RULE_OK;
+            }
+        }
+        if (want != st->rule_status[j]) {
+            st->rule_status[j] = want;
+            moved = 1;
+        }
+    }
+    free(added);
+    free(gone);
+    return moved;
+}
+
+/* replace st->clients with cur, keeping what was derived from the windows
+ * that are still there unchanged */
+static void clients_adopt(struct ui_state *st, struct clients *cur, int rescan) {
+    unsigned long old_gen = st->clients_gen, new_gen = old_gen + 1;
+    int *same = malloc((cur->count ? cur->count : 1) * sizeof(int));
+    unsigned char *kept = malloc(st->clients.count ? st->clients.count : 1);
+    if (same && kept && clients_diff(&st->clients, cur, same, kept) == 0) {
+        window_index_remap(st, cur, same, old_gen, new_gen);
+        if (st->rule_status && !rescan && st->status_clients_gen == old_gen) {
+            unsigned long prev = st->status_gen;
+            int moved = rule_status_remap(st, &st->clients, cur, same, kept);
+            if (moved > 0) {
+                st->status_gen++;
+                /* only flags moved, the rules did not: keep what hangs off them */
+                if (st->matchers_gen == prev) st->matchers_gen = st->status_gen;
+                if (st->windex.counts_gen == prev) st->windex.counts_gen = st->status_gen;
+            }
+            if (moved >= 0) st->status_clients_gen = new_gen;
+        }
+    }
+    free(same);
+    free(kept);
+
+    clients_free(&st->clients);
+    st->clients = *cur;
+    st->clients_gen = new_gen;
+    if (rescan && st->rule_status) st->scan.wanted = 1;
+}
+
+static void draw_windows_view(struct ncplane *n, struct ui_state *st, int y, int h, int w) {
     load_clients(st);
+    const struct window_index *wi = window_index_get(st);
+
+    char title[160];
+    int tl = snprintf(title, sizeof(title), "Active Windows (%d/%zu) sort:%s",
+                      wi->shown_count, st->clients.count, win_sort_names[st->win_sort]);
+    if (st->win_group && tl < (int)sizeof(title))
+        tl += snprintf(title + tl, sizeof(title) - (size_t)tl, " by workspace");
+    if ((st->win_filter[0] || st->win_filter_editing) && tl < (int)sizeof(title))
+        snprintf(title + tl, sizeof(title) - (size_t)tl, " filter:%s%s",
+                 st->win_filter, st->win_filter_editing ? "_" : "");
+    draw_box(n, y, 0, h, w, title);
 
-    if (st->clients.count == 0) {
+    if (st->clients.count == 0 || wi->row_count == 0) {
         ui_set_color(n, COL_DIM);
-        ncplane_printf_yx(n, y + h / 2, (w - 24) / 2, "No windows found");
+        ncplane_printf_yx(n, y + h / 2, (w - 24) / 2, "%s",
+                          st->clients.count == 0 ? "No windows found" : "No windows match filter");
         ui_reset_color(n);
         return;
     }
 
     /* clamp selected */
-    if (st->selected >= (int)st->clients.count) st->selected = (int)st->clients.count - 1;
+    if (st->selected >= wi->row_count) st->selected = wi->row_count - 1;
     if (st->selected < 0) st->selected = 0;
 
     int visible = h - 3; /* box top + header + box bottom */
-    int max_scroll = (int)st->clients.count > visible ? (int)st->clients.count - visible : 0;
+    int max_scroll = wi->row_count > visible ? wi->row_count - visible : 0;
     if (st->scroll > max_scroll) st->scroll = max_scroll;
     if (st->scroll < 0) st->scroll = 0;
     if (st->selected < st->scroll) st->scroll = st->selected;
@@ -938,33 +2303,51 @@ static void draw_windows_view(struct ncplane *n, struct ui_state *st, int y, int
     ncplane_printf_yx(n, y + 1, col_match, "%s", "Rules");
     ui_reset_color(n);
 
-    for (int i = 0; i < visible && (st->scroll + i) < (int)st->clients.count; i++) {
+    for (int i = 0; i < visible && (st->scroll + i) < wi->row_count; i++) {
         int idx = st->scroll + i;
-        struct client *c = &st->clients.items[idx];
         int row = y + 2 + i;
 
-        /* count matching rules */
-        int match_count = 0;
-        for (size_t j = 0; j < st->rules.count; j++) {
-            if (rule_matches_client(&st->rules.rules[j], c))
-                match_count++;
+        if (wi->rows[idx] < 0) {
+            const struct win_group *g = &wi->groups[-1 - wi->rows[idx]];
+            if (idx == st->selected) {
+                ui_set_color(n, COL_SELECT);
+                ui_fill_row(n, row, 1, w - 2, ' ');
+            } else {
+                ui_set_color(n, COL_TITLE);
+            }
+            int cx = 2;
+            ncplane_putstr_yx(n, row, cx, g->collapsed ? "\u25b8 " : "\u25be "); cx += 2;
+            char label[96];
+            if (g->ws_name && strcmp(g->ws_name, "") != 0)
+                snprintf(label, sizeof(label), "Workspace %s (%d) ", g->ws_name, g->count);
+            else
+                snprintf(label, sizeof(label), "Workspace %d (%d) ", g->ws_id, g->count);
+            ncplane_putstr_yx(n, row, cx, label); cx += text_width(label);
+            for (; idx != st->selected && cx < w - 2; cx++)
+                ncplane_putstr_yx(n, row, cx, "\u2500");
+            ui_reset_color(n);
+            continue;
         }
 
+        struct client *c = &st->clients.items[wi->rows[idx]];
+        int match_count = wi->matches[wi->rows[idx]];
+
         if (idx == st->selected) {
             ui_set_color(n, COL_SELECT);
             ui_fill_row(n, row, 1, w - 2, ' ');
         }
 
+        struct text_cell *cells = window_cells(st, wi->rows[idx]);
         const char *cls = c->class_name ? c->class_name : "<unknown>";
-        ncplane_printf_yx(n, row, col_class, "%-*.*s", col_class_w, col_class_w, cls);
+        put_cell(n, row, col_class, cells ? &cells[WCELL_CLASS] : NULL, cls, col_class_w);
 
         const char *title = c->title ? c->title : "";
-        ncplane_printf_yx(n, row, col_title, "%-*.*s", col_title_w, col_title_w, title);
+        put_cell(n, row, col_title, cells ? &cells[WCELL_TITLE] : NULL, title, col_title_w);
 
         if (c->workspace_id >= 0)
             ncplane_printf_yx(n, row, col_ws, "%-*d", col_ws_w, c->workspace_id);
         else if (c->workspace_name)
-            ncplane_printf_yx(n, row, col_ws, "%-*.*s", col_ws_w, col_ws_w, c->workspace_name);
+            put_cell(n, row, col_ws, cells ? &cells[WCELL_WS] : NULL, c->workspace_name, col_ws_w);
         else
             ncplane_printf_yx(n, row, col_ws, "%-*s", col_ws_w, "-");
 
@@ -981,7 +2364,7 @@ static void draw_windows_view(struct ncplane *n, struct ui_state *st, int y, int
 
     /* scrollbar */
     if (max_scroll > 0)
-        draw_scrollbar(n, y + 2, w - 1, visible, (int)st->clients.count, st->scroll);
+        draw_scrollbar(n, y + 2, w - 1, visible, wi->row_count, st->scroll);
 }
 
 /* returns rule index to jump to, or -1 if closed without selection */
@@ -1059,9 +2442,7 @@ static int window_detail_popup(ui_state_machine_t *sm, struct client *c, struct
         } else {
             for (int m = 0; m < match_count && r < p.y + p.h - 1; m++) {
                 int ri = matches[m];
-                const char *rname = rs->rules[ri].display_name
-                    ? rs->rules[ri].display_name
-                    : rs->rules[ri].name;
+                const char *rname = rule_label_or(&rs->rules[ri], NULL);
                 if (m == sel) {
                     ui_set_color(n, COL_SELECT);
                     ui_fill_row(n, r, lx + 1, content_w - 1, ' ');
@@ -1105,31 +2486,74 @@ static int window_detail_popup(ui_state_machine_t *sm, struct client *c, struct
     }
 }
 
+static void review_index_free(struct review_index *ri) {
+    free(ri->unused);
+    memset(ri, 0, sizeof(*ri));
+}
+
+/* rebuild the review model if rules or status changed since it was built */
+static const struct review_index *review_index_get(struct ui_state *st) {
+    struct review_index *ri = &st->review;
+    if (ri->built && ri->gen == st->status_gen) return ri;
+
+    ri->unused_count = 0;
+    ri->dup_rules = 0;
+    ri->dup_groups = 0;
+    if (st->rule_status) {
+        for (size_t i = 0; i < st->rules.count; i++) {
+            if (st->rule_status[i] == RULE_DUPLICATE) {
+                ri->dup_rules++;
+                continue;
+            }
+            if (st->rule_status[i] != RULE_UNUSED) continue;
+            if (ri->unused_count == ri->unused_cap) {
+                int cap = ri->unused_cap ? ri->unused_cap * 2 : 64;
+                int *tmp = realloc(ri->unused, (size_t)cap * sizeof(int));
+                if (!tmp) break;
+                ri->unused = tmp;
+                ri->unused_cap = cap;
+            }
+            ri->unused[ri->unused_count++] = (int)i;
+        }
+    }
+
+    if (ri->dup_rules > 0) {
+        size_t mask;
+        struct label_count *tab = count_labels(st, NULL, &mask);
+        if (tab) {
+            for (size_t i = 0; i <= mask; i++)
+                if (tab[i].count > 1) ri->dup_groups++;
+            free(tab);
+        }
+    }
+
+    ri->missing_count = (int)st->missing.count;
+    int rows = ri->unused_count > 0 ? 1 + ri->unused_count : 0;
+    ri->missing_hdr_row = ri->missing_count > 0 ? rows : -1;
+    if (ri->missing_count > 0) rows += 1 + ri->missing_count;
+    ri->display_total = rows;
+
+    ri->gen = st->status_gen;
+    ri->built = 1;
+    return ri;
+}
+
 /* count unused rules (RULE_UNUSED status) */
 static int review_count_unused(struct ui_state *st) {
-    int count = 0;
-    if (!st->rule_status) return 0;
-    for (size_t i = 0; i < st->rules.count; i++) {
-        if (st->rule_status[i] == RULE_UNUSED) count++;
-    }
-    return count;
+    return review_index_get(st)->unused_count;
 }
 
 /* get the ruleset index of the nth unused rule */
 static int review_unused_index(struct ui_state *st, int nth) {
-    int count = 0;
-    for (size_t i = 0; i < st->rules.count; i++) {
-        if (st->rule_status[i] == RULE_UNUSED) {
-            if (count == nth) return (int)i;
-            count++;
-        }
-    }
-    return -1;
+    const struct review_index *ri = review_index_get(st);
+    if (nth < 0 || nth >= ri->unused_count) return -1;
+    return ri->unused[nth];
 }
 
 /* total selectable items in review view */
 static int review_total_items(struct ui_state *st) {
-    return review_count_unused(st) + (int)st->missing.count;
+    const struct review_index *ri = review_index_get(st);
+    return ri->unused_count + ri->missing_count;
 }
 
 static void draw_review_view(ui_state_machine_t *sm, struct ui_state *st, int y, int h, int w) {
@@ -1141,8 +2565,9 @@ static void draw_review_view(ui_state_machine_t *sm, struct ui_state *st, int y,
                          (void (*)(void *))load_review_data, st);
     }
 
-    int unused_count = review_count_unused(st);
-    int missing_count = (int)st->missing.count;
+    const struct review_index *ri = review_index_get(st);
+    int unused_count = ri->unused_count;
+    int missing_count = ri->missing_count;
     int total = unused_count + missing_count;
 
     if (total == 0) {
@@ -1165,6 +2590,11 @@ static void draw_review_view(ui_state_machine_t *sm, struct ui_state *st, int y,
             "Total: %zu  Active: %d  ", st->rules.count, active_count);
         if (unused_count > 0) ui_set_color(n, COL_WARN);
         ncplane_printf(n, "Unused: %d  ", unused_count);
+        if (ri->dup_rules > 0) {
+            ui_set_color(n, COL_ERROR);
+            ncplane_printf(n, "Dup: %d in %d group%s  ", ri->dup_rules, ri->dup_groups,
+                           ri->dup_groups == 1 ? "" : "s");
+        }
         if (missing_count > 0) ui_set_color(n, COL_ERROR);
         else ui_set_color(n, COL_DIM);
         ncplane_printf(n, "Missing: %d", missing_count);
@@ -1197,15 +2627,14 @@ static void draw_review_view(ui_state_machine_t *sm, struct ui_state *st, int y,
     ui_reset_color(n);
 
     /* draw items */
-    int header_rows = (unused_count > 0 ? 1 : 0) + (missing_count > 0 ? 1 : 0);
-    int display_total = total + header_rows;
+    int display_total = ri->display_total;
     int max_scroll_d = display_total > visible ? display_total - visible : 0;
     if (st->scroll > max_scroll_d) st->scroll = max_scroll_d;
 
     /* map selected item index to display row (accounting for section headers) */
-    int sel_display = st->selected;
-    if (unused_count > 0) sel_display++; /* unused header before item 0 */
-    if (st->selected >= unused_count && missing_count > 0) sel_display++; /* missing header */
+    int sel_display = st->selected < unused_count
+        ? 1 + st->selected
+        : ri->missing_hdr_row + 1 + (st->selected - unused_count);
 
     if (sel_display < st->scroll) st->scroll = sel_display;
     if (sel_display >= st->scroll + visible) st->scroll = sel_display - visible + 1;
@@ -1214,61 +2643,46 @@ static void draw_review_view(ui_state_machine_t *sm, struct ui_state *st, int y,
         int di = st->scroll + vi; /* display index (includes headers) */
         int row = table_y + vi;
 
-        /* determine what this display row shows */
-        int unused_hdr = (unused_count > 0) ? 0 : -1; /* display index of unused header */
-        int missing_hdr = -1;
-        int item_offset = 0; /* running offset to subtract from di to get item index */
-
-        /* unused section header is at display index 0 if unused_count > 0 */
-        if (unused_hdr >= 0 && di == unused_hdr) {
-            ui_set_color(n, COL_WARN);
-            int cx = 2;
-            ncplane_putstr_yx(n, row, cx, "\u2500\u2500 "); cx += 3;
-            char label[64];
-            snprintf(label, sizeof(label), "Unused Rules (%d) ", unused_count);
-            ncplane_putstr_yx(n, row, cx, label); cx += (int)strlen(label);
-            for (; cx < w - 2; cx++)
-                ncplane_putstr_yx(n, row, cx, "\u2500");
-            ui_reset_color(n);
-            continue;
-        }
-        if (unused_count > 0) item_offset = 1;
+        if (di >= display_total) break;
 
-        /* missing section header position */
-        missing_hdr = unused_count + item_offset;
-        if (missing_count > 0 && di == missing_hdr) {
-            ui_set_color(n, COL_ERROR);
+        /* section headers sit at display row 0 and missing_hdr_row */
+        int is_unused_hdr = unused_count > 0 && di == 0;
+        int is_missing_hdr = di == ri->missing_hdr_row;
+        if (is_unused_hdr || is_missing_hdr) {
+            ui_set_color(n, is_unused_hdr ? COL_WARN : COL_ERROR);
             int cx = 2;
             ncplane_putstr_yx(n, row, cx, "\u2500\u2500 "); cx += 3;
             char label[64];
-            snprintf(label, sizeof(label), "Missing Rules (%d) ", missing_count);
+            if (is_unused_hdr)
+                snprintf(label, sizeof(label), "Unused Rules (%d) ", unused_count);
+            else
+                snprintf(label, sizeof(label), "Missing Rules (%d) ", missing_count);
             ncplane_putstr_yx(n, row, cx, label); cx += (int)strlen(label);
             for (; cx < w - 2; cx++)
                 ncplane_putstr_yx(n, row, cx, "\u2500");
             ui_reset_color(n);
             continue;
         }
-        if (missing_count > 0 && di > missing_hdr) item_offset++;
 
-        int idx = di - item_offset;
+        int idx = ri->missing_hdr_row >= 0 && di > ri->missing_hdr_row
+            ? unused_count + (di - ri->missing_hdr_row - 1)
+            : di - 1;
         if (idx < 0 || idx >= total) continue;
 
         if (idx < unused_count) {
             /* unused rule */
-            int ri = review_unused_index(st, idx);
-            if (ri < 0) continue;
-            struct rule *r = &st->rules.rules[ri];
+            struct rule *r = &st->rules.rules[ri->unused[idx]];
 
             if (idx == st->selected) {
                 ui_set_color(n, COL_SELECT);
                 ui_fill_row(n, row, 1, w - 2, ' ');
             }
 
-            const char *name = r->display_name ? r->display_name : r->name;
+            const char *name = rule_label_or(r, NULL);
             ncplane_printf_yx(n, row, col_name, "%-*.*s", col_name_w, col_name_w,
                               name ? name : "<unnamed>");
 
-            const char *cls = r->match.class_re ? r->match.class_re : "-";
+            const char *cls = rule_get_or(r, RF_CLASS, "-");
             ncplane_printf_yx(n, row, col_class, "%-*.*s", col_class_w, col_class_w, cls);
 
             if (idx == st->selected) {
@@ -1324,7 +2738,7 @@ static int review_unused_popup(ui_state_machine_t *sm, int rule_idx) {
     int content_w = p.w - 4;
 
     while (1) {
-        const char *display = r->display_name ? r->display_name : r->name;
+        const char *display = rule_label_or(r, NULL);
         popup_draw(n, p, display ? display : "Unused Rule");
 
         int row = p.y + 2;
@@ -1344,10 +2758,10 @@ static int review_unused_popup(ui_state_machine_t *sm, int rule_idx) {
         ncplane_printf_yx(n, row, lx, "Matching");
         ui_reset_color(n);
         row++;
-        if (r->match.class_re)
-            ncplane_printf_yx(n, row++, lx + 2, "Class:  %.*s", content_w - 12, r->match.class_re);
-        if (r->match.title_re)
-            ncplane_printf_yx(n, row++, lx + 2, "Title:  %.*s", content_w - 12, r->match.title_re);
+        if (rule_get(r, RF_CLASS))
+            ncplane_printf_yx(n, row++, lx + 2, "Class:  %.*s", content_w - 12, rule_get(r, RF_CLASS));
+        if (rule_get(r, RF_TITLE))
+            ncplane_printf_yx(n, row++, lx + 2, "Title:  %.*s", content_w - 12, rule_get(r, RF_TITLE));
         row++;
 
         /* actions */
@@ -1355,12 +2769,12 @@ static int review_unused_popup(ui_state_machine_t *sm, int rule_idx) {
         ncplane_printf_yx(n, row, lx, "Actions");
         ui_reset_color(n);
         row++;
-        if (r->actions.tag)
-            ncplane_printf_yx(n, row++, lx + 2, "Tag:       %.*s", content_w - 16, clean_tag(r->actions.tag));
-        if (r->actions.workspace)
-            ncplane_printf_yx(n, row++, lx + 2, "Workspace: %s", r->actions.workspace);
-        if (r->actions.float_set)
-            ncplane_printf_yx(n, row++, lx + 2, "Float:     %s", r->actions.float_val ? "Yes" : "No");
+        if (rule_get(r, RF_TAG))
+            ncplane_printf_yx(n, row++, lx + 2, "Tag:       %.*s", content_w - 16, clean_tag(rule_get(r, RF_TAG)));
+        if (rule_get(r, RF_WORKSPACE))
+            ncplane_printf_yx(n, row++, lx + 2, "Workspace: %s", rule_get(r, RF_WORKSPACE));
+        if (rule_has(r, RF_FLOAT))
+            ncplane_printf_yx(n, row++, lx + 2, "Float:     %s", rule_get_bool(r, RF_FLOAT) ? "Yes" : "No");
 
         ui_set_color(n, COL_DIM);
         ncplane_printf_yx(n, p.y + p.h - 1, p.x + 3,
@@ -1379,7 +2793,7 @@ static int review_unused_popup(ui_state_machine_t *sm, int rule_idx) {
         if (id == NCKEY_ENTER || id == '\n')
             return rule_idx;
         if (id == 'd' || id == NCKEY_DEL) {
-            const char *rname = r->name ? r->name : "(unnamed)";
+            const char *rname = rule_get_or(r, RF_NAME, "(unnamed)");
             char msg[128];
             snprintf(msg, sizeof(msg), "Delete rule '%s'?", rname);
             if (confirm_dialog(sm, "Delete Rule", msg)) {
@@ -1463,15 +2877,15 @@ static int review_missing_popup(ui_state_machine_t *sm, struct missing_rule *mr)
             /* pre-fill from missing rule data */
             struct rule *r = &st->rules.rules[new_idx];
             if (mr->class_pattern)
-                r->match.class_re = strdup(mr->class_pattern);
+                rule_set(r, RF_CLASS, mr->class_pattern);
             if (mr->app_name)
-                r->name = strdup(mr->app_name);
+                rule_set(r, RF_NAME, mr->app_name);
 
             /* open editor; if saved, return index; if cancelled, remove */
             if (edit_rule_modal(sm, r, new_idx, &st->history)) {
                 update_display_name(r);
                 st->modified = 1;
-                if (st->rule_modified) st->rule_modified[new_idx] = 1;
+                mark_rule_modified(st, new_idx);
                 return new_idx;
             } else {
                 /* cancelled — remove the empty rule */
@@ -1595,19 +3009,216 @@ static int save_rules(struct ui_state *st) {
     fprintf(f, "# Window Rules - managed by hyprwindows\n");
     fprintf(f, "# See https://wiki.hyprland.org/Configuring/Window-Rules/\n\n");
 
+    /* keep source spans in step with the file just written, so reload
+     * errors map back to rules */
+    uint32_t line = 4;
     for (size_t i = 0; i < st->rules.count; i++) {
-        rule_write(f, &st->rules.rules[i]);
+        struct rule *r = &st->rules.rules[i];
+        int n = rule_write(f, r);
+        r->src_line = line;
+        r->src_end = line + (uint32_t)n - 2;
+        line += (uint32_t)n;
     }
 
     fclose(f);
     free(expanded);
 
+    /* the file now holds the rules in display order */
+    if (st->file_order)
+        for (size_t i = 0; i < st->rules.count; i++) st->file_order[i] = (int)i;
+    snapshot_base(st, &st->rules);
     st->modified = 0;
     if (st->rule_modified)
         memset(st->rule_modified, 0, st->rules.count * sizeof(int));
     return 0;
 }
 
+/* --- merging external edits --- */
+
+static int rules_file_changed(const struct ui_state *st) {
+    char *path = expand_home(st->rules_path);
+    struct stat sb;
+    int rc = stat(path ? path : st->rules_path, &sb);
+    free(path);
+    if (rc != 0) return 0;
+    return sb.st_size != st->base_size ||
+           sb.st_mtim.tv_sec != st->base_mtime.tv_sec ||
+           sb.st_mtim.tv_nsec != st->base_mtime.tv_nsec;
+}
+
+/* pick a side for every conflict; returns 0 if cancelled */
+static int resolve_conflicts_popup(ui_state_machine_t *sm, struct merge_result *res) {
+    struct ncplane *n = sm->std;
+    int *idx = malloc(res->conflicts * sizeof(int));
+    if (!idx) return 0;
+    int nc = 0;
+    for (size_t i = 0; i < res->count; i++)
+        if (res->entries[i].conflict != MERGE_CLEAN) idx[nc++] = (int)i;
+
+    struct popup_rect p = popup_center(n, nc + 7, 76, 2, 2);
+    int visible = p.h - 6;
+    int sel = 0, scroll = 0, accepted = 0;
+
+    while (1) {
+        char title[64];
+        snprintf(title, sizeof(title), "Merge Conflicts (%d)", nc);
+        popup_draw(n, p, title);
+
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, p.y + 2, p.x + 3, "%.*s", p.w - 6,
+                          "The rules file changed on disk. Pick a side for each rule:");
+        ui_reset_color(n);
+
+        if (sel < scroll) scroll = sel;
+        if (sel >= scroll + visible) scroll = sel - visible + 1;
+        for (int i = 0; i < visible && scroll + i < nc; i++) {
+            const struct merge_entry *e = &res->entries[idx[scroll + i]];
+            const struct rule *shown = e->mine ? e->mine : e->disk;
+            const struct rule *chosen = e->take_disk ? e->disk : e->mine;
+            int row = p.y + 4 + i;
+            int is_sel = scroll + i == sel;
+            if (is_sel) {
+                ncplane_on_styles(n, NCSTYLE_BOLD);
+                ui_set_color(n, COL_SELECT);
+                ncplane_putstr_yx(n, row, p.x + 2, ">");
+            }
+            ui_set_color(n, e->take_disk ? COL_WARN : COL_ACCENT);
+            ncplane_printf_yx(n, row, p.x + 4, "[%-4s]", e->take_disk ? "disk" : "mine");
+            ui_set_color(n, chosen ? COL_NORMAL : COL_DIM);
+            ncplane_printf_yx(n, row, p.x + 11, "%-28.28s %s%.*s",
+                              rule_label_or(shown, "(unnamed)"), chosen ? "" : "(drop) ",
+                              p.w - 49, merge_conflict_str(e->conflict));
+            if (is_sel) ncplane_off_styles(n, NCSTYLE_BOLD);
+            ui_reset_color(n);
+        }
+
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, p.y + p.h - 1, p.x + 3,
+                          " Space:Toggle  m/d:All mine/disk  Enter:Merge  Esc:Cancel ");
+        ui_reset_color(n);
+        notcurses_render(sm->nc);
+
+        ncinput ni;
+        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
+        if (id == (uint32_t)-1) continue;
+        if (ni.evtype == NCTYPE_RELEASE) continue;
+
+        if (id == NCKEY_ESC || id == 'q') break;
+        if (id == NCKEY_ENTER || id == '\n') { accepted = 1; break; }
+        if (id == NCKEY_UP && sel > 0) sel--;
+        else if (id == NCKEY_DOWN && sel < nc - 1) sel++;
+        else if (id == ' ' || id == NCKEY_TAB)
+            res->entries[idx[sel]].take_disk ^= 1;
+        else if (id == 'm' || id == 'd')
+            for (int i = 0; i < nc; i++) res->entries[idx[i]].take_disk = id == 'd';
+    }
+    free(idx);
+    return accepted;
+}
+
+/*
+ * Fold changes made to the rules file since it was loaded into the
+ * in-memory rules. Returns the number of disk changes taken, 0 when the
+ * file is unchanged, or -1 when the merge failed or was cancelled.
+ */
+static int merge_with_disk(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    if (!rules_file_changed(st)) return 0;
+
+    char *path = expand_home(st->rules_path);
+    struct ruleset disk = {0};
+    int rc = ruleset_load(path ? path : st->rules_path, &disk);
+    free(path);
+    if (rc != 0) {
+        set_status(st, "Rules file changed on disk but could not be read");
+        return -1;
+    }
+
+    /* base and disk are in file order, and repeated identities are told
+     * apart by position: merge the rules in file order, not the current sort */
+    size_t count = st->rules.count;
+    int *idx = malloc((count ? count : 1) * sizeof(int));
+    struct ruleset mine = {malloc((count ? count : 1) * sizeof(struct rule)), count};
+    struct merge_result res;
+    if (!idx || !mine.rules) {
+        free(idx);
+        free(mine.rules);
+        ruleset_free(&disk);
+        set_status(st, "Out of memory merging rules");
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) idx[i] = (int)i;
+    sort_ctx = st;
+    qsort(idx, count, sizeof(int), compare_idx_by_file_order);
+    sort_ctx = NULL;
+    for (size_t i = 0; i < count; i++) mine.rules[i] = st->rules.rules[idx[i]];
+    free(idx);
+
+    if (merge_rules(&st->base, &disk, &mine, &res) != 0) {
+        free(mine.rules); /* borrowed rules: free the array only */
+        ruleset_free(&disk);
+        set_status(st, "Out of memory merging rules");
+        return -1;
+    }
+    if (res.conflicts > 0 && !resolve_conflicts_popup(sm, &res)) {
+        merge_result_free(&res);
+        free(mine.rules);
+        ruleset_free(&disk);
+        set_status(st, "Merge cancelled; nothing saved");
+        return -1;
+    }
+
+    struct ruleset merged;
+    int *modified = calloc(res.count ? res.count : 1, sizeof(int));
+    if (!modified || merge_build(&res, &merged) != 0) {
+        free(modified);
+        merge_result_free(&res);
+        free(mine.rules);
+        ruleset_free(&disk);
+        set_status(st, "Out of memory merging rules");
+        return -1;
+    }
+    /* rules kept from memory that differ from disk stay marked modified */
+    for (size_t i = 0, j = 0; i < res.count; i++) {
+        const struct merge_entry *e = &res.entries[i];
+        if (!(e->take_disk ? e->disk : e->mine)) continue;
+        modified[j++] = !e->take_disk &&
+                        (!e->disk || rule_fingerprint(e->disk) != rule_fingerprint(e->mine));
+    }
+    int taken = (int)res.disk_changes;
+    for (size_t i = 0; i < res.count; i++)
+        if (res.entries[i].conflict != MERGE_CLEAN && res.entries[i].take_disk) taken++;
+    merge_result_free(&res);
+    free(mine.rules);
+
+    /* the disk version is the new common ancestor; indices in the undo
+     * history no longer line up with the merged rules */
+    snapshot_base(st, &disk);
+    ruleset_free(&disk);
+    adopt_rules(st, &merged, modified);
+    history_free(&st->history);
+    history_init(&st->history);
+    st->modified = 1;
+    return taken;
+}
+
+/* merge external edits, then save; returns 0 on success */
+static int save_rules_merged(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    int taken = merge_with_disk(sm);
+    if (taken < 0) return -1;
+    if (save_rules(st) != 0) {
+        set_status(st, "Failed to save rules");
+        return -1;
+    }
+    if (taken > 0)
+        set_status(st, "Saved %zu rules to %s (merged %d change%s from disk)", st->rules.count,
+                   st->rules_path, taken, taken == 1 ? "" : "s");
+    else
+        set_status(st, "Saved %zu rules to %s", st->rules.count, st->rules_path);
+    return 0;
+}
+
 static void get_disabled_path(const char *rules_path, char *out, size_t out_sz) {
     if (out_sz < 20) return;
     const char *dot = strrchr(rules_path, '.');
@@ -1624,6 +3235,74 @@ static void get_disabled_path(const char *rules_path, char *out, size_t out_sz)
     }
 }
 
+/* --- live match preview --- */
+
+#define PREVIEW_ROWS 5
+#define PREVIEW_FRAME_NS 16000000L /* poll interval while a preview is pending */
+
+/* candidates come from the windows and appmap already loaded: opening
+ * the editor never waits on hyprctl or the disk */
+static void preview_collect(struct ui_state *st, struct match_preview *pv) {
+    for (size_t i = 0; i < st->clients.count; i++) {
+        const struct client *c = &st->clients.items[i];
+        preview_add(pv, c->class_name, PREVIEW_WINDOW_CLASS, (long)i);
+        preview_add(pv, c->initial_class, PREVIEW_WINDOW_CLASS, (long)i);
+        preview_add(pv, c->title, PREVIEW_WINDOW_TITLE, (long)i);
+    }
+
+    for (size_t i = 0; i < st->appmap.count; i++) {
+        const struct appmap_entry *e = &st->appmap.entries[i];
+        for (size_t j = 0; j < e->class_count; j++)
+            preview_add(pv, e->classes[j], PREVIEW_KNOWN_CLASS, -1);
+    }
+    preview_start(pv);
+}
+
+/* post pattern if it differs from the last one posted */
+static void preview_sync(struct match_preview *pv, char *last, size_t last_sz,
+                         int *last_mask, const char *pattern, int mask) {
+    if (*last_mask == mask && strcmp(last, pattern) == 0) return;
+    snprintf(last, last_sz, "%s", pattern);
+    *last_mask = mask;
+    preview_post(pv, pattern, mask);
+}
+
+/* summary line plus up to rows-1 matches; returns rows used */
+static int draw_match_preview(struct ncplane *n, struct match_preview *pv,
+                              int y, int x, int w, int rows) {
+    if (rows < 1) return 0;
+    struct preview_result res;
+    int have = preview_snapshot(pv, &res, (size_t)(rows - 1));
+    int pending = preview_pending(pv);
+
+    ui_set_color(n, COL_DIM);
+    if (!have) {
+        ncplane_printf_yx(n, y, x, "Preview: matching...");
+    } else if (!res.valid) {
+        ui_set_color(n, COL_ERROR);
+        ncplane_printf_yx(n, y, x, "Preview: invalid regex");
+    } else {
+        if (res.windows + res.known > 0) ui_set_color(n, COL_ACCENT);
+        ncplane_printf_yx(n, y, x, "Preview: %zu window%s, %zu known app%s%s",
+                          res.windows, res.windows == 1 ? "" : "s",
+                          res.known, res.known == 1 ? "" : "s",
+                          pending ? " ..." : "");
+    }
+    ui_reset_color(n);
+
+    int used = 1;
+    for (size_t i = 0; have && i < res.count && used < rows; i++, used++) {
+        const struct preview_candidate *c = &pv->cands[res.idx[i]];
+        ui_set_color(n, c->kind == PREVIEW_KNOWN_CLASS ? COL_DIM : COL_NORMAL);
+        ncplane_printf_yx(n, y + used, x + 2, "%s %.*s",
+                          c->kind == PREVIEW_KNOWN_CLASS ? "app" : "win",
+                          w - 6, c->text);
+        ui_reset_color(n);
+    }
+    if (have) preview_result_free(&res);
+    return used;
+}
+
 /* --- class alternatives popup --- */
 
 enum match_mode { MATCH_EXACT, MATCH_PREFIX, MATCH_CONTAINS, MATCH_MODE_COUNT };
@@ -1748,7 +3427,8 @@ static void build_class_from_alts(char *buf, size_t buf_sz, char alts[][128],
 }
 
 /* popup for editing class alternatives with checkboxes, match modes, and case toggle */
-static int class_alternatives_popup(ui_state_machine_t *sm, char *class_buf, size_t class_buf_sz) {
+static int class_alternatives_popup(ui_state_machine_t *sm, char *class_buf, size_t class_buf_sz,
+                                    struct match_preview *pv) {
     struct ncplane *n = sm->std;
 
     char alts[32][128];
@@ -1765,15 +3445,17 @@ static int class_alternatives_popup(ui_state_machine_t *sm, char *class_buf, siz
     char add_buf[128] = "";
     int add_cursor = 0;
     int scroll = 0;
+    char posted[256] = "";
+    int posted_mask = 0;
 
     while (1) {
         int total_rows = count + 1; /* alternatives + add row */
-        /* +7: border*2 + case toggle + header + items + hint*2 */
-        int popup_h = total_rows + 8;
-        if (popup_h > 24) popup_h = 24;
+        /* +7: border*2 + case toggle + header + items + hint*2, then the preview pane */
+        int popup_h = total_rows + 8 + PREVIEW_ROWS;
+        if (popup_h > 24 + PREVIEW_ROWS) popup_h = 24 + PREVIEW_ROWS;
         int popup_w = 60;
         struct popup_rect p = popup_center(n, popup_h, popup_w, 2, 4);
-        int content_h = p.h - 8;
+        int content_h = p.h - 8 - PREVIEW_ROWS;
         if (content_h < 1) content_h = 1;
         int avail_w = p.w - 14; /* space for " [x] [=] text" */
 
@@ -1845,6 +3527,16 @@ static int class_alternatives_popup(ui_state_machine_t *sm, char *class_buf, siz
             draw_scrollbar(n, p.y + 4, p.x + p.w - 2, content_h, total_rows, scroll);
         }
 
+        /* preview of the pattern as it would be saved */
+        {
+            char pending_re[256];
+            build_class_from_alts(pending_re, sizeof(pending_re), alts, checked, modes,
+                                  count, case_insensitive);
+            preview_sync(pv, posted, sizeof(posted), &posted_mask, pending_re,
+                         PREVIEW_WINDOW_CLASS | PREVIEW_KNOWN_CLASS);
+            draw_match_preview(n, pv, p.y + 4 + content_h, p.x + 2, p.w - 4, PREVIEW_ROWS - 1);
+        }
+
         /* hints */
         ui_set_color(n, COL_DIM);
         if (adding) {
@@ -1876,7 +3568,9 @@ static int class_alternatives_popup(ui_state_machine_t *sm, char *class_buf, siz
         notcurses_render(sm->nc);
 
         ncinput ni;
-        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
+        struct timespec frame = { .tv_sec = 0, .tv_nsec = PREVIEW_FRAME_NS };
+        uint32_t id = notcurses_get(sm->nc, preview_pending(pv) ? &frame : NULL, &ni);
+        if (id == 0) continue; /* timeout: redraw with the fresh preview */
         if (id == (uint32_t)-1) continue;
         if (ni.evtype == NCTYPE_RELEASE) continue;
 
@@ -1995,7 +3689,7 @@ static int class_alternatives_popup(ui_state_machine_t *sm, char *class_buf, siz
 static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_index, struct history_stack *history) {
     struct ncplane *n = sm->std;
 
-    int base_h = 20;
+    int base_h = 20 + PREVIEW_ROWS + 1;
     int extras_h = r->extras_count > 0 ? (int)r->extras_count + 2 : 0;
     struct popup_rect p = popup_center(n, base_h + extras_h, 60, 4, 0);
     int h = p.h, w = p.w, y = p.y, x = p.x;
@@ -2005,17 +3699,17 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
 
     char name_buf[128], class_buf[128], title_buf[128], tag_buf[64], ws_buf[32], size_buf[32], opacity_buf[32];
     char orig_name[128], orig_class[128], orig_title[128], orig_tag[64], orig_ws[32], orig_size[32], orig_opacity[32];
-    int float_val = r->actions.float_set ? r->actions.float_val : 0;
-    int center_val = r->actions.center_set ? r->actions.center_val : 0;
+    int float_val = rule_get_bool(r, RF_FLOAT);
+    int center_val = rule_get_bool(r, RF_CENTER);
     int orig_float = float_val, orig_center = center_val;
 
-    snprintf(name_buf, sizeof(name_buf), "%s", r->name ? r->name : "");
-    snprintf(class_buf, sizeof(class_buf), "%s", r->match.class_re ? r->match.class_re : "");
-    snprintf(title_buf, sizeof(title_buf), "%s", r->match.title_re ? r->match.title_re : "");
-    snprintf(tag_buf, sizeof(tag_buf), "%s", r->actions.tag ? r->actions.tag : "");
-    snprintf(ws_buf, sizeof(ws_buf), "%s", r->actions.workspace ? r->actions.workspace : "");
-    snprintf(size_buf, sizeof(size_buf), "%s", r->actions.size ? r->actions.size : "");
-    snprintf(opacity_buf, sizeof(opacity_buf), "%s", r->actions.opacity ? r->actions.opacity : "");
+    snprintf(name_buf, sizeof(name_buf), "%s", rule_get_or(r, RF_NAME, ""));
+    snprintf(class_buf, sizeof(class_buf), "%s", rule_get_or(r, RF_CLASS, ""));
+    snprintf(title_buf, sizeof(title_buf), "%s", rule_get_or(r, RF_TITLE, ""));
+    snprintf(tag_buf, sizeof(tag_buf), "%s", rule_get_or(r, RF_TAG, ""));
+    snprintf(ws_buf, sizeof(ws_buf), "%s", rule_get_or(r, RF_WORKSPACE, ""));
+    snprintf(size_buf, sizeof(size_buf), "%s", rule_get_or(r, RF_SIZE, ""));
+    snprintf(opacity_buf, sizeof(opacity_buf), "%s", rule_get_or(r, RF_OPACITY, ""));
 
     snprintf(orig_name, sizeof(orig_name), "%s", name_buf);
     snprintf(orig_class, sizeof(orig_class), "%s", class_buf);
@@ -2028,6 +3722,12 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
     int editing = 0;
     int cursor_pos = 0;
 
+    struct match_preview pv;
+    preview_init(&pv);
+    preview_collect(sm->st, &pv);
+    char posted[256] = "";
+    int posted_mask = 0;
+
     while (1) {
         ui_set_color(n, COL_BORDER);
         popup_draw(n, p, "Edit Rule");
@@ -2107,6 +3807,20 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
             row++;
         }
 
+        /* live preview of the pattern field under the cursor */
+        if (field == F_CLASS || field == F_TITLE) {
+            if (field == F_CLASS)
+                preview_sync(&pv, posted, sizeof(posted), &posted_mask, class_buf,
+                             PREVIEW_WINDOW_CLASS | PREVIEW_KNOWN_CLASS);
+            else
+                preview_sync(&pv, posted, sizeof(posted), &posted_mask, title_buf,
+                             PREVIEW_WINDOW_TITLE);
+            int rows = y + h - 4 - (row + 1);
+            if (rows > PREVIEW_ROWS) rows = PREVIEW_ROWS;
+            draw_match_preview(n, &pv, row + 1, x + 2, w - 4, rows);
+        }
+        row += PREVIEW_ROWS + 1;
+
         if (r->extras_count > 0) {
             row++;
             ui_set_color(n, COL_ACCENT);
@@ -2143,7 +3857,9 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
         notcurses_render(sm->nc);
 
         ncinput ni;
-        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
+        struct timespec frame = { .tv_sec = 0, .tv_nsec = PREVIEW_FRAME_NS };
+        uint32_t id = notcurses_get(sm->nc, preview_pending(&pv) ? &frame : NULL, &ni);
+        if (id == 0) continue; /* timeout: redraw with the fresh preview */
         if (id == (uint32_t)-1) continue;
         if (ni.evtype == NCTYPE_RELEASE) continue;
 
@@ -2194,7 +3910,7 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
                     else if (field == F_CENTER) center_val = !center_val;
                     else if (bufs[field]) {
                         if (field == F_CLASS) {
-                            int ret = class_alternatives_popup(sm, class_buf, sizeof(class_buf));
+                            int ret = class_alternatives_popup(sm, class_buf, sizeof(class_buf), &pv);
                             if (ret == 0) { editing = 1; cursor_pos = (int)strlen(bufs[field]); }
                         } else {
                             editing = 1;
@@ -2219,7 +3935,7 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
             else if (field == F_CENTER) { center_val = !center_val; }
             else if (bufs[field]) {
                 if (field == F_CLASS) {
-                    int ret = class_alternatives_popup(sm, class_buf, sizeof(class_buf));
+                    int ret = class_alternatives_popup(sm, class_buf, sizeof(class_buf), &pv);
                     if (ret == 0) { editing = 1; cursor_pos = (int)strlen(bufs[field]); }
                     /* ret == 1 (saved) or -1 (cancelled): stay in edit_rule_modal */
                 } else {
@@ -2236,15 +3952,15 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
             struct rule old_state = rule_copy(r);
 
             /* apply changes to rule */
-            free(r->name); r->name = name_buf[0] ? strdup(name_buf) : NULL;
-            free(r->match.class_re); r->match.class_re = class_buf[0] ? strdup(class_buf) : NULL;
-            free(r->match.title_re); r->match.title_re = title_buf[0] ? strdup(title_buf) : NULL;
-            free(r->actions.tag); r->actions.tag = tag_buf[0] ? strdup(tag_buf) : NULL;
-            free(r->actions.workspace); r->actions.workspace = ws_buf[0] ? strdup(ws_buf) : NULL;
-            free(r->actions.size); r->actions.size = size_buf[0] ? strdup(size_buf) : NULL;
-            free(r->actions.opacity); r->actions.opacity = opacity_buf[0] ? strdup(opacity_buf) : NULL;
-            r->actions.float_set = 1; r->actions.float_val = float_val;
-            r->actions.center_set = 1; r->actions.center_val = center_val;
+            rule_set(r, RF_NAME, name_buf[0] ? name_buf : NULL);
+            rule_set(r, RF_CLASS, class_buf[0] ? class_buf : NULL);
+            rule_set(r, RF_TITLE, title_buf[0] ? title_buf : NULL);
+            rule_set(r, RF_TAG, tag_buf[0] ? tag_buf : NULL);
+            rule_set(r, RF_WORKSPACE, ws_buf[0] ? ws_buf : NULL);
+            rule_set(r, RF_SIZE, size_buf[0] ? size_buf : NULL);
+            rule_set(r, RF_OPACITY, opacity_buf[0] ? opacity_buf : NULL);
+            rule_set_bool(r, RF_FLOAT, float_val);
+            rule_set_bool(r, RF_CENTER, center_val);
             update_display_name(r);
 
             char desc[128];
@@ -2253,20 +3969,199 @@ static int edit_rule_modal(ui_state_machine_t *sm, struct rule *r, int rule_inde
             rule_free(&old_state);
 
             notcurses_cursor_disable(sm->nc);
+            preview_free(&pv);
             return 1;
         }
         else if (id == 'q' || id == 'Q' || id == NCKEY_ESC) {
             notcurses_cursor_disable(sm->nc);
+            preview_free(&pv);
             return 0;
         }
     }
 }
 
-/* --- search --- */
+/* --- what-if simulator --- */
 
-struct search_state {
-    char query[256];
-    int *matches;
+static void whatif_popup(ui_state_machine_t *sm, const struct client *prefill) {
+    struct ui_state *st = sm->st;
+    struct ncplane *n = sm->std;
+
+    struct simulator sim;
+    if (sim_init(&sim, &st->rules) != 0) {
+        set_status(st, "Failed to compile rules for simulation");
+        return;
+    }
+
+    static const char *labels[SIM_FIELD_COUNT] = {
+        "Class:", "Title:", "Init class:", "Init title:", "Workspace:",
+        "Floating:", "XWayland:", "Fullscreen:", "Pinned:",
+    };
+    char bufs[SIM_FIELD_COUNT][SIM_INPUT_MAX] = {{0}};
+    for (int f = SIM_FIRST_FLAG; f < SIM_FIELD_COUNT; f++) snprintf(bufs[f], SIM_INPUT_MAX, "no");
+    if (prefill) {
+        snprintf(bufs[SIM_CLASS], SIM_INPUT_MAX, "%s", prefill->class_name ? prefill->class_name : "");
+        snprintf(bufs[SIM_TITLE], SIM_INPUT_MAX, "%s", prefill->title ? prefill->title : "");
+        snprintf(bufs[SIM_INITIAL_CLASS], SIM_INPUT_MAX, "%s", prefill->initial_class ? prefill->initial_class : "");
+        snprintf(bufs[SIM_INITIAL_TITLE], SIM_INPUT_MAX, "%s", prefill->initial_title ? prefill->initial_title : "");
+        if (prefill->workspace_id > 0)
+            snprintf(bufs[SIM_WORKSPACE], SIM_INPUT_MAX, "%d", prefill->workspace_id);
+        else if (prefill->workspace_name)
+            snprintf(bufs[SIM_WORKSPACE], SIM_INPUT_MAX, "name:%s", prefill->workspace_name);
+        snprintf(bufs[SIM_FLOATING], SIM_INPUT_MAX, "%s", prefill->floating ? "yes" : "no");
+        snprintf(bufs[SIM_XWAYLAND], SIM_INPUT_MAX, "%s", prefill->xwayland ? "yes" : "no");
+        snprintf(bufs[SIM_FULLSCREEN], SIM_INPUT_MAX, "%s", prefill->fullscreen ? "yes" : "no");
+        snprintf(bufs[SIM_PINNED], SIM_INPUT_MAX, "%s", prefill->pinned ? "yes" : "no");
+    }
+    for (int f = 0; f < SIM_FIELD_COUNT; f++)
+        sim_set_field(&sim, (enum sim_field)f, bufs[f]);
+
+    unsigned scr_h, scr_w;
+    ncplane_dim_yx(n, &scr_h, &scr_w);
+    struct popup_rect p = popup_center(n, (int)scr_h - 4, 80, 2, 4);
+    int lx = p.x + 2, vx = p.x + 15;
+    int field_w = p.w - 17;
+    int field = 0;
+    int scroll = 0;
+
+    static const struct { enum rule_field f; const char *label; } props[] = {
+        {RF_WORKSPACE, "Workspace:"}, {RF_FLOAT, "Float:"}, {RF_CENTER, "Center:"},
+        {RF_SIZE, "Size:"}, {RF_MOVE, "Move:"}, {RF_OPACITY, "Opacity:"},
+    };
+    int nprops = (int)(sizeof(props) / sizeof(props[0]));
+
+    while (1) {
+        struct sim_outcome out;
+        if (sim_outcome(&sim, st->file_order, &out) != 0) break;
+
+        popup_draw(n, p, "What-if Simulator");
+
+        int row = p.y + 2;
+        for (int f = 0; f < SIM_FIELD_COUNT; f++, row++) {
+            ui_set_color(n, f == field ? COL_ACCENT : COL_DIM);
+            ncplane_printf_yx(n, row, lx, "%s", labels[f]);
+            ui_set_color(n, f == field ? COL_SELECT : COL_NORMAL);
+            int len = (int)strlen(bufs[f]);
+            int off = len > field_w - 1 ? len - (field_w - 1) : 0;
+            ncplane_printf_yx(n, row, vx, "%-*.*s", field_w, field_w, bufs[f] + off);
+            ui_reset_color(n);
+        }
+        row++;
+
+        /* cascaded result: last matching rule wins, tags accumulate */
+        ncplane_on_styles(n, NCSTYLE_BOLD);
+        ui_set_color(n, COL_ACCENT);
+        ncplane_printf_yx(n, row++, lx, "Result");
+        ncplane_off_styles(n, NCSTYLE_BOLD);
+        ui_reset_color(n);
+
+        char tags[256] = "";
+        size_t tlen = 0;
+        for (size_t i = 0; i < out.match_count && tlen < sizeof(tags) - 1; i++) {
+            const char *tag = rule_get(&st->rules.rules[out.matches[i]], RF_TAG);
+            if (tag)
+                tlen += (size_t)snprintf(tags + tlen, sizeof(tags) - tlen, "%s%s", tlen ? " " : "", tag);
+        }
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, row, lx + 2, "%-11s", "Tags:");
+        ui_set_color(n, COL_NORMAL);
+        put_cell(n, row++, lx + 14, NULL, tags[0] ? tags : "-", p.w - 18);
+        for (int i = 0; i < nprops; i++, row++) {
+            int src = out.source[props[i].f];
+            ui_set_color(n, COL_DIM);
+            ncplane_printf_yx(n, row, lx + 2, "%-11s", props[i].label);
+            ui_set_color(n, src >= 0 ? COL_NORMAL : COL_DIM);
+            if (src < 0) {
+                ncplane_printf_yx(n, row, lx + 14, "-");
+            } else {
+                const struct rule *r = &st->rules.rules[src];
+                const char *val = props[i].f >= RF_FLOAT
+                    ? (rule_get_bool(r, props[i].f) ? "yes" : "no")
+                    : rule_get(r, props[i].f);
+                put_cell(n, row, lx + 14, NULL, val, 16);
+                ui_set_color(n, COL_DIM);
+                ncplane_putstr_yx(n, row, lx + 32, "from ");
+                put_cell(n, row, lx + 37, NULL, rule_label_or(r, "(unnamed)"), p.w - 41);
+            }
+            ui_reset_color(n);
+        }
+        row++;
+
+        ncplane_on_styles(n, NCSTYLE_BOLD);
+        ui_set_color(n, COL_ACCENT);
+        ncplane_printf_yx(n, row, lx, "Matching rules (%zu)", out.match_count);
+        ncplane_off_styles(n, NCSTYLE_BOLD);
+        ui_set_color(n, COL_DIM);
+        ncplane_printf(n, "  %zu re-evaluated", sim.last_evaluated);
+        ui_reset_color(n);
+        row++;
+
+        int visible = p.y + p.h - 2 - row;
+        int total = (int)out.match_count;
+        if (scroll > total - visible) scroll = total - visible;
+        if (scroll < 0) scroll = 0;
+        for (int i = 0; i < visible && scroll + i < total; i++) {
+            int ri = out.matches[scroll + i];
+            const struct rule *r = &st->rules.rules[ri];
+            int order = st->file_order ? st->file_order[ri] : ri;
+            ui_set_color(n, COL_NORMAL);
+            ncplane_printf_yx(n, row + i, lx + 2, "#%-4d ", order + 1);
+            put_cell(n, row + i, lx + 8, NULL, rule_label_or(r, "(unnamed)"), 24);
+            put_cell(n, row + i, lx + 33, NULL, clean_tag(rule_get(r, RF_TAG)), 12);
+            put_cell(n, row + i, lx + 46, NULL,
+                     rule_get_or(r, RF_CLASS, rule_get_or(r, RF_TITLE, "-")), p.w - 50);
+            ui_reset_color(n);
+        }
+        if (total > visible && visible > 0)
+            draw_scrollbar(n, row, p.x + p.w - 2, visible, total, scroll);
+
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, p.y + p.h - 1, p.x + 3,
+                          " Type to edit  Space:Toggle flag  Up/Down/Tab:Field  PgUp/PgDn:Scroll  Esc:Close ");
+        ui_reset_color(n);
+
+        int len = (int)strlen(bufs[field]);
+        int off = len > field_w - 1 ? len - (field_w - 1) : 0;
+        notcurses_cursor_enable(sm->nc, p.y + 2 + field, vx + len - off);
+        notcurses_render(sm->nc);
+        sim_outcome_free(&out);
+
+        ncinput ni;
+        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
+        if (id == (uint32_t)-1) continue;
+        if (ni.evtype == NCTYPE_RELEASE) continue;
+
+        if (id == NCKEY_ESC) break;
+        if (id == NCKEY_UP) { if (field > 0) field--; }
+        else if (id == NCKEY_DOWN || id == '\t') field = (field + 1) % SIM_FIELD_COUNT;
+        else if (id == NCKEY_PGUP || id == NCKEY_SCROLL_UP) scroll -= visible > 1 ? visible - 1 : 1;
+        else if (id == NCKEY_PGDOWN || id == NCKEY_SCROLL_DOWN) scroll += visible > 1 ? visible - 1 : 1;
+        else if (field >= SIM_FIRST_FLAG) {
+            if (id == ' ' || id == NCKEY_ENTER || id == 'y' || id == 'n') {
+                int on = id == 'y' || (id != 'n' && strcmp(bufs[field], "yes") != 0);
+                snprintf(bufs[field], SIM_INPUT_MAX, "%s", on ? "yes" : "no");
+                sim_set_field(&sim, (enum sim_field)field, bufs[field]);
+            }
+        } else if (id == NCKEY_BACKSPACE || id == 127 || id == 8) {
+            if (len > 0) {
+                bufs[field][len - 1] = '\0';
+                sim_set_field(&sim, (enum sim_field)field, bufs[field]);
+            }
+        } else if (id >= 32 && id < 127 && len < SIM_INPUT_MAX - 1) {
+            bufs[field][len] = (char)id;
+            bufs[field][len + 1] = '\0';
+            sim_set_field(&sim, (enum sim_field)field, bufs[field]);
+        }
+    }
+
+    notcurses_cursor_disable(sm->nc);
+    sim_free(&sim);
+}
+
+/* --- search --- */
+
+struct search_state {
+    char query[256];
+    int *matches;
     size_t match_count;
     int current_match;
     int active;
@@ -2303,22 +4198,12 @@ static void search_update(struct search_state *s, struct ruleset *rs) {
     for (size_t i = 0; i < rs->count; i++) {
         struct rule *r = &rs->rules[i];
 
-        const char *name = r->display_name ? r->display_name : "";
-        const char *class_re = r->match.class_re ? r->match.class_re : "";
-        const char *title_re = r->match.title_re ? r->match.title_re : "";
-        const char *tag = r->actions.tag ? r->actions.tag : "";
-        const char *workspace = r->actions.workspace ? r->actions.workspace : "";
-
-        char name_lower[128];
-        snprintf(name_lower, sizeof(name_lower), "%s", name);
-        str_to_lower_inplace(name_lower);
+        const char *title_re = rule_get_or(r, RF_TITLE, "");
+        const char *tag = rule_get_or(r, RF_TAG, "");
+        const char *workspace = rule_get_or(r, RF_WORKSPACE, "");
 
-        char class_lower[128];
-        snprintf(class_lower, sizeof(class_lower), "%s", class_re);
-        str_to_lower_inplace(class_lower);
-
-        if (strstr(name_lower, lower_query) != NULL ||
-            strstr(class_lower, lower_query) != NULL ||
+        if (strstr(rule_fold_label(r), lower_query) != NULL ||
+            strstr(rule_fold_class(r), lower_query) != NULL ||
             strstr(title_re, s->query) != NULL ||
             strstr(tag, s->query) != NULL ||
             strstr(workspace, s->query) != NULL) {
@@ -2363,7 +4248,7 @@ static int search_modal(ui_state_machine_t *sm, struct search_state *s, struct r
             ncplane_printf_yx(n, y + 4, x + 2, "No matches");
         }
 
-        ncplane_printf_yx(n, y + 5, x + 2, "Enter to jump, Esc to close");
+        ncplane_printf_yx(n, y + 5, x + 2, "Enter to jump, Ctrl+A to mark all, Esc to close");
 
         notcurses_cursor_enable(sm->nc, y + 2, x + 10 + (int)strlen(s->query));
         notcurses_render(sm->nc);
@@ -2384,6 +4269,10 @@ static int search_modal(ui_state_machine_t *sm, struct search_state *s, struct r
         } else if (id == NCKEY_ESC) {
             notcurses_cursor_disable(sm->nc);
             return -1;
+        } else if (((id == 'a' || id == 'A') && ncinput_ctrl_p(&ni)) || id == 0x01) {
+            /* caller marks every match */
+            notcurses_cursor_disable(sm->nc);
+            return s->match_count > 0 ? -2 : -1;
         } else if (id == NCKEY_BACKSPACE || id == 127 || id == 8) {
             if (len > 0) {
                 s->query[len - 1] = '\0';
@@ -2400,6 +4289,428 @@ static int search_modal(ui_state_machine_t *sm, struct search_state *s, struct r
     }
 }
 
+/* --- multi-select --- */
+
+static void mark_rule(struct ui_state *st, int idx, int on) {
+    if (!st->rule_marked || idx < 0 || idx >= (int)st->rules.count) return;
+    if (st->rule_marked[idx] == (on != 0)) return;
+    st->rule_marked[idx] = on != 0;
+    if (on) st->marked_count++;
+    else st->marked_count--;
+}
+
+static void clear_marks(struct ui_state *st) {
+    if (st->rule_marked) memset(st->rule_marked, 0, st->rules.count);
+    st->marked_count = 0;
+    st->mark_anchor = -1;
+}
+
+/* single-line text prompt; returns 1 on Enter, 0 on Esc */
+static int prompt_text(ui_state_machine_t *sm, const char *title, const char *label,
+                       char *buf, size_t buf_sz) {
+    struct ncplane *n = sm->std;
+    struct popup_rect p = popup_center(n, 6, 60, 0, 0);
+    int lx = p.x + 2;
+    int vx = lx + (int)strlen(label) + 1;
+    int field_w = p.x + p.w - 3 - vx;
+
+    while (1) {
+        popup_draw(n, p, title);
+        ncplane_printf_yx(n, p.y + 2, lx, "%s", label);
+        size_t len = strlen(buf);
+        int off = (int)len > field_w - 1 ? (int)len - (field_w - 1) : 0;
+        ui_set_color(n, COL_SELECT);
+        ncplane_printf_yx(n, p.y + 2, vx, "%-*.*s", field_w, field_w, buf + off);
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, p.y + 4, lx, "Enter to apply (empty clears), Esc to cancel");
+        ui_reset_color(n);
+
+        notcurses_cursor_enable(sm->nc, p.y + 2, vx + (int)len - off);
+        notcurses_render(sm->nc);
+
+        ncinput ni;
+        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
+        if (id == (uint32_t)-1) continue;
+        if (ni.evtype == NCTYPE_RELEASE) continue;
+
+        if (id == NCKEY_ENTER || id == '\n') {
+            notcurses_cursor_disable(sm->nc);
+            return 1;
+        } else if (id == NCKEY_ESC) {
+            notcurses_cursor_disable(sm->nc);
+            return 0;
+        } else if (id == NCKEY_BACKSPACE || id == 127 || id == 8) {
+            if (len > 0) buf[len - 1] = '\0';
+        } else if (id >= 32 && id < 127 && len < buf_sz - 1) {
+            buf[len] = (char)id;
+            buf[len + 1] = '\0';
+        }
+    }
+}
+
+/* apply one field change to every marked rule as a single undo step.
+ * tag/workspace/float do not affect duplicate or unused status, so no recompute */
+static int bulk_set_field(struct ui_state *st, enum rule_field f, const char *val) {
+    char desc[128];
+    snprintf(desc, sizeof(desc), "Bulk edit %zu rules", st->marked_count);
+    history_begin_batch(&st->history, desc);
+
+    int changed = 0;
+    for (size_t i = 0; i < st->rules.count; i++) {
+        if (!st->rule_marked[i]) continue;
+        struct rule *r = &st->rules.rules[i];
+        struct rule old = rule_copy(r);
+        if (f >= RF_STR_COUNT) rule_set_bool(r, f, val != NULL);
+        else rule_set(r, f, val && val[0] ? val : NULL);
+        history_record(&st->history, CHANGE_EDIT, (int)i, &old, r, desc);
+        rule_free(&old);
+        mark_rule_modified(st, (int)i);
+        changed++;
+    }
+
+    history_end_batch(&st->history);
+    if (changed) st->modified = 1;
+    return changed;
+}
+
+/* delete every marked rule in one compaction pass, one undo step, one status refresh */
+static int bulk_delete(struct ui_state *st, const char *verb) {
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%s %zu rules", verb, st->marked_count);
+    history_begin_batch(&st->history, desc);
+
+    /* highest index first, so the batch also replays correctly one item at a time */
+    int removed = 0;
+    for (size_t i = st->rules.count; i-- > 0;) {
+        if (!st->rule_marked[i]) continue;
+        history_record(&st->history, CHANGE_DELETE, (int)i, &st->rules.rules[i], NULL, desc);
+        removed++;
+    }
+    history_end_batch(&st->history);
+
+    /* compaction only writes at or below the index being read, so the mark array
+     * can double as the drop mask */
+    remove_rules_masked(st, st->rule_marked);
+    st->marked_count = 0;
+    st->mark_anchor = -1;
+    refresh_rule_status(st, NULL);
+
+    if (st->selected >= (int)st->rules.count) st->selected = (int)st->rules.count - 1;
+    if (st->selected < 0) st->selected = 0;
+    if (removed) st->modified = 1;
+    return removed;
+}
+
+static void bulk_disable(struct ui_state *st) {
+    char disabled_path[512];
+    char *expanded = expand_home(st->rules_path);
+    get_disabled_path(expanded ? expanded : st->rules_path, disabled_path, sizeof(disabled_path));
+    free(expanded);
+
+    FILE *df = fopen(disabled_path, "a");
+    if (!df) {
+        set_status(st, "Failed to write to %s", disabled_path);
+        return;
+    }
+    for (size_t i = 0; i < st->rules.count; i++) {
+        if (st->rule_marked[i]) rule_write(df, &st->rules.rules[i]);
+    }
+    fclose(df);
+
+    int n = bulk_delete(st, "Disable");
+    set_status(st, "Disabled %d rule%s -> %s", n, n == 1 ? "" : "s", disabled_path);
+}
+
+/* undo/redo of a CHANGE_BATCH record. batches record their edits first, then
+ * their deletes highest index first, all against the pre-batch indices: redo
+ * applies the edits then drops the deleted rules in one pass; undo re-inserts
+ * the deleted rules in one pass and then restores the edits */
+static void batch_apply_edits(struct ui_state *st, const struct change_record *rec,
+                              int undo, unsigned char *recheck) {
+    for (size_t j = 0; j < rec->item_count; j++) {
+        const struct change_record *it = &rec->items[undo ? rec->item_count - 1 - j : j];
+        int idx = it->rule_index;
+        if (it->type != CHANGE_EDIT || idx < 0 || idx >= (int)st->rules.count) continue;
+        rule_free(&st->rules.rules[idx]);
+        st->rules.rules[idx] = rule_copy(undo ? &it->old_state : &it->new_state);
+        mark_rule_modified(st, idx);
+        if (recheck) recheck[idx] = 1;
+    }
+}
+
+/* a batch of CHANGE_INSERT records (an import), at ascending indices */
+static int apply_insert_batch(struct ui_state *st, const struct change_record *rec, int undo) {
+    size_t k = rec->item_count;
+    if (undo) {
+        unsigned char *drop = calloc(st->rules.count ? st->rules.count : 1, 1);
+        if (!drop) return -1;
+        for (size_t j = 0; j < k; j++) {
+            int idx = rec->items[j].rule_index;
+            if (idx >= 0 && idx < (int)st->rules.count) drop[idx] = 1;
+        }
+        remove_rules_masked(st, drop);
+        free(drop);
+        refresh_rule_status(st, NULL);
+        if (st->selected >= (int)st->rules.count) st->selected = (int)st->rules.count - 1;
+        if (st->selected < 0) st->selected = 0;
+    } else {
+        int *at = malloc(k * sizeof(int));
+        const struct rule **rules = malloc(k * sizeof(*rules));
+        int ok = at && rules;
+        for (size_t j = 0; ok && j < k; j++) {
+            int idx = rec->items[j].rule_index;
+            if (idx > (int)(st->rules.count + j)) idx = (int)(st->rules.count + j);
+            if (j > 0 && idx <= at[j - 1]) idx = at[j - 1] + 1;
+            at[j] = idx;
+            rules[j] = &rec->items[j].new_state;
+        }
+        ok = ok && insert_rules_at(st, at, rules, k) == 0;
+        if (ok) st->selected = at[0];
+        free(rules);
+        if (!ok) {
+            free(at);
+            return -1;
+        }
+        unsigned char *recheck = calloc(st->rules.count, 1);
+        for (size_t j = 0; recheck && j < k; j++) recheck[at[j]] = 1;
+        refresh_rule_status(st, recheck);
+        free(recheck);
+        free(at);
+    }
+    st->edit_gen++;
+    st->modified = 1;
+    return 0;
+}
+
+/* apply a batch record backwards (undo) or forwards; -1 when it ran out of
+ * memory before changing anything */
+static int apply_batch(struct ui_state *st, const struct change_record *rec, int undo) {
+    size_t k = rec->item_count;
+    if (k > 0 && rec->items[0].type == CHANGE_INSERT)
+        return apply_insert_batch(st, rec, undo);
+    size_t ndel = 0;
+    for (size_t j = 0; j < k; j++)
+        if (rec->items[j].type == CHANGE_DELETE) ndel++;
+
+    if (undo) {
+        if (ndel > 0) {
+            /* deletes sit at the end, highest index first; re-insert lowest first */
+            int *at = malloc(ndel * sizeof(int));
+            const struct rule **rules = malloc(ndel * sizeof(*rules));
+            if (!at || !rules) {
+                free(at);
+                free(rules);
+                return -1;
+            }
+            size_t d = 0;
+            for (size_t j = k; j-- > 0;) {
+                const struct change_record *it = &rec->items[j];
+                if (it->type != CHANGE_DELETE) continue;
+                int idx = it->rule_index;
+                if (idx > (int)(st->rules.count + d)) idx = (int)(st->rules.count + d);
+                if (d > 0 && idx <= at[d - 1]) idx = at[d - 1] + 1;
+                at[d] = idx;
+                rules[d] = &it->old_state;
+                d++;
+            }
+            int ok = insert_rules_at(st, at, rules, ndel) == 0;
+            if (ok) st->selected = at[0];
+            free(at);
+            free(rules);
+            if (!ok) return -1;
+        }
+        unsigned char *recheck = calloc(st->rules.count ? st->rules.count : 1, 1);
+        batch_apply_edits(st, rec, 1, recheck);
+        /* re-inserted rules come back as RULE_OK; check them against clients */
+        for (size_t j = 0; recheck && j < k; j++) {
+            int idx = rec->items[j].rule_index;
+            if (rec->items[j].type == CHANGE_DELETE && idx >= 0 && idx < (int)st->rules.count)
+                recheck[idx] = 1;
+        }
+        refresh_rule_status(st, recheck);
+        free(recheck);
+    } else {
+        /* deletes need the mask: fail before anything changes */
+        unsigned char *recheck = calloc(st->rules.count ? st->rules.count : 1, 1);
+        if (!recheck && ndel > 0) return -1;
+        batch_apply_edits(st, rec, 0, recheck);
+        if (ndel > 0) {
+            /* batch edits never touch labels or match fields, so the mask can be
+             * reused as the drop mask and a duplicate recount is enough */
+            memset(recheck, 0, st->rules.count);
+            for (size_t j = 0; j < k; j++) {
+                int idx = rec->items[j].rule_index;
+                if (rec->items[j].type == CHANGE_DELETE && idx >= 0 && idx < (int)st->rules.count)
+                    recheck[idx] = 1;
+            }
+            remove_rules_masked(st, recheck);
+            refresh_rule_status(st, NULL);
+        } else {
+            refresh_rule_status(st, recheck);
+        }
+        free(recheck);
+        if (st->selected >= (int)st->rules.count) st->selected = (int)st->rules.count - 1;
+        if (st->selected < 0) st->selected = 0;
+    }
+    st->modified = 1;
+    return 0;
+}
+
+static void bulk_actions_popup(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    struct ncplane *n = sm->std;
+
+    static const struct {
+        char key;
+        const char *label;
+    } items[] = {
+        {'t', "Set tag"},
+        {'w', "Set workspace"},
+        {'f', "Toggle float"},
+        {'d', "Delete"},
+        {'x', "Disable (move to .disabled file)"},
+    };
+    int count = (int)(sizeof(items) / sizeof(items[0]));
+    int choice = 0;
+    struct popup_rect p = popup_center(n, count + 5, 46, 0, 0);
+
+    char title[64];
+    snprintf(title, sizeof(title), "Bulk Actions (%zu marked)", st->marked_count);
+
+    char key = 0;
+    while (!key) {
+        popup_draw(n, p, title);
+        for (int i = 0; i < count; i++) {
+            ui_set_color(n, i == choice ? COL_SELECT : COL_NORMAL);
+            ncplane_printf_yx(n, p.y + 2 + i, p.x + 3, " %c  %-*s", items[i].key, p.w - 10, items[i].label);
+            ui_reset_color(n);
+        }
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, p.y + p.h - 1, p.x + 3, " Enter:Run  Esc:Cancel ");
+        ui_reset_color(n);
+        notcurses_render(sm->nc);
+
+        ncinput ni;
+        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
+        if (id == (uint32_t)-1) continue;
+        if (ni.evtype == NCTYPE_RELEASE) continue;
+
+        if (id == NCKEY_ESC) return;
+        if (id == NCKEY_UP && choice > 0) choice--;
+        else if (id == NCKEY_DOWN && choice < count - 1) choice++;
+        else if (id == NCKEY_ENTER || id == '\n') key = items[choice].key;
+        else {
+            for (int i = 0; i < count; i++)
+                if (id == (uint32_t)items[i].key) key = items[i].key;
+        }
+    }
+
+    char buf[128] = "";
+    char msg[64];
+    int changed;
+    switch (key) {
+    case 't':
+    case 'w':
+        if (!prompt_text(sm, key == 't' ? "Set Tag" : "Set Workspace",
+                         key == 't' ? "Tag:" : "Workspace:", buf, sizeof(buf)))
+            return;
+        changed = bulk_set_field(st, key == 't' ? RF_TAG : RF_WORKSPACE, buf);
+        set_status(st, "Updated %d rule%s (not saved to file)", changed, changed == 1 ? "" : "s");
+        break;
+    case 'f': {
+        /* float everything unless all marked rules already float */
+        int all_float = 1;
+        for (size_t i = 0; i < st->rules.count && all_float; i++)
+            if (st->rule_marked[i] && !rule_get_bool(&st->rules.rules[i], RF_FLOAT)) all_float = 0;
+        changed = bulk_set_field(st, RF_FLOAT, all_float ? NULL : "1");
+        set_status(st, "Float %s on %d rule%s (not saved to file)", all_float ? "off" : "on",
+                   changed, changed == 1 ? "" : "s");
+        break;
+    }
+    case 'd':
+        snprintf(msg, sizeof(msg), "Delete %zu marked rules?", st->marked_count);
+        if (confirm_dialog(sm, "Delete Rules", msg)) {
+            changed = bulk_delete(st, "Delete");
+            set_status(st, "Deleted %d rule%s (not saved to file)", changed, changed == 1 ? "" : "s");
+        }
+        break;
+    case 'x':
+        snprintf(msg, sizeof(msg), "Disable %zu marked rules?", st->marked_count);
+        if (confirm_dialog(sm, "Disable Rules", msg)) bulk_disable(st);
+        break;
+    }
+}
+
+/* --- apply to open windows --- */
+
+/* push the marked rules (or the selected one) onto the windows they already
+ * match, as a single [[BATCH]] request on the Hyprland command socket */
+static void apply_rules_live(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    if (st->rules.count == 0) return;
+
+    size_t n = st->marked_count > 0 ? st->marked_count : 1;
+    int *idx = malloc(n * sizeof(int));
+    if (!idx) return;
+    if (st->marked_count > 0) {
+        size_t k = 0;
+        for (size_t i = 0; i < st->rules.count && k < n; i++)
+            if (st->rule_marked[i]) idx[k++] = (int)i;
+        n = k;
+    } else {
+        idx[0] = st->selected;
+    }
+
+    /* later rules win, as in the config */
+    sort_ctx = st;
+    qsort(idx, n, sizeof(int), compare_idx_by_file_order);
+    sort_ctx = NULL;
+
+    struct clients cl;
+    if (hyprctl_clients(&cl) != 0) {
+        free(idx);
+        set_status(st, "Failed to query open windows");
+        return;
+    }
+
+    struct live_apply la;
+    int rc = live_apply_build(&st->rules, idx, n, &cl, &la);
+    clients_free(&cl);
+    free(idx);
+    if (rc != 0) {
+        set_status(st, "Out of memory building dispatch batch");
+        return;
+    }
+    if (la.commands == 0) {
+        set_status(st, "No open windows match (or nothing to apply)");
+        live_apply_free(&la);
+        return;
+    }
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Apply %zu rule%s to %zu window%s (%zu commands)?",
+             n, n == 1 ? "" : "s", la.windows, la.windows == 1 ? "" : "s", la.commands);
+    if (!confirm_dialog(sm, "Apply To Open Windows", msg)) {
+        live_apply_free(&la);
+        return;
+    }
+
+    char *reply = NULL;
+    if (hyprctl_request(NULL, la.request, &reply) != 0) {
+        set_status(st, "Could not reach the Hyprland socket");
+    } else {
+        size_t failed = live_apply_failures(reply, la.commands);
+        if (failed)
+            set_status(st, "Applied to %zu windows, %zu of %zu commands failed",
+                       la.windows, failed, la.commands);
+        else
+            set_status(st, "Applied to %zu window%s (%zu commands)",
+                       la.windows, la.windows == 1 ? "" : "s", la.commands);
+    }
+    free(reply);
+    live_apply_free(&la);
+}
+
 /* --- threaded spinner --- */
 
 struct spinner_work {
@@ -2485,6 +4796,84 @@ static void run_with_spinner(ui_state_machine_t *sm, const char *msg,
     notcurses_render(sm->nc);
 }
 
+/* --- startup loading --- */
+
+/*
+ * Rules (parse, hyprctl clients, status, sort) and the app scan (appmap,
+ * pacman, dotfiles) are independent, so both start on their own thread
+ * before the splash is drawn and run while the logo is on screen.
+ * The app scan fills a private missing_rules that is handed over on finish.
+ */
+struct startup_load {
+    struct ui_state *st;
+    struct missing_rules missing;
+    struct appmap appmap;
+    pthread_t rules_tid, apps_tid;
+    int rules_started, apps_started;
+    int rules_done, apps_done;  /* release-stored by the workers */
+};
+
+static int startup_rules_done(const struct startup_load *sl) {
+    return __atomic_load_n(&sl->rules_done, __ATOMIC_ACQUIRE);
+}
+
+static int startup_apps_done(const struct startup_load *sl) {
+    return __atomic_load_n(&sl->apps_done, __ATOMIC_ACQUIRE);
+}
+
+static void *startup_rules_fn(void *arg) {
+    struct startup_load *sl = arg;
+    load_rules(sl->st);
+    __atomic_store_n(&sl->rules_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *startup_apps_fn(void *arg) {
+    struct startup_load *sl = arg;
+    struct ui_state *st = sl->st;
+    char *path = expand_home(st->rules_path);
+    char *appmap_path = expand_home(st->appmap_path);
+    find_missing_rules(path ? path : st->rules_path,
+                       appmap_path ? appmap_path : st->appmap_path,
+                       st->dotfiles_path, &sl->missing);
+    appmap_load(appmap_path ? appmap_path : st->appmap_path, &sl->appmap);
+    free(appmap_path);
+    free(path);
+    __atomic_store_n(&sl->apps_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void startup_load_begin(struct startup_load *sl, struct ui_state *st) {
+    memset(sl, 0, sizeof(*sl));
+    sl->st = st;
+    sl->rules_started = pthread_create(&sl->rules_tid, NULL, startup_rules_fn, sl) == 0;
+    if (!sl->rules_started) startup_rules_fn(sl);
+    sl->apps_started = pthread_create(&sl->apps_tid, NULL, startup_apps_fn, sl) == 0;
+    if (!sl->apps_started) startup_apps_fn(sl);
+}
+
+static int startup_load_done(const struct startup_load *sl) {
+    return startup_rules_done(sl) && startup_apps_done(sl);
+}
+
+/* wait for both workers and install the review data */
+static void startup_load_finish(struct startup_load *sl) {
+    if (sl->rules_started) pthread_join(sl->rules_tid, NULL);
+    if (sl->apps_started) pthread_join(sl->apps_tid, NULL);
+
+    struct ui_state *st = sl->st;
+    missing_rules_free(&st->missing);
+    st->missing = sl->missing;
+    st->status_gen++;
+    memset(&sl->missing, 0, sizeof(sl->missing));
+    appmap_free(&st->appmap);
+    st->appmap = sl->appmap;
+    memset(&sl->appmap, 0, sizeof(sl->appmap));
+    if (!st->rule_status && st->rules.count > 0)
+        compute_rule_status(st);
+    st->review_loaded = 1;
+}
+
 /* --- splash screen --- */
 
 static const char *splash_logo[] = {
@@ -2527,7 +4916,11 @@ static const struct action_item actions_list[] = {
     {"Merge duplicate rules",
      "Combines rules with identical match fields into one, merging their actions."},
     {"Reload Hyprland config",
-     "Runs 'hyprctl reload' to apply saved window rules."},
+     "Reloads over Hyprland's socket and marks rules named in config errors."},
+    {"Compare with a backup or another file",
+     "Shows rules added, removed, moved or changed relative to another rules file."},
+    {"Import rules from JSON",
+     "Appends the rules in a file written by 'hyprwindows export --json'."},
 };
 #define ACTIONS_COUNT ((int)(sizeof(actions_list) / sizeof(actions_list[0])))
 
@@ -2543,8 +4936,8 @@ static void action_bulk_rename(ui_state_machine_t *sm) {
     for (size_t i = 0; i < st->rules.count; i++) {
         struct rule *r = &st->rules.rules[i];
         update_display_name(r);
-        if (!r->display_name) continue;
-        if (!r->name || strcmp(r->name, r->display_name) != 0)
+        if (!rule_get(r, RF_DISPLAY_NAME)) continue;
+        if (!rule_get(r, RF_NAME) || strcmp(rule_get(r, RF_NAME), rule_get(r, RF_DISPLAY_NAME)) != 0)
             would_change++;
     }
 
@@ -2558,8 +4951,8 @@ static void action_bulk_rename(ui_state_machine_t *sm) {
     int ci = 0;
     for (size_t i = 0; i < st->rules.count; i++) {
         struct rule *r = &st->rules.rules[i];
-        if (!r->display_name) continue;
-        if (!r->name || strcmp(r->name, r->display_name) != 0)
+        if (!rule_get(r, RF_DISPLAY_NAME)) continue;
+        if (!rule_get(r, RF_NAME) || strcmp(rule_get(r, RF_NAME), rule_get(r, RF_DISPLAY_NAME)) != 0)
             change_idx[ci++] = (int)i;
     }
 
@@ -2597,8 +4990,8 @@ static void action_bulk_rename(ui_state_machine_t *sm) {
         for (int i = 0; i < visible && scroll + i < would_change; i++) {
             int ri = change_idx[scroll + i];
             struct rule *r = &st->rules.rules[ri];
-            const char *old_name = r->name ? r->name : "(none)";
-            const char *new_name = r->display_name;
+            const char *old_name = rule_get_or(r, RF_NAME, "(none)");
+            const char *new_name = rule_get(r, RF_DISPLAY_NAME);
 
             ui_set_color(n, COL_WARN);
             ncplane_printf_yx(n, row + i, lx, "%-*.*s", half, half, old_name);
@@ -2660,9 +5053,8 @@ static void action_bulk_rename(ui_state_machine_t *sm) {
             for (int i = 0; i < would_change; i++) {
                 int ri = change_idx[i];
                 struct rule *r = &st->rules.rules[ri];
-                free(r->name);
-                r->name = strdup(r->display_name);
-                st->rule_modified[ri] = 1;
+                rule_set(r, RF_NAME, rule_get(r, RF_DISPLAY_NAME));
+                mark_rule_modified(st, ri);
                 renamed++;
             }
             st->modified = 1;
@@ -2676,24 +5068,17 @@ static void action_bulk_rename(ui_state_machine_t *sm) {
 
 /* merge actions from src into dst, keeping dst's values where both are set */
 static void merge_rule_actions(struct rule *dst, const struct rule *src) {
-    if (!dst->actions.tag && src->actions.tag)
-        dst->actions.tag = strdup(src->actions.tag);
-    if (!dst->actions.workspace && src->actions.workspace)
-        dst->actions.workspace = strdup(src->actions.workspace);
-    if (!dst->actions.opacity && src->actions.opacity)
-        dst->actions.opacity = strdup(src->actions.opacity);
-    if (!dst->actions.size && src->actions.size)
-        dst->actions.size = strdup(src->actions.size);
-    if (!dst->actions.move && src->actions.move)
-        dst->actions.move = strdup(src->actions.move);
-    if (!dst->actions.float_set && src->actions.float_set) {
-        dst->actions.float_set = 1;
-        dst->actions.float_val = src->actions.float_val;
-    }
-    if (!dst->actions.center_set && src->actions.center_set) {
-        dst->actions.center_set = 1;
-        dst->actions.center_val = src->actions.center_val;
+    static const enum rule_field fields[] = {
+        RF_TAG, RF_WORKSPACE, RF_OPACITY, RF_SIZE, RF_MOVE,
+    };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        if (!rule_has(dst, fields[i]) && rule_has(src, fields[i]))
+            rule_set(dst, fields[i], rule_get(src, fields[i]));
     }
+    if (!rule_has(dst, RF_FLOAT) && rule_has(src, RF_FLOAT))
+        rule_set_bool(dst, RF_FLOAT, rule_get_bool(src, RF_FLOAT));
+    if (!rule_has(dst, RF_CENTER) && rule_has(src, RF_CENTER))
+        rule_set_bool(dst, RF_CENTER, rule_get_bool(src, RF_CENTER));
     /* merge extras that dst doesn't already have */
     for (size_t i = 0; i < src->extras_count; i++) {
         int found = 0;
@@ -2716,65 +5101,200 @@ static void merge_rule_actions(struct rule *dst, const struct rule *src) {
     }
 }
 
-struct dup_group {
-    int *indices;
-    int count;
+/* duplicate groups, planned in linear time from a label hash.
+ * members holds the rule indices of group g at [start[g], start[g + 1]),
+ * ascending, so the first member is the rule that is kept */
+struct dup_plan {
+    int *members;
+    int *start;
+    int ngroups;
+    int total;
 };
 
-static void action_merge_duplicates(ui_state_machine_t *sm) {
-    struct ui_state *st = sm->st;
-    struct ncplane *n = sm->std;
-    unsigned scr_h, scr_w;
-    ncplane_dim_yx(n, &scr_h, &scr_w);
+static void dup_plan_free(struct dup_plan *plan) {
+    free(plan->members);
+    free(plan->start);
+    memset(plan, 0, sizeof(*plan));
+}
 
-    if (!st->rule_status) {
-        set_status(st, "No review data — switch to Review tab first");
-        return;
+static int dup_plan_build(struct ui_state *st, struct dup_plan *plan) {
+    memset(plan, 0, sizeof(*plan));
+    size_t n = st->rules.count;
+    size_t mask;
+    struct label_count *tab = count_labels(st, NULL, &mask);
+    int *gid = malloc((n ? n : 1) * sizeof(int));
+    int *sizes = NULL;
+    if (!tab || !gid) goto fail;
+
+    /* groups are numbered by their first rule */
+    int cap = 0;
+    for (size_t i = 0; i < n; i++) {
+        gid[i] = -1;
+        const char *label = rule_label_or(&st->rules.rules[i], NULL);
+        if (!label) continue;
+        struct label_count *lc = label_slot(tab, mask, label);
+        if (lc->count < 2) continue;
+        if (lc->group == 0) {
+            if (plan->ngroups == cap) {
+                cap = cap ? cap * 2 : 64;
+                int *tmp = realloc(sizes, (size_t)cap * sizeof(int));
+                if (!tmp) goto fail;
+                sizes = tmp;
+            }
+            sizes[plan->ngroups] = lc->count;
+            lc->group = ++plan->ngroups;
+            plan->total += lc->count;
+        }
+        gid[i] = lc->group - 1;
     }
 
-    /* find duplicate groups */
-    int *visited = calloc(st->rules.count, sizeof(int));
-    if (!visited) return;
+    plan->start = malloc((size_t)(plan->ngroups + 1) * sizeof(int));
+    plan->members = malloc((size_t)(plan->total ? plan->total : 1) * sizeof(int));
+    if (!plan->start || !plan->members) goto fail;
+    plan->start[0] = 0;
+    for (int g = 0; g < plan->ngroups; g++) {
+        plan->start[g + 1] = plan->start[g] + sizes[g];
+        sizes[g] = plan->start[g]; /* reuse as fill cursor */
+    }
+    for (size_t i = 0; i < n; i++)
+        if (gid[i] >= 0) plan->members[sizes[gid[i]]++] = (int)i;
 
-    struct dup_group *groups = NULL;
-    int ngroups = 0;
+    free(tab);
+    free(gid);
+    free(sizes);
+    return 0;
 
-    for (size_t i = 0; i < st->rules.count; i++) {
-        if (visited[i] || st->rule_status[i] != RULE_DUPLICATE) continue;
-        visited[i] = 1;
+fail:
+    free(tab);
+    free(gid);
+    free(sizes);
+    dup_plan_free(plan);
+    return -1;
+}
 
-        /* start a new group */
-        struct dup_group g = {0};
-        g.indices = malloc(st->rules.count * sizeof(int));
-        if (!g.indices) { free(visited); return; }
-        g.indices[0] = (int)i;
-        g.count = 1;
+/* preview lines are never materialized: group g is a header, one line per
+ * member and a blank line, starting at line start[g] + 2g */
+static int dup_plan_line_group(const struct dup_plan *plan, int line) {
+    int lo = 0, hi = plan->ngroups - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (plan->start[mid] + 2 * mid <= line) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
 
-        for (size_t j = i + 1; j < st->rules.count; j++) {
-            if (visited[j]) continue;
-            if (rules_duplicate(&st->rules.rules[i], &st->rules.rules[j])) {
-                visited[j] = 1;
-                g.indices[g.count++] = (int)j;
-            }
+/* format preview line `line`; returns 0=normal, 1=header, 2=keep, 3=remove */
+static int dup_plan_format_line(struct ui_state *st, const struct dup_plan *plan, int line,
+                                char *buf, size_t buf_sz, int content_w) {
+    int g = dup_plan_line_group(plan, line);
+    int count = plan->start[g + 1] - plan->start[g];
+    int off = line - (plan->start[g] + 2 * g);
+
+    if (off == 0) {
+        struct rule *first = &st->rules.rules[plan->members[plan->start[g]]];
+        const char *match_str = rule_get_or(first, RF_CLASS, rule_get_or(first, RF_TITLE, "?"));
+        snprintf(buf, buf_sz, "Group %d: %.*s (%d rules)", g + 1, content_w - 20, match_str, count);
+        return 1;
+    }
+    if (off > count) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    int r = off - 1;
+    int ri = plan->members[plan->start[g] + r];
+    struct rule *rule = &st->rules.rules[ri];
+    /* summarize actions */
+    char acts[200] = "";
+    int alen = 0;
+    if (rule_get(rule, RF_TAG))
+        alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "tag:%s ", rule_get(rule, RF_TAG));
+    if (rule_get(rule, RF_WORKSPACE))
+        alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "ws:%s ", rule_get(rule, RF_WORKSPACE));
+    if (rule_has(rule, RF_FLOAT))
+        alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "float:%s ", rule_get_bool(rule, RF_FLOAT) ? "on" : "off");
+    if (rule_get(rule, RF_OPACITY))
+        alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "opacity:%s ", rule_get(rule, RF_OPACITY));
+    if (rule_get(rule, RF_SIZE))
+        alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "size:%s ", rule_get(rule, RF_SIZE));
+    if (rule_has(rule, RF_CENTER))
+        alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "center:%s ", rule_get_bool(rule, RF_CENTER) ? "on" : "off");
+    for (size_t e = 0; e < rule->extras_count && alen < (int)sizeof(acts) - 20; e++)
+        alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "%s:%s ", rule->extras[e].key, rule->extras[e].value);
+    if (alen == 0) snprintf(acts, sizeof(acts), "(no actions)");
+
+    snprintf(buf, buf_sz, "  %-5s #%d %-12.*s  %.*s", r == 0 ? "KEEP" : "MERGE",
+             ri + 1, 12, rule_label_or(rule, ""), content_w - 30, acts);
+    return r == 0 ? 2 : 3;
+}
+
+/* merge every group into its first rule and drop the rest in one compaction
+ * pass, recorded as a single undo step; returns the number of rules removed */
+static int dup_plan_apply(struct ui_state *st, const struct dup_plan *plan) {
+    unsigned char *drop = calloc(st->rules.count ? st->rules.count : 1, 1);
+    if (!drop) return 0;
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "Merge %d duplicate group%s", plan->ngroups,
+             plan->ngroups == 1 ? "" : "s");
+    history_begin_batch(&st->history, desc);
+
+    for (int g = 0; g < plan->ngroups; g++) {
+        int keep = plan->members[plan->start[g]];
+        struct rule old = rule_copy(&st->rules.rules[keep]);
+        for (int m = plan->start[g] + 1; m < plan->start[g + 1]; m++) {
+            merge_rule_actions(&st->rules.rules[keep], &st->rules.rules[plan->members[m]]);
+            drop[plan->members[m]] = 1;
         }
+        history_record(&st->history, CHANGE_EDIT, keep, &old, &st->rules.rules[keep], desc);
+        rule_free(&old);
+        mark_rule_modified(st, keep);
+    }
+
+    /* deletes go last, highest index first (see apply_batch) */
+    int removed = 0;
+    for (size_t i = st->rules.count; i-- > 0;) {
+        if (!drop[i]) continue;
+        history_record(&st->history, CHANGE_DELETE, (int)i, &st->rules.rules[i], NULL, desc);
+        removed++;
+    }
+    history_end_batch(&st->history);
+
+    remove_rules_masked(st, drop);
+    free(drop);
+    refresh_rule_status(st, NULL);
+    if (st->selected >= (int)st->rules.count) st->selected = (int)st->rules.count - 1;
+    if (st->selected < 0) st->selected = 0;
+    st->modified = 1;
+    return removed;
+}
+
+static void action_merge_duplicates(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    struct ncplane *n = sm->std;
+    unsigned scr_h, scr_w;
+    ncplane_dim_yx(n, &scr_h, &scr_w);
 
-        struct dup_group *tmp = realloc(groups, (size_t)(ngroups + 1) * sizeof(struct dup_group));
-        if (!tmp) { free(g.indices); break; }
-        groups = tmp;
-        groups[ngroups++] = g;
+    if (!st->rule_status) {
+        set_status(st, "No review data — switch to Review tab first");
+        return;
     }
-    free(visited);
 
-    if (ngroups == 0) {
+    struct dup_plan plan;
+    if (dup_plan_build(st, &plan) != 0) {
+        set_status(st, "Out of memory planning merge");
+        return;
+    }
+    if (plan.ngroups == 0) {
         set_status(st, "No duplicate rules found");
-        free(groups);
+        dup_plan_free(&plan);
         return;
     }
 
-    /* count total rules that will be removed */
-    int total_removed = 0;
-    for (int g = 0; g < ngroups; g++)
-        total_removed += groups[g].count - 1;
+    int ngroups = plan.ngroups;
+    int total_removed = plan.total - ngroups;
+    int nlines = plan.total + 2 * ngroups;
 
     /* scrollable preview popup */
     int scroll = 0;
@@ -2786,76 +5306,6 @@ static void action_merge_duplicates(ui_state_machine_t *sm) {
     int content_w = p.w - 4;
     int visible = p.h - 5;
 
-    /* build preview lines */
-    /* each group: header + one line per rule showing its unique actions */
-    int nlines = 0;
-    for (int g = 0; g < ngroups; g++)
-        nlines += 1 + groups[g].count + 1; /* header + rules + blank */
-
-    char **lines = calloc((size_t)nlines, sizeof(char *));
-    int *line_colors = calloc((size_t)nlines, sizeof(int)); /* 0=normal, 1=header, 2=keep, 3=remove */
-    if (!lines || !line_colors) {
-        free(lines); free(line_colors);
-        for (int g = 0; g < ngroups; g++) free(groups[g].indices);
-        free(groups);
-        return;
-    }
-
-    int li = 0;
-    for (int g = 0; g < ngroups; g++) {
-        struct rule *first = &st->rules.rules[groups[g].indices[0]];
-        const char *match_str = first->match.class_re ? first->match.class_re :
-                                first->match.title_re ? first->match.title_re : "?";
-        lines[li] = malloc(256);
-        if (lines[li])
-            snprintf(lines[li], 256, "Group %d: %.*s (%d rules)",
-                     g + 1, content_w - 20, match_str, groups[g].count);
-        line_colors[li] = 1;
-        li++;
-
-        for (int r = 0; r < groups[g].count; r++) {
-            int ri = groups[g].indices[r];
-            struct rule *rule = &st->rules.rules[ri];
-            /* summarize actions */
-            char acts[200] = "";
-            int alen = 0;
-            if (rule->actions.tag)
-                alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "tag:%s ", rule->actions.tag);
-            if (rule->actions.workspace)
-                alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "ws:%s ", rule->actions.workspace);
-            if (rule->actions.float_set)
-                alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "float:%s ", rule->actions.float_val ? "on" : "off");
-            if (rule->actions.opacity)
-                alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "opacity:%s ", rule->actions.opacity);
-            if (rule->actions.size)
-                alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "size:%s ", rule->actions.size);
-            if (rule->actions.center_set)
-                alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "center:%s ", rule->actions.center_val ? "on" : "off");
-            for (size_t e = 0; e < rule->extras_count && alen < (int)sizeof(acts) - 20; e++)
-                alen += snprintf(acts + alen, sizeof(acts) - (size_t)alen, "%s:%s ", rule->extras[e].key, rule->extras[e].value);
-            if (alen == 0) snprintf(acts, sizeof(acts), "(no actions)");
-
-            const char *rname = rule->display_name ? rule->display_name :
-                                rule->name ? rule->name : "";
-            lines[li] = malloc(512);
-            if (lines[li]) {
-                if (r == 0)
-                    snprintf(lines[li], 512, "  KEEP  #%d %-12.*s  %.*s",
-                             ri + 1, 12, rname, content_w - 30, acts);
-                else
-                    snprintf(lines[li], 512, "  MERGE #%d %-12.*s  %.*s",
-                             ri + 1, 12, rname, content_w - 30, acts);
-            }
-            line_colors[li] = (r == 0) ? 2 : 3;
-            li++;
-        }
-
-        lines[li] = strdup("");
-        line_colors[li] = 0;
-        li++;
-    }
-    nlines = li;
-
     while (1) {
         char title[64];
         snprintf(title, sizeof(title), "Merge Duplicates (%d group%s, %d removed)",
@@ -2865,10 +5315,10 @@ static void action_merge_duplicates(ui_state_machine_t *sm) {
         int lx = p.x + 2;
         int row = p.y + 2;
 
+        /* only the visible lines are formatted */
         for (int i = 0; i < visible && scroll + i < nlines; i++) {
-            const char *line = lines[scroll + i];
-            if (!line) continue;
-            int color = line_colors[scroll + i];
+            char line[512];
+            int color = dup_plan_format_line(st, &plan, scroll + i, line, sizeof(line), content_w);
             if (color == 1) {
                 ncplane_on_styles(n, NCSTYLE_BOLD);
                 ui_set_color(n, COL_ACCENT);
@@ -2908,7 +5358,7 @@ static void action_merge_duplicates(ui_state_machine_t *sm) {
 
         if (id == NCKEY_ESC || id == 'q') {
             set_status(st, "Merge cancelled");
-            goto cleanup;
+            break;
         }
         if (id == NCKEY_UP || id == NCKEY_SCROLL_UP) {
             if (scroll > 0) scroll--;
@@ -2926,38 +5376,40 @@ static void action_merge_duplicates(ui_state_machine_t *sm) {
             if (scroll < 0) scroll = 0;
         }
         else if (id == NCKEY_ENTER || id == '\n') {
-            /* perform merges — process groups in reverse to keep indices valid */
-            int merged = 0;
-            for (int g = ngroups - 1; g >= 0; g--) {
-                int keep = groups[g].indices[0];
-                /* merge actions from all others into the kept rule */
-                for (int r = 1; r < groups[g].count; r++) {
-                    int ri = groups[g].indices[r];
-                    merge_rule_actions(&st->rules.rules[keep], &st->rules.rules[ri]);
-                }
-                /* delete merged-away rules in reverse order */
-                for (int r = groups[g].count - 1; r >= 1; r--) {
-                    int ri = groups[g].indices[r];
-                    remove_rule_at(st, ri);
-                    merged++;
-                }
-                if (st->rule_modified) st->rule_modified[keep] = 1;
-            }
-            st->modified = 1;
-            compute_rule_status(st);
+            int merged = dup_plan_apply(st, &plan);
             set_status(st, "Merged %d duplicate%s (%d rule%s removed)",
                        ngroups, ngroups == 1 ? "" : "s",
                        merged, merged == 1 ? "" : "s");
-            goto cleanup;
+            break;
         }
     }
 
-cleanup:
-    for (int i = 0; i < nlines; i++) free(lines[i]);
-    free(lines);
-    free(line_colors);
-    for (int g = 0; g < ngroups; g++) free(groups[g].indices);
-    free(groups);
+    dup_plan_free(&plan);
+}
+
+/* flag every rule whose source span contains a reported error line;
+ * returns the number of errors that landed on a rule */
+static int map_config_errors(struct ui_state *st) {
+    for (size_t i = 0; i < st->rules.count; i++)
+        st->rules.rules[i].flags &= (uint8_t)~RULE_F_BROKEN;
+
+    char *expanded = expand_home(st->rules_path);
+    const char *path = expanded ? expanded : st->rules_path;
+    int mapped = 0;
+    for (size_t e = 0; e < st->cfg_errors.count; e++) {
+        const struct config_error *ce = &st->cfg_errors.items[e];
+        if (!config_error_in_rules(ce, path)) continue;
+        for (size_t i = 0; i < st->rules.count; i++) {
+            struct rule *r = &st->rules.rules[i];
+            if (r->src_line && (uint32_t)ce->line >= r->src_line && (uint32_t)ce->line <= r->src_end) {
+                r->flags |= RULE_F_BROKEN;
+                mapped++;
+                break;
+            }
+        }
+    }
+    free(expanded);
+    return mapped;
 }
 
 static void action_hyprctl_reload(ui_state_machine_t *sm) {
@@ -2969,24 +5421,341 @@ static void action_hyprctl_reload(ui_state_machine_t *sm) {
             return;
         }
         if (!st->backup_created) create_backup(st);
-        if (save_rules(st) == 0) {
-            set_status(st, "Saved %zu rules", st->rules.count);
+        if (save_rules_merged(sm) != 0) return;
+    }
+
+    /* reload and validate over the command socket; fall back to hyprctl
+     * when the socket is not reachable */
+    char sock[256];
+    if (hyprctl_socket_path(sock, sizeof(sock)) != 0) {
+        int rc = system("hyprctl reload > /dev/null 2>&1");
+        if (rc == 0) {
+            set_status(st, "Hyprland config reloaded");
         } else {
-            set_status(st, "Failed to save rules");
-            return;
+            set_status(st, "hyprctl reload failed (exit %d)", rc);
         }
+        return;
     }
 
-    int rc = system("hyprctl reload > /dev/null 2>&1");
-    if (rc == 0) {
-        set_status(st, "Hyprland config reloaded");
-    } else {
-        set_status(st, "hyprctl reload failed (exit %d)", rc);
+    if (hyprctl_reload(sock) != 0) {
+        set_status(st, "Hyprland reload failed");
+        return;
+    }
+
+    config_errors_free(&st->cfg_errors);
+    if (hyprctl_config_errors(sock, &st->cfg_errors) != 0) {
+        set_status(st, "Hyprland config reloaded (could not fetch config errors)");
+        return;
+    }
+
+    int mapped = map_config_errors(st);
+    if (st->cfg_errors.count == 0)
+        set_status(st, "Hyprland config reloaded, no errors");
+    else if (mapped > 0)
+        set_status(st, "Reloaded with %zu error%s, %d in rules: %s", st->cfg_errors.count,
+                   st->cfg_errors.count == 1 ? "" : "s", mapped, st->cfg_errors.items[0].message);
+    else
+        set_status(st, "Reloaded with %zu error%s outside the rules file: %s", st->cfg_errors.count,
+                   st->cfg_errors.count == 1 ? "" : "s", st->cfg_errors.items[0].message);
+}
+
+/* newest "<rules>.backup_*" next to the rules file; 0 if there is none */
+static int find_latest_backup(const struct ui_state *st, char *out, size_t out_sz) {
+    char *expanded = expand_home(st->rules_path);
+    const char *path = expanded ? expanded : st->rules_path;
+    const char *slash = strrchr(path, '/');
+    const char *base = slash ? slash + 1 : path;
+    const char *dot = strrchr(base, '.');
+    size_t stem = dot ? (size_t)(dot - base) : strlen(base);
+
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%.*s", slash ? (int)(slash - path) : 1, slash ? path : ".");
+    char best[256] = "";
+    DIR *d = opendir(dir);
+    if (d) {
+        struct dirent *de;
+        while ((de = readdir(d)) != NULL) {
+            /* timestamps sort lexically, so the largest name is the newest */
+            if (strncmp(de->d_name, base, stem) == 0 &&
+                strncmp(de->d_name + stem, ".backup_", 8) == 0 &&
+                strcmp(de->d_name, best) > 0)
+                snprintf(best, sizeof(best), "%s", de->d_name);
+        }
+        closedir(d);
+    }
+    if (best[0]) snprintf(out, out_sz, "%s/%s", dir, best);
+    free(expanded);
+    return best[0] != 0;
+}
+
+static void action_diff_file(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    struct ncplane *n = sm->std;
+
+    char other[1024] = "";
+    if (!find_latest_backup(st, other, sizeof(other)) && st->backup_path[0])
+        snprintf(other, sizeof(other), "%s", st->backup_path);
+    if (!prompt_text(sm, "Compare Rules", "File:", other, sizeof(other)) || !other[0])
+        return;
+
+    char *expanded = expand_home(other);
+    struct ruleset theirs = {0};
+    int rc = ruleset_load(expanded ? expanded : other, &theirs);
+    free(expanded);
+    if (rc != 0) {
+        set_status(st, "Failed to load rules from %s", other);
+        return;
+    }
+
+    /* compare against the rules in file order, not the current sort */
+    size_t count = st->rules.count;
+    int *idx = malloc((count ? count : 1) * sizeof(int));
+    struct ruleset mine = {malloc((count ? count : 1) * sizeof(struct rule)), count};
+    struct rule_diff d = {0};
+    int *lines = NULL;
+    if (!idx || !mine.rules) goto oom;
+    for (size_t i = 0; i < count; i++) idx[i] = (int)i;
+    sort_ctx = st;
+    qsort(idx, count, sizeof(int), compare_idx_by_file_order);
+    sort_ctx = NULL;
+    for (size_t i = 0; i < count; i++) mine.rules[i] = st->rules.rules[idx[i]];
+
+    if (rule_diff(&theirs, &mine, &d) != 0) goto oom;
+    lines = malloc((d.count ? d.count : 1) * sizeof(int));
+    if (!lines) goto oom;
+    int nlines = 0;
+    for (size_t i = 0; i < d.count; i++)
+        if (d.entries[i].op != DIFF_KEPT || d.entries[i].changed) lines[nlines++] = (int)i;
+    if (nlines == 0) {
+        set_status(st, "No differences from %s", other);
+        goto out;
+    }
+
+    unsigned scr_h, scr_w;
+    ncplane_dim_yx(n, &scr_h, &scr_w);
+    struct popup_rect p = popup_center(n, (int)scr_h - 4, (int)scr_w - 8, 2, 2);
+    int content_w = p.w - 4;
+    int visible = p.h - 5;
+    int scroll = 0;
+
+    while (1) {
+        popup_draw(n, p, "Compare Rules");
+
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, p.y + 1, p.x + 2, "%.*s", content_w, other);
+        ui_reset_color(n);
+
+        /* only the visible lines are formatted */
+        for (int i = 0; i < visible && scroll + i < nlines; i++) {
+            char line[512];
+            char mark = diff_format_entry(&theirs, &mine, &d.entries[lines[scroll + i]],
+                                          line, sizeof(line));
+            ui_set_color(n, mark == '+' ? COL_ACCENT : mark == '-' ? COL_ERROR :
+                            mark == '~' ? COL_WARN : COL_STATUS);
+            ncplane_printf_yx(n, p.y + 2 + i, p.x + 2, "%.*s", content_w, line);
+            ui_reset_color(n);
+        }
+
+        ui_set_color(n, COL_DIM);
+        ncplane_printf_yx(n, p.y + p.h - 2, p.x + 2,
+                          "%zu added, %zu removed, %zu moved, %zu changed, %zu unchanged",
+                          d.added, d.removed, d.moved, d.changed, d.unchanged);
+        ncplane_printf_yx(n, p.y + p.h - 1, p.x + 3, " Esc:Close ");
+        ui_reset_color(n);
+
+        notcurses_render(sm->nc);
+
+        ncinput ni;
+        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
+        if (id == (uint32_t)-1) continue;
+        if (ni.evtype == NCTYPE_RELEASE) continue;
+
+        if (id == NCKEY_ESC || id == 'q' || id == NCKEY_ENTER || id == '\n') break;
+        if (id == NCKEY_UP || id == NCKEY_SCROLL_UP) {
+            if (scroll > 0) scroll--;
+        } else if (id == NCKEY_DOWN || id == NCKEY_SCROLL_DOWN) {
+            if (scroll < nlines - visible) scroll++;
+        } else if (id == NCKEY_PGUP) {
+            scroll -= visible;
+            if (scroll < 0) scroll = 0;
+        } else if (id == NCKEY_PGDOWN) {
+            scroll += visible;
+            if (scroll > nlines - visible) scroll = nlines - visible;
+            if (scroll < 0) scroll = 0;
+        }
+    }
+    set_status(st, "%zu added, %zu removed, %zu moved, %zu changed vs %s",
+               d.added, d.removed, d.moved, d.changed, other);
+    goto out;
+
+oom:
+    set_status(st, "Out of memory comparing rules");
+out:
+    free(lines);
+    rule_diff_free(&d);
+    free(mine.rules); /* borrowed rules: free the array only */
+    free(idx);
+    ruleset_free(&theirs);
+}
+
+static void action_import_json(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+
+    char path[1024] = "";
+    if (!prompt_text(sm, "Import Rules", "JSON file:", path, sizeof(path)) || !path[0])
+        return;
+
+    char *expanded = expand_home(path);
+    FILE *f = fopen(expanded ? expanded : path, "r");
+    free(expanded);
+    if (!f) {
+        set_status(st, "Cannot open %s", path);
+        return;
+    }
+    struct ruleset in;
+    char err[256];
+    int rc = rules_json_read(f, &in, err, sizeof(err));
+    fclose(f);
+    if (rc != 0) {
+        set_status(st, "%s: %s", path, err);
+        return;
+    }
+    if (in.count == 0) {
+        set_status(st, "No rules in %s", path);
+        ruleset_free(&in);
+        return;
+    }
+
+    /* appended after everything else, in file order too */
+    size_t old_n = st->rules.count, k = in.count;
+    int *at = malloc(k * sizeof(int));
+    const struct rule **rules = malloc(k * sizeof(*rules));
+    int ok = at && rules;
+    for (size_t j = 0; ok && j < k; j++) {
+        at[j] = (int)(old_n + j);
+        rules[j] = &in.rules[j];
+    }
+    ok = ok && insert_rules_at(st, at, rules, k) == 0;
+    if (ok) {
+        char desc[64];
+        snprintf(desc, sizeof(desc), "Import %zu rule%s", k, k == 1 ? "" : "s");
+        history_begin_batch(&st->history, desc);
+        for (size_t j = 0; j < k; j++)
+            history_record(&st->history, CHANGE_INSERT, at[j], NULL, rules[j], desc);
+        history_end_batch(&st->history);
+    }
+    free(at);
+    free(rules);
+    ruleset_free(&in);
+    if (!ok) {
+        set_status(st, "Out of memory importing rules");
+        return;
+    }
+
+    /* the imported rules need names and a check against the open windows */
+    unsigned char *recheck = calloc(st->rules.count, 1);
+    if (recheck) memset(recheck + old_n, 1, k);
+    refresh_rule_status(st, recheck);
+    free(recheck);
+    st->edit_gen++;
+    st->modified = 1;
+    set_status(st, "Imported %zu rule%s from %s (not saved to file)", k, k == 1 ? "" : "s", path);
+}
+
+/* ruleset summary, recomputed only after rules or their status changed */
+static const struct rule_stats *ui_stats(struct ui_state *st) {
+    if (st->stats_ok && st->stats_gen == st->status_gen && st->stats_edit == st->edit_gen)
+        return &st->stats;
+    rule_stats_free(&st->stats);
+    st->stats_ok = 0;
+
+    unsigned char *unused = NULL;
+    if (st->rule_status && st->clients.count > 0) {
+        unused = malloc(st->rules.count ? st->rules.count : 1);
+        for (size_t i = 0; unused && i < st->rules.count; i++)
+            unused[i] = st->rule_status[i] == RULE_UNUSED;
+    }
+    int rc = rule_stats_compute(&st->stats, &st->rules, unused);
+    free(unused);
+    if (rc != 0) return NULL;
+    st->stats_gen = st->status_gen;
+    st->stats_edit = st->edit_gen;
+    st->stats_ok = 1;
+    return &st->stats;
+}
+
+/* top entries of one kind; returns the next free row */
+static int draw_stats_section(struct ncplane *n, const struct rule_stats *s, enum stats_kind kind,
+                              const char *title, const char *none, int row, int x, int w, int last) {
+    size_t count = rule_stats_count(s, kind);
+    if (count == 0 || row + 1 >= last) return row;
+    ui_set_color(n, COL_DIM);
+    ncplane_printf_yx(n, row++, x, "%s (%zu)", title, count);
+    ui_reset_color(n);
+    for (size_t i = 0; i < count && row < last; i++) {
+        const struct stats_bucket *b = rule_stats_at(s, kind, i);
+        const char *key = rule_stats_key(s, b);
+        if (i + 1 < count && row + 1 == last) {
+            ui_set_color(n, COL_DIM);
+            ncplane_printf_yx(n, row++, x + 2, "... %zu more", count - i);
+            ui_reset_color(n);
+            break;
+        }
+        ncplane_printf_yx(n, row++, x + 2, "%6zu  %.*s", b->count, w - 12, key[0] ? key : none);
+    }
+    return row + 1;
+}
+
+static void draw_summary_panel(struct ncplane *n, struct ui_state *st, int y, int x, int h, int w) {
+    draw_box(n, y, x, h, w, "Summary");
+    const struct rule_stats *s = ui_stats(st);
+    if (!s) return;
+
+    int row = y + 1;
+    int col = x + 2;
+    int last = y + h - 1;
+    ncplane_on_styles(n, NCSTYLE_BOLD);
+    ncplane_printf_yx(n, row++, col, "%zu rules", s->rules);
+    ncplane_off_styles(n, NCSTYLE_BOLD);
+    if (s->duplicates) {
+        ui_set_color(n, COL_ERROR);
+        ncplane_printf_yx(n, row++, col + 2, "%zu duplicate", s->duplicates);
     }
+    if (s->unused_checked && s->unused) {
+        ui_set_color(n, COL_WARN);
+        ncplane_printf_yx(n, row++, col + 2, "%zu unused", s->unused);
+    }
+    if (s->broken) {
+        ui_set_color(n, COL_ERROR);
+        ncplane_printf_yx(n, row++, col + 2, "%zu with config errors", s->broken);
+    }
+    ui_reset_color(n);
+    row++;
+
+    ui_set_color(n, COL_DIM);
+    ncplane_printf_yx(n, row++, col, "Actions");
+    ui_reset_color(n);
+    for (int a = 0; a < STATS_ACTION_COUNT && row < last; a++) {
+        if (!s->action_set[a]) continue;
+        ncplane_printf_yx(n, row++, col + 2, "%-8s %6zu", stats_action_name((enum stats_action)a),
+                          s->action_set[a]);
+    }
+    row++;
+
+    row = draw_stats_section(n, s, STATS_TAG, "Tags", "(untagged)", row, col, w - 4, last);
+    row = draw_stats_section(n, s, STATS_WORKSPACE, "Workspaces", "(none)", row, col, w - 4, last);
+    draw_stats_section(n, s, STATS_EXTRA, "Other keys", "?", row, col, w - 4, last);
 }
 
 static void draw_actions_view(struct ncplane *n, struct ui_state *st,
                                int y, int h, int w) {
+    /* summary on the right when there is room for both */
+    if (w >= 80) {
+        int list_w = w / 2;
+        draw_summary_panel(n, st, y, list_w, h, w - list_w);
+        w = list_w;
+    }
+
     /* title */
     ui_set_color(n, COL_DIM);
     ncplane_printf_yx(n, y, 2, "Bulk Actions");
@@ -3033,19 +5802,23 @@ static void handle_actions_input(ui_state_machine_t *sm, uint32_t id, ncinput *n
         case 0: action_bulk_rename(sm); break;
         case 1: action_merge_duplicates(sm); break;
         case 2: action_hyprctl_reload(sm); break;
+        case 3: action_diff_file(sm); break;
+        case 4: action_import_json(sm); break;
         default: break;
         }
     }
 }
 
-static void draw_splash(ui_state_machine_t *sm) {
+/* show the logo while the startup workers run; returns once a key has been
+ * pressed and loading has finished, whichever comes last */
+static void draw_splash(ui_state_machine_t *sm, const struct startup_load *sl) {
     struct ncplane *n = sm->std;
     unsigned height, width;
     ncplane_dim_yx(n, &height, &width);
     ncplane_erase(n);
 
-    /* center the logo block: 9 lines logo + 2 blank + subtitle + 1 blank + "hyprwindows" + 1 blank + prompt = ~16 */
-    int total_h = SPLASH_LOGO_LINES + 6;
+    /* center the logo block: 9 lines logo + 1 blank + "hyprwindows" + subtitle + 1 blank + progress + 1 blank + prompt */
+    int total_h = SPLASH_LOGO_LINES + 7;
     int start_y = ((int)height - total_h) / 2;
     if (start_y < 1) start_y = 1;
 
@@ -3075,23 +5848,46 @@ static void draw_splash(ui_state_machine_t *sm) {
     ncplane_set_fg_rgb8(n, 100, 110, 130);
     ncplane_putstr_yx(n, title_y + 1, ((int)width - sub_len) / 2, subtitle);
 
-    /* prompt */
-    const char *prompt = "press any key to continue";
-    int prompt_len = (int)strlen(prompt);
-    ncplane_set_fg_rgb8(n, 80, 90, 110);
-    ncplane_putstr_yx(n, title_y + 3, ((int)width - prompt_len) / 2, prompt);
-
-    ui_reset_color(n);
-    notcurses_render(sm->nc);
+    int frame = 0;
+    int pressed = 0;
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = SPINNER_INTERVAL_MS * 1000000L };
 
-    /* wait for any keypress (ignore mouse and releases) */
     while (1) {
+        int done = startup_load_done(sl);
+        if (done && pressed) break;
+
+        /* progress line */
+        char progress[96];
+        if (done)
+            snprintf(progress, sizeof(progress), "%zu rules, %zu missing apps",
+                     sl->st->rules.count, sl->missing.count);
+        else
+            snprintf(progress, sizeof(progress), "%s %s rules  %s apps",
+                     spinner_frames[frame % SPINNER_NFRAMES],
+                     startup_rules_done(sl) ? "\u2713" : "loading",
+                     startup_apps_done(sl) ? "\u2713" : "scanning");
+        ui_fill_row(n, title_y + 3, 0, (int)width, ' ');
+        ncplane_set_fg_rgb8(n, 100, 110, 130);
+        ncplane_putstr_yx(n, title_y + 3, ((int)width - ncstrwidth(progress, NULL, NULL)) / 2, progress);
+
+        /* prompt */
+        const char *prompt = pressed ? "starting..." : "press any key to continue";
+        int prompt_len = (int)strlen(prompt);
+        ui_fill_row(n, title_y + 5, 0, (int)width, ' ');
+        ncplane_set_fg_rgb8(n, 80, 90, 110);
+        ncplane_putstr_yx(n, title_y + 5, ((int)width - prompt_len) / 2, prompt);
+
+        ui_reset_color(n);
+        notcurses_render(sm->nc);
+
+        /* wait for any keypress (ignore mouse and releases), polling while loading */
         ncinput ni;
-        uint32_t id = notcurses_get(sm->nc, NULL, &ni);
-        if (id == (uint32_t)-1) continue;
+        uint32_t id = notcurses_get(sm->nc, done ? NULL : &ts, &ni);
+        frame++;
+        if (id == 0 || id == (uint32_t)-1) continue;
         if (ni.evtype == NCTYPE_RELEASE) continue;
         if (nckey_mouse_p(id)) continue;
-        break;
+        pressed = 1;
     }
 }
 
@@ -3147,10 +5943,14 @@ static void draw_ui(ui_state_machine_t *sm) {
     const char *help = "F1:Help";
     switch (sm->current_state) {
     case VIEW_RULES:
-        help = "Enter:Edit  /:Find  s:Sort  ^S:Save  F1:Help";
+        help = st->marked_count > 0
+            ? "Space:Mark  V:Range  b:Bulk  c:Clear  F1:Help"
+            : "Enter:Edit  /:Find  s:Sort  t:Group  w:What-if  ^S:Save  F1:Help";
         break;
     case VIEW_WINDOWS:
-        help = "Enter:Details  r:Reload  F1:Help";
+        help = st->win_filter_editing
+            ? "Type to filter  Enter:Done  Esc:Clear"
+            : "Enter:Details  w:What-if  s:Sort  /:Filter  g:Group  F1:Help";
         break;
     case VIEW_REVIEW:
         help = "Enter:Details/Create  r:Reload  F1:Help";
@@ -3181,9 +5981,22 @@ static void help_popup(ui_state_machine_t *sm) {
         "  x              Disable rule",
         "  /              Search rules",
         "  s              Cycle sort mode",
+        "  w              What-if simulator",
+        "  a              Apply to open windows",
+        "  t              Group by tag / workspace / off",
+        "  Left/Right     Fold / unfold group",
+        "  Space          Mark / unmark rule",
+        "  V              Mark range to cursor",
+        "  c              Clear marks",
+        "  b              Bulk actions on marked",
+        "  Ctrl+A         Mark all (in search)",
         "",
         "Windows View",
-        "  Enter          Show window details",
+        "  Enter          Show window details / fold group",
+        "  w              Simulate this window",
+        "  s              Cycle sort (class, title, ...)",
+        "  /              Filter as you type (Esc clears)",
+        "  g              Group by workspace",
         "",
         "Review View",
         "  Enter          Details / create rule",
@@ -3283,9 +6096,7 @@ static void handle_global_keys(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
 
             if (choice == 0) {
                 if (!st->backup_created) create_backup(st);
-                if (save_rules(st) == 0) {
-                    set_status(st, "Saved to %s", st->rules_path);
-                }
+                if (save_rules_merged(sm) != 0) return;
                 sm->running = 0;
             } else if (choice == 1) {
                 sm->running = 0;
@@ -3304,11 +6115,7 @@ static void handle_global_keys(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
                     set_status(st, "Backup created: %s", st->backup_path);
                 }
             }
-            if (save_rules(st) == 0) {
-                set_status(st, "Saved %zu rules to %s", st->rules.count, st->rules_path);
-            } else {
-                set_status(st, "Failed to save rules");
-            }
+            save_rules_merged(sm);
         } else {
             set_status(st, "No changes to save");
         }
@@ -3331,6 +6138,17 @@ static void handle_global_keys(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
     if (id == '4') { sm->current_state = VIEW_ACTIONS; st->selected = 0; st->scroll = 0; return; }
 
     if (id == 'r' || id == 'R') {
+        if (st->modified && rules_file_changed(st)) {
+            /* keep unsaved work: pull the disk changes in instead */
+            int taken = merge_with_disk(sm);
+            if (taken < 0) return;
+            ncplane_erase(sm->std);
+            run_with_spinner(sm, "Scanning apps...", -1, -1,
+                             (void (*)(void *))load_review_data, st);
+            set_status(st, "Merged %d change%s from disk; unsaved edits kept",
+                       taken, taken == 1 ? "" : "s");
+            return;
+        }
         if (st->modified) {
             if (!confirm_dialog(sm, "Reload", "Discard unsaved changes?")) {
                 return;
@@ -3350,28 +6168,77 @@ static void handle_global_keys(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
     }
 }
 
+/* move the rules view cursor by delta rows, over the flat list or the tree */
+static void rules_cursor_move(struct ui_state *st, int delta) {
+    if (st->tree.key != TREE_OFF && rule_tree_get(st)) {
+        rule_tree_set_cursor(st, rule_tree_cursor(st) + delta);
+        return;
+    }
+    int sel = st->selected + delta;
+    if (sel >= (int)st->rules.count) sel = (int)st->rules.count - 1;
+    if (sel < 0) sel = 0;
+    st->selected = sel;
+}
+
+/* tree-only keys; returns 1 when the key was consumed */
+static int handle_rules_tree_keys(struct ui_state *st, uint32_t id) {
+    const struct rule_tree *t = rule_tree_get(st);
+    if (!t) return 0;
+    int g = rule_tree_header(st);
+    if ((id == NCKEY_ENTER || id == '\n' || id == ' ') && g >= 0) {
+        rule_tree_fold(st, g, !t->groups[g].collapsed);
+        return 1;
+    }
+    if (id == NCKEY_LEFT) {
+        if (g < 0 && st->selected >= 0 && st->selected < (int)t->slot_count)
+            g = t->slots[st->selected].group;
+        rule_tree_fold(st, g, 1);
+        return 1;
+    }
+    if (id == NCKEY_RIGHT) {
+        rule_tree_fold(st, g, 0);
+        return 1;
+    }
+    /* a header is not a rule: nothing to delete, disable or apply */
+    if (g >= 0 && (id == 'V' || id == 'a' ||
+                   ((id == 'd' || id == NCKEY_DEL || id == 'x') && st->marked_count == 0)))
+        return 1;
+    return 0;
+}
+
 static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni) {
     struct ui_state *st = sm->st;
 
-    if (id == NCKEY_UP && st->selected > 0) st->selected--;
-    else if (id == NCKEY_DOWN && st->selected < (int)st->rules.count - 1) st->selected++;
-    else if (id == NCKEY_PGUP) { st->selected -= 10; if (st->selected < 0) st->selected = 0; }
-    else if (id == NCKEY_PGDOWN) { st->selected += 10; if (st->selected >= (int)st->rules.count) st->selected = (int)st->rules.count - 1; }
-    else if (id == NCKEY_HOME) st->selected = 0;
-    else if (id == NCKEY_END) st->selected = (int)st->rules.count - 1;
+    if (st->tree.key != TREE_OFF && handle_rules_tree_keys(st, id)) return;
+
+    if (id == NCKEY_UP) rules_cursor_move(st, -1);
+    else if (id == NCKEY_DOWN) rules_cursor_move(st, 1);
+    else if (id == NCKEY_PGUP) rules_cursor_move(st, -10);
+    else if (id == NCKEY_PGDOWN) rules_cursor_move(st, 10);
+    else if (id == NCKEY_HOME) rules_cursor_move(st, -INT_MAX / 2);
+    else if (id == NCKEY_END) rules_cursor_move(st, INT_MAX / 2);
     else if (id == '/') {
         struct search_state search;
         search_init(&search, st->rules.count);
+        snprintf(search.query, sizeof(search.query), "%s", st->search_query);
+        search_update(&search, &st->rules);
         int result = search_modal(sm, &search, &st->rules);
+        snprintf(st->search_query, sizeof(st->search_query), "%s", search.query);
         if (result >= 0) {
             st->selected = result;
+        } else if (result == -2) {
+            for (size_t i = 0; i < search.match_count; i++)
+                mark_rule(st, search.matches[i], 1);
+            st->selected = search.matches[0];
+            set_status(st, "Marked %zu matches (%zu marked)", search.match_count, st->marked_count);
         }
         search_free(&search);
     }
     else if ((id == NCKEY_ENTER || id == '\n') && st->selected >= 0 && st->selected < (int)st->rules.count) {
         if (edit_rule_modal(sm, &st->rules.rules[st->selected], st->selected, &st->history)) {
             st->modified = 1;
-            if (st->rule_modified) st->rule_modified[st->selected] = 1;
+            st->rules.rules[st->selected].flags &= (uint8_t)~RULE_F_BROKEN;
+            mark_rule_modified(st, st->selected);
             set_status(st, "Rule modified (not saved to file)");
         }
     }
@@ -3384,12 +6251,13 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
             if (edit_rule_modal(sm, &st->rules.rules[new_idx], new_idx, &st->history)) {
                 update_display_name(&st->rules.rules[new_idx]);
                 st->modified = 1;
-                if (st->rule_modified) st->rule_modified[new_idx] = 1;
+                mark_rule_modified(st, new_idx);
                 set_status(st, "New rule added (not saved to file)");
             } else {
                 /* user cancelled -- remove the empty rule */
                 rule_free(&st->rules.rules[new_idx]);
                 st->rules.count--;
+                st->status_gen++;
                 if (st->selected >= (int)st->rules.count && st->selected > 0)
                     st->selected--;
             }
@@ -3397,11 +6265,48 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
             set_status(st, "Failed to allocate new rule");
         }
     }
+    /* mark / unmark rule */
+    else if (id == ' ' && st->selected >= 0 && st->selected < (int)st->rules.count) {
+        mark_rule(st, st->selected, !(st->rule_marked && st->rule_marked[st->selected]));
+        st->mark_anchor = st->selected;
+        if (st->selected < (int)st->rules.count - 1) st->selected++;
+    }
+    /* mark range from the last marked row to the cursor */
+    else if (id == 'V' && st->selected >= 0 && st->selected < (int)st->rules.count) {
+        int a = st->mark_anchor >= 0 && st->mark_anchor < (int)st->rules.count ? st->mark_anchor : st->selected;
+        int lo = a < st->selected ? a : st->selected;
+        int hi = a < st->selected ? st->selected : a;
+        for (int i = lo; i <= hi; i++) mark_rule(st, i, 1);
+        st->mark_anchor = st->selected;
+        set_status(st, "%zu rules marked", st->marked_count);
+    }
+    else if (id == 'c' && st->marked_count > 0) {
+        clear_marks(st);
+        set_status(st, "Marks cleared");
+    }
+    else if (id == 'b') {
+        if (st->marked_count > 0) bulk_actions_popup(sm);
+        else set_status(st, "No rules marked (Space to mark)");
+    }
+    /* delete / disable marked rules */
+    else if ((id == 'd' || id == NCKEY_DEL || id == 'x') && st->marked_count > 0) {
+        char msg[64];
+        int disable = id == 'x';
+        snprintf(msg, sizeof(msg), "%s %zu marked rules?", disable ? "Disable" : "Delete", st->marked_count);
+        if (confirm_dialog(sm, disable ? "Disable Rules" : "Delete Rules", msg)) {
+            if (disable) {
+                bulk_disable(st);
+            } else {
+                int removed = bulk_delete(st, "Delete");
+                set_status(st, "Deleted %d rule%s (not saved to file)", removed, removed == 1 ? "" : "s");
+            }
+        }
+    }
     /* delete rule */
     else if ((id == 'd' || id == NCKEY_DEL) && st->selected >= 0 && st->selected < (int)st->rules.count) {
         struct rule *r = &st->rules.rules[st->selected];
         char msg[64];
-        snprintf(msg, sizeof(msg), "Delete rule '%s'?", r->name ? r->name : "(unnamed)");
+        snprintf(msg, sizeof(msg), "Delete rule '%s'?", rule_get_or(r, RF_NAME, "(unnamed)"));
         if (confirm_dialog(sm, "Delete Rule", msg)) {
             delete_rule_with_history(st, st->selected, "Delete");
             if (st->selected >= (int)st->rules.count && st->selected > 0) st->selected--;
@@ -3412,7 +6317,7 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
     else if (id == 'x' && st->selected >= 0 && st->selected < (int)st->rules.count) {
         struct rule *r = &st->rules.rules[st->selected];
         char msg[64];
-        snprintf(msg, sizeof(msg), "Disable rule '%s'?", r->name ? r->name : "(unnamed)");
+        snprintf(msg, sizeof(msg), "Disable rule '%s'?", rule_get_or(r, RF_NAME, "(unnamed)"));
         if (confirm_dialog(sm, "Disable Rule", msg)) {
             char disabled_path[512];
             char *expanded = expand_home(st->rules_path);
@@ -3438,7 +6343,16 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
     }
     /* Ctrl+Z undo */
     else if (((id == 'z' || id == 'Z') && ncinput_ctrl_p(ni)) || id == 0x1a) {
-        if (history_can_undo(&st->history)) {
+        const struct change_record *batch = history_peek_undo(&st->history);
+        if (batch && batch->type == CHANGE_BATCH) {
+            history_undo(&st->history, NULL, NULL);
+            if (apply_batch(st, batch, 1) == 0) {
+                set_status(st, "Undo: %s", batch->description);
+            } else {
+                history_redo(&st->history, NULL, NULL); /* keep it on the undo stack */
+                set_status(st, "Out of memory, nothing undone");
+            }
+        } else if (history_can_undo(&st->history)) {
             int rule_index = -1;
             enum change_type ctype = CHANGE_EDIT;
             struct rule *old_rule = history_undo(&st->history, &rule_index, &ctype);
@@ -3459,7 +6373,7 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
                     old_rule = NULL; /* ownership transferred */
                     st->selected = rule_index;
                     st->modified = 1;
-                    if (st->rule_modified) st->rule_modified[rule_index] = 1;
+                    mark_rule_modified(st, rule_index);
                     compute_rule_status(st);
                     set_status(st, "Undo complete");
                 }
@@ -3472,7 +6386,16 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
     }
     /* Ctrl+Y redo */
     else if (((id == 'y' || id == 'Y') && ncinput_ctrl_p(ni)) || id == 0x19) {
-        if (history_can_redo(&st->history)) {
+        const struct change_record *batch = history_peek_redo(&st->history);
+        if (batch && batch->type == CHANGE_BATCH) {
+            history_redo(&st->history, NULL, NULL);
+            if (apply_batch(st, batch, 0) == 0) {
+                set_status(st, "Redo: %s", batch->description);
+            } else {
+                history_undo(&st->history, NULL, NULL); /* keep it on the redo stack */
+                set_status(st, "Out of memory, nothing redone");
+            }
+        } else if (history_can_redo(&st->history)) {
             int rule_index = -1;
             enum change_type ctype = CHANGE_EDIT;
             struct rule *redo_rule = history_redo(&st->history, &rule_index, &ctype);
@@ -3495,7 +6418,7 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
                     st->rules.rules[rule_index] = *redo_rule;
                     st->selected = rule_index;
                     st->modified = 1;
-                    if (st->rule_modified) st->rule_modified[rule_index] = 1;
+                    mark_rule_modified(st, rule_index);
                     compute_rule_status(st);
                     set_status(st, "Redo complete");
                     free(redo_rule);
@@ -3505,28 +6428,78 @@ static void handle_rules_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni)
             set_status(st, "Nothing to redo");
         }
     }
+    /* what-if simulator */
+    else if (id == 'w' || id == 'W') {
+        whatif_popup(sm, NULL);
+    }
+    /* apply to open windows */
+    else if (id == 'a' && st->selected >= 0 && st->selected < (int)st->rules.count) {
+        apply_rules_live(sm);
+    }
     /* cycle sort mode */
     else if (id == 's') {
         st->sort_mode = (st->sort_mode + 1) % SORT_MODE_COUNT;
         apply_sort(st);
         st->selected = 0;
         st->scroll = 0;
+        st->mark_anchor = -1;
         set_status(st, "Sort: %s", sort_mode_label(st->sort_mode));
     }
+    /* cycle tree grouping */
+    else if (id == 't') {
+        enum tree_key key = (enum tree_key)((st->tree.key + 1) % TREE_KEY_COUNT);
+        rule_tree_free(&st->tree);
+        st->tree.key = key;
+        st->scroll = 0;
+        set_status(st, "Group: %s", tree_key_label(key));
+    }
+}
+
+/* typing into the windows filter; every key narrows or widens the list */
+static void handle_windows_filter_input(struct ui_state *st, uint32_t id) {
+    int client = win_selected_client(st);
+    size_t len = strlen(st->win_filter);
+    if (id == NCKEY_ENTER || id == '\n') {
+        st->win_filter_editing = 0;
+    } else if (id == NCKEY_ESC || id == 27) {
+        st->win_filter_editing = 0;
+        st->win_filter[0] = '\0';
+    } else if (id == NCKEY_BACKSPACE || id == 127 || id == 8) {
+        if (len > 0) st->win_filter[len - 1] = '\0';
+    } else if (id >= 32 && id < 127 && len + 1 < sizeof(st->win_filter)) {
+        st->win_filter[len] = (char)id;
+        st->win_filter[len + 1] = '\0';
+    } else if (id == NCKEY_UP || id == NCKEY_DOWN) {
+        st->win_filter_editing = 0;
+        return;
+    } else {
+        return;
+    }
+    win_reselect(st, client);
 }
 
 static void handle_windows_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni) {
     struct ui_state *st = sm->st;
     (void)ni;
+    if (st->win_filter_editing) {
+        handle_windows_filter_input(st, id);
+        if (st->win_filter_editing) return;
+        if (id != NCKEY_UP && id != NCKEY_DOWN) return;
+    }
     if (id == NCKEY_UP && st->selected > 0) st->selected--;
     else if (id == NCKEY_DOWN) st->selected++;
     else if (id == NCKEY_PGUP) { st->selected -= 10; if (st->selected < 0) st->selected = 0; }
     else if (id == NCKEY_PGDOWN) st->selected += 10;
     else if (id == NCKEY_HOME) st->selected = 0;
     else if (id == NCKEY_END) st->selected = 9999; /* clamped in draw */
-    else if (id == NCKEY_ENTER || id == '\n') {
-        if (st->clients_loaded && st->selected < (int)st->clients.count) {
-            int jump = window_detail_popup(sm, &st->clients.items[st->selected], &st->rules);
+    else if (id == NCKEY_ENTER || id == '\n' || id == ' ') {
+        const struct window_index *wi = window_index_get(st);
+        if (st->selected < 0 || st->selected >= wi->row_count) return;
+        int ci = wi->rows[st->selected];
+        if (ci < 0) {
+            win_toggle_collapsed(st, wi->groups[-1 - ci].ws_id);
+        } else if (id != ' ') {
+            int jump = window_detail_popup(sm, &st->clients.items[ci], &st->rules);
             if (jump >= 0 && jump < (int)st->rules.count) {
                 /* jump to the selected rule in the rules view */
                 sm->current_state = VIEW_RULES;
@@ -3535,8 +6508,44 @@ static void handle_windows_input(ui_state_machine_t *sm, uint32_t id, ncinput *n
             }
         }
     }
+    else if (id == 'w' || id == 'W') {
+        int ci = win_selected_client(st);
+        whatif_popup(sm, ci >= 0 ? &st->clients.items[ci] : NULL);
+    }
+    else if (id == 's') {
+        int client = win_selected_client(st);
+        st->win_sort = (enum win_sort)((st->win_sort + 1) % WSORT_COUNT);
+        win_reselect(st, client);
+        set_status(st, "Windows sorted by %s", win_sort_names[st->win_sort]);
+    }
+    else if (id == 'g') {
+        int client = win_selected_client(st);
+        st->win_group = !st->win_group;
+        win_reselect(st, client);
+        set_status(st, st->win_group ? "Grouped by workspace" : "Workspace groups off");
+    }
+    else if (id == '/') {
+        st->win_filter_editing = 1;
+    }
+    else if ((id == NCKEY_ESC || id == 27) && st->win_filter[0]) {
+        int client = win_selected_client(st);
+        st->win_filter[0] = '\0';
+        win_reselect(st, client);
+    }
     else if (id == 'r' || id == 'R') {
+        /* indices move on a refresh; the selected window is found by address */
+        int client = win_selected_client(st);
+        char *addr = client >= 0 && st->clients.items[client].address ?
+                     strdup(st->clients.items[client].address) : NULL;
         st->clients_loaded = 0;
+        load_clients(st);
+        client = -1;
+        for (size_t i = 0; addr && i < st->clients.count && client < 0; i++) {
+            const char *a = st->clients.items[i].address;
+            if (a && strcmp(a, addr) == 0) client = (int)i;
+        }
+        free(addr);
+        win_reselect(st, client);
         set_status(st, "Refreshed windows");
     }
 }
@@ -3591,6 +6600,12 @@ static void handle_review_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni
 }
 
 static void handle_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni) {
+    /* the windows filter takes every key while it is being typed */
+    if (sm->current_state == VIEW_WINDOWS && sm->st->win_filter_editing) {
+        handle_windows_input(sm, id, ni);
+        return;
+    }
+
     /* global keys first (handles q, Ctrl+S, Ctrl+B, 1/2/3, r) */
     handle_global_keys(sm, id, ni);
 
@@ -3613,15 +6628,116 @@ static void handle_input(ui_state_machine_t *sm, uint32_t id, ncinput *ni) {
     }
 }
 
+/* --- session --- */
+
+/* view settings go in before the rules load, so the first sort is the
+ * restored one */
+static void session_apply_settings(struct ui_state *st) {
+    struct session *s = &st->session;
+    char *path = session_path();
+    int loaded = session_load(path, s) == 0;
+    free(path);
+    if (!loaded) return;
+    if (s->sort_mode >= 0 && s->sort_mode < SORT_MODE_COUNT)
+        st->sort_mode = (enum sort_mode)s->sort_mode;
+    if (s->tree_key >= 0 && s->tree_key < TREE_KEY_COUNT)
+        st->tree.key = (enum tree_key)s->tree_key;
+    if (s->win_sort >= 0 && s->win_sort < WSORT_COUNT)
+        st->win_sort = (enum win_sort)s->win_sort;
+    st->win_group = s->win_group != 0;
+    snprintf(st->win_filter, sizeof(st->win_filter), "%s", s->win_filter);
+    snprintf(st->search_query, sizeof(st->search_query), "%s", s->search);
+}
+
+/* once the rules are in: select the rule that was selected last time */
+static void session_apply_selection(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    struct session *s = &st->session;
+    if (s->view >= VIEW_RULES && s->view <= VIEW_ACTIONS)
+        sm->current_state = (enum view_mode)s->view;
+    /* other views reuse st->selected for their own rows */
+    if (sm->current_state != VIEW_RULES || !s->selected || st->rules.count == 0 ||
+        strcmp(s->rules_path, st->rules_path) != 0)
+        return;
+    uint64_t *keys = malloc(st->rules.count * sizeof(uint64_t));
+    if (keys && merge_identities(&st->rules, keys) == 0) {
+        for (size_t i = 0; i < st->rules.count; i++) {
+            if (keys[i] != s->selected) continue;
+            st->selected = (int)i;
+            break;
+        }
+    }
+    free(keys);
+}
+
+static void session_store(ui_state_machine_t *sm) {
+    struct ui_state *st = sm->st;
+    struct session s;
+    memset(&s, 0, sizeof(s));
+    snprintf(s.rules_path, sizeof(s.rules_path), "%s", st->rules_path);
+    s.view = sm->current_state;
+    s.sort_mode = st->sort_mode;
+    s.tree_key = st->tree.key;
+    s.win_sort = st->win_sort;
+    s.win_group = st->win_group;
+    snprintf(s.search, sizeof(s.search), "%s", st->search_query);
+    snprintf(s.win_filter, sizeof(s.win_filter), "%s", st->win_filter);
+
+    size_t n = st->rules.count;
+    uint64_t *keys = n && sm->current_state == VIEW_RULES ? malloc(n * sizeof(uint64_t)) : NULL;
+    if (keys && st->selected >= 0 && (size_t)st->selected < n &&
+        merge_identities(&st->rules, keys) == 0)
+        s.selected = keys[st->selected];
+    free(keys);
+
+    /* status goes out in file order, and only when it describes the file */
+    int *inv = n && st->rule_status && st->file_order && !st->modified &&
+               !st->scan.running && !st->scan.wanted ? malloc(n * sizeof(int)) : NULL;
+    s.status = inv ? malloc(n) : NULL;
+    if (s.status) {
+        for (size_t i = 0; i < n; i++) inv[i] = -1;
+        for (size_t i = 0; i < n && s.status; i++) {
+            int f = st->file_order[i];
+            if (f < 0 || (size_t)f >= n || inv[f] >= 0) {
+                free(s.status);
+                s.status = NULL;
+                break;
+            }
+            inv[f] = (int)i;
+            s.status[f] = st->rule_status[i] == RULE_DUPLICATE ? SESSION_DUPLICATE :
+                          st->rule_status[i] == RULE_UNUSED ? SESSION_UNUSED : SESSION_OK;
+        }
+    }
+    if (s.status) {
+        s.status_count = n;
+        s.rules_hash = session_rules_hash(&st->rules, inv);
+        /* windows reloaded since the check leave only the duplicates usable */
+        if (st->status_clients_gen == st->clients_gen)
+            s.clients_hash = session_clients_hash(&st->clients);
+    }
+    free(inv);
+
+    char *path = session_path();
+    session_save(path, &s);
+    free(path);
+    session_free(&s);
+}
+
 /* --- main entry --- */
 
-int run_tui(void) {
+int run_tui(int splash) {
     struct ui_state st;
     memset(&st, 0, sizeof(st));
     history_init(&st.history);
+    snapshot_domain_init(&st.snaps);
     init_paths(&st);
 
     setlocale(LC_ALL, "");
+    session_apply_settings(&st);
+
+    /* start loading before the terminal is even set up */
+    struct startup_load sl;
+    startup_load_begin(&sl, &st);
 
     /* save original terminal settings before notcurses changes them */
     struct termios tios_orig;
@@ -3636,6 +6752,7 @@ int run_tui(void) {
     struct notcurses *nc = notcurses_core_init(&opts, NULL);
     if (!nc) {
         fprintf(stderr, "Failed to initialize notcurses\n");
+        startup_load_finish(&sl);
         return -1;
     }
 
@@ -3658,19 +6775,19 @@ int run_tui(void) {
     sm.nc = nc;
     sm.std = std;
 
-    draw_splash(&sm);
-    ncplane_erase(std);
-    run_with_spinner(&sm, "Loading rules...", -1, -1,
-                     (void (*)(void *))load_rules, &st);
+    if (splash) draw_splash(&sm, &sl);
+    startup_load_finish(&sl);
+    session_apply_selection(&sm);
     ncplane_erase(std);
-    run_with_spinner(&sm, "Scanning apps...", -1, -1,
-                     (void (*)(void *))load_review_data, &st);
 
     while (sm.running) {
+        status_scan_poll(&st);
         draw_ui(&sm);
 
         ncinput ni;
-        uint32_t id = notcurses_get(nc, NULL, &ni);
+        struct timespec frame = { .tv_sec = 0, .tv_nsec = PREVIEW_FRAME_NS };
+        uint32_t id = notcurses_get(nc, st.scan.running ? &frame : NULL, &ni);
+        if (id == 0) continue; /* timeout: pick up the scan result */
         if (id == (uint32_t)-1) continue;
         if (ni.evtype == NCTYPE_RELEASE) continue;
 
@@ -3685,6 +6802,27 @@ int run_tui(void) {
                    single click as select */
                 int content_y = 2;
                 int list_row = ni.y - content_y - 2;
+                const struct rule_tree *tree = rule_tree_get(&st);
+                if (tree && list_row >= 0 && ni.x > 0 && ni.x < (int)width * 2 / 3) {
+                    /* headers fold on click; rules fall through to select / edit */
+                    int drow = st.scroll + list_row;
+                    if (drow < tree->row_count && tree->rows[drow] < 0) {
+                        int g = -1 - tree->rows[drow];
+                        if (rule_tree_header(&st) == g)
+                            rule_tree_fold(&st, g, !tree->groups[g].collapsed);
+                        else
+                            rule_tree_set_cursor(&st, drow);
+                        list_row = -1;
+                    } else if (drow < tree->row_count && rule_tree_header(&st) >= 0) {
+                        st.tree.header = -1;
+                        st.selected = tree->rows[drow];
+                        list_row = -1;
+                    } else if (drow < tree->row_count) {
+                        list_row = tree->rows[drow] - st.scroll;
+                    } else {
+                        list_row = -1;
+                    }
+                }
                 if (list_row >= 0 && ni.x > 0 && ni.x < (int)width * 2 / 3) {
                     int clicked_idx = st.scroll + list_row;
                     if (clicked_idx >= 0 && clicked_idx < (int)st.rules.count) {
@@ -3692,6 +6830,8 @@ int run_tui(void) {
                             /* second click on same row = edit */
                             if (edit_rule_modal(&sm, &st.rules.rules[st.selected], st.selected, &st.history)) {
                                 st.modified = 1;
+                                st.rules.rules[st.selected].flags &= (uint8_t)~RULE_F_BROKEN;
+                                mark_rule_modified(&st, st.selected);
                                 set_status(&st, "Rule modified (not saved to file)");
                             }
                         } else {
@@ -3712,11 +6852,11 @@ int run_tui(void) {
                 }
             }
             else if (id == NCKEY_SCROLL_UP) {
-                if (sm.current_state == VIEW_RULES && st.selected > 0) st.selected--;
+                if (sm.current_state == VIEW_RULES) rules_cursor_move(&st, -1);
                 else if (sm.current_state == VIEW_WINDOWS && st.scroll > 0) st.scroll--;
             }
             else if (id == NCKEY_SCROLL_DOWN) {
-                if (sm.current_state == VIEW_RULES && st.selected < (int)st.rules.count - 1) st.selected++;
+                if (sm.current_state == VIEW_RULES) rules_cursor_move(&st, 1);
                 else if (sm.current_state == VIEW_WINDOWS) st.scroll++;
             }
             continue;
@@ -3728,12 +6868,26 @@ int run_tui(void) {
     notcurses_stop(nc);
     if (tios_saved)
         tcsetattr(STDIN_FILENO, TCSANOW, &tios_orig);
+    status_scan_stop(&st);  /* the worker reads rules and clients */
+    session_store(&sm);
+    session_free(&st.session);
     ruleset_free(&st.rules);
     free(st.rule_status);
     free(st.rule_modified);
     free(st.file_order);
+    free(st.rule_marked);
     clients_free(&st.clients);
     missing_rules_free(&st.missing);
+    appmap_free(&st.appmap);
+    snapshot_domain_free(&st.snaps);
+    review_index_free(&st.review);
+    rule_tree_free(&st.tree);
+    rule_stats_free(&st.stats);
+    window_index_free(&st.windex);
+    free(st.win_collapsed);
+    match_set_free(&st.matchers);
+    config_errors_free(&st.cfg_errors);
+    merge_base_free(&st.base);
     history_free(&st.history);
 
     return 0;
@@ -1,6 +1,7 @@
 #ifndef HYPRWINDOWS_UI_H
 #define HYPRWINDOWS_UI_H
 
-int run_tui(void);
+/* splash: show the logo while loading (0 = go straight to the UI) */
+int run_tui(int splash);
 
 #endif
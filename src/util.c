@@ -1,71 +1,11 @@
 #include "util.h"
 
 #include <ctype.h>
-#include <regex.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
-/* --- regex cache for performance --- */
-
-#define REGEX_CACHE_SIZE 64
-
-struct regex_entry {
-    char *pattern;
-    regex_t compiled;
-    int valid;
-};
-
-static struct regex_entry regex_cache[REGEX_CACHE_SIZE];
-static size_t regex_cache_next;  /* circular index */
-
-static regex_t *cache_get(const char *pattern) {
-    for (size_t i = 0; i < REGEX_CACHE_SIZE; i++) {
-        if (regex_cache[i].valid && regex_cache[i].pattern &&
-            strcmp(regex_cache[i].pattern, pattern) == 0) {
-            return &regex_cache[i].compiled;
-        }
-    }
-    return NULL;
-}
-
-static regex_t *cache_put(const char *pattern) {
-    struct regex_entry *e = &regex_cache[regex_cache_next];
-    regex_cache_next = (regex_cache_next + 1) % REGEX_CACHE_SIZE;
-
-    /* evict old entry */
-    if (e->valid) {
-        regfree(&e->compiled);
-        free(e->pattern);
-        e->valid = 0;
-    }
-
-    int rc = regcomp(&e->compiled, pattern, REG_EXTENDED | REG_NOSUB | REG_ICASE);
-    if (rc != 0) {
-        return NULL;
-    }
-    e->pattern = strdup(pattern);
-    if (!e->pattern) {
-        regfree(&e->compiled);
-        return NULL;
-    }
-    e->valid = 1;
-    return &e->compiled;
-}
-
-int regex_match(const char *pattern, const char *text) {
-    if (!pattern || !text) {
-        return 0;
-    }
-    regex_t *re = cache_get(pattern);
-    if (!re) {
-        re = cache_put(pattern);
-        if (!re) return 0;
-    }
-    return regexec(re, text, 0, NULL, 0) == 0;
-}
-
 /* --- string utilities --- */
 
 void str_to_lower_inplace(char *s) {
@@ -134,3 +74,22 @@ char *expand_home(const char *path) {
     out[hlen + plen - 1] = '\0';
     return out;
 }
+
+/* --- JSON output --- */
+
+void json_put_string(FILE *f, const char *s) {
+    fputc('"', f);
+    const unsigned char *run = (const unsigned char *)s;
+    for (const unsigned char *p = run; *p; p++) {
+        if (*p >= 0x20 && *p != '"' && *p != '\\') continue;
+        /* plain bytes go out in one piece */
+        fwrite(run, 1, (size_t)(p - run), f);
+        run = p + 1;
+        if (*p == '"' || *p == '\\') fprintf(f, "\\%c", *p);
+        else if (*p == '\n') fputs("\\n", f);
+        else if (*p == '\t') fputs("\\t", f);
+        else fprintf(f, "\\u%04x", *p);
+    }
+    fputs((const char *)run, f);
+    fputc('"', f);
+}
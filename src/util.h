@@ -2,9 +2,7 @@
 #define HYPRWINDOWS_UTIL_H
 
 #include <stddef.h>
-
-/* regex matching (with optional caching) */
-int regex_match(const char *pattern, const char *text);
+#include <stdio.h>
 
 /* string utilities */
 void str_to_lower_inplace(char *s);
@@ -13,4 +11,7 @@ void str_to_lower_inplace(char *s);
 char *read_file(const char *path, size_t *out_len);
 char *expand_home(const char *path);
 
+/* JSON output: s as a quoted, escaped string */
+void json_put_string(FILE *f, const char *s);
+
 #endif
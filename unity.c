@@ -1,10 +1,26 @@
 /* Unity build — single translation unit for hyprwindows */
+
+/* before any system header: wcwidth, strcasestr, open_memstream, ... */
+#define _GNU_SOURCE
+
 #include "src/util.c"
+#include "src/textwidth.c"
+#include "src/scan.c"
 #include "src/rules.c"
 #include "src/hyprconf.c"
+#include "src/merge.c"
+#include "src/diff.c"
+#include "src/stats.c"
+#include "src/session.c"
+#include "src/rulesjson.c"
+#include "src/snapshot.c"
 #include "src/hyprctl.c"
+#include "src/match.c"
+#include "src/lint.c"
 #include "src/appmap.c"
 #include "src/history.c"
+#include "src/preview.c"
+#include "src/simulate.c"
 #include "src/actions.c"
 #include "src/ui.c"
 #include "src/main.c"